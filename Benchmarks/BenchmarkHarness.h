@@ -0,0 +1,137 @@
+#pragma once
+// Minimal benchmark harness: no dependency beyond the standard library, so the suite builds wherever the app does.
+// A benchmark is a factory: it gets the generated dataset, does its untimed setup (build an index, format a text log)
+// and returns the closure to time. Each closure returns a value derived from its result so the work cannot be
+// optimized away. Runs repeat until minSeconds have passed; the median run is reported, as events/s and
+// allocated bytes/event (the global operator new in Benchmarks.cpp feeds AllocationCounters).
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "EventColumnStore.h"
+#include "EventGenerator.h"
+#include "SimulationEvent.h"
+
+struct AllocationCounters
+{
+    std::atomic<std::uint64_t> allocations{};
+    std::atomic<std::uint64_t> bytes{};
+};
+
+inline AllocationCounters& GlobalAllocations()
+{
+    static AllocationCounters counters{};
+    return counters;
+}
+
+// The log every benchmark of one size runs on. `events` is empty above the vector cap; those benchmarks are skipped.
+struct BenchmarkData
+{
+    EventGeneratorOptions options{};
+    EventColumnStore store{};
+    std::vector<SimulationEvent> events{};
+};
+
+struct BenchmarkRun
+{
+    std::function<std::uint64_t()> body;
+    std::size_t items{};                    // work items per run; 0 means one per event of the dataset
+};
+
+struct Benchmark
+{
+    std::string name;                       // "group/what"
+    std::function<BenchmarkRun(const BenchmarkData& data)> setup;
+    bool needsEvents{};                     // reads data.events (vector<SimulationEvent>)
+    std::string baseline{};                 // name of the benchmark to report the speedup against, same dataset
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    std::size_t events{};
+    std::size_t items{};
+    std::size_t runs{};
+    double medianSec{};
+    double allocatedBytes{};                // per run
+    double allocations{};                   // per run
+    std::optional<double> speedup{};        // baseline median / this median
+};
+
+struct BenchmarkSettings
+{
+    double minSeconds{ 0.25 };
+    std::size_t maxRuns{ 1000 };
+    bool csv{};
+};
+
+inline BenchmarkResult RunBenchmark(const Benchmark& benchmark, const BenchmarkData& data, const BenchmarkSettings& settings)
+{
+    using Clock = std::chrono::steady_clock;
+
+    BenchmarkRun run = benchmark.setup(data);
+    volatile std::uint64_t sink = run.body();// warm-up: first touch of the pages, lazy pool start-up
+
+    std::vector<double> seconds{};
+    seconds.reserve(settings.maxRuns);// before counting, so only the benchmark's own allocations show up
+    const std::uint64_t allocationsBefore = GlobalAllocations().allocations.load(std::memory_order_relaxed);
+    const std::uint64_t bytesBefore = GlobalAllocations().bytes.load(std::memory_order_relaxed);
+    const Clock::time_point start = Clock::now();
+    do
+    {
+        const Clock::time_point begin = Clock::now();
+        sink = sink + run.body();
+        seconds.push_back(std::chrono::duration<double>(Clock::now() - begin).count());
+    } while (seconds.size() < settings.maxRuns && std::chrono::duration<double>(Clock::now() - start).count() < settings.minSeconds);
+    const double runs = static_cast<double>(seconds.size());
+    const double allocations = static_cast<double>(GlobalAllocations().allocations.load(std::memory_order_relaxed) - allocationsBefore);
+    const double bytes = static_cast<double>(GlobalAllocations().bytes.load(std::memory_order_relaxed) - bytesBefore);
+
+    std::ranges::nth_element(seconds, seconds.begin() + seconds.size() / 2);
+    BenchmarkResult result{ benchmark.name, data.store.Size(), run.items ? run.items : data.store.Size(), seconds.size(), seconds[seconds.size() / 2] };
+    result.allocatedBytes = bytes / runs;
+    result.allocations = allocations / runs;
+    return result;
+}
+
+inline void PrintBenchmarkHeader(const BenchmarkData& data, const BenchmarkSettings& settings)
+{
+    const double storeBytes = static_cast<double>(sizeof(double) + sizeof(EventType) + sizeof(SourceId) + sizeof(double));
+    if (settings.csv)
+    {
+        return;
+    }
+    std::printf("\n== %zu events, %zu sources, disorder %.3gs (%.0f%%), seed %llu | store %.0f B/event, vector %zu B/event%s\n",
+        data.options.events, data.options.sources, data.options.disorderSec, data.options.disorderFraction * 100.0,
+        static_cast<unsigned long long>(data.options.seed), storeBytes, sizeof(SimulationEvent),
+        data.events.empty() ? " (vector benchmarks skipped)" : "");
+    std::printf("%-52s %8s %12s %12s %12s %10s %9s\n", "benchmark", "runs", "ms/run", "Mitems/s", "alloc B/ev", "allocs", "speedup");
+}
+
+inline void PrintBenchmarkResult(const BenchmarkResult& result, const BenchmarkSettings& settings)
+{
+    const double itemsPerSec = result.medianSec > 0.0 ? static_cast<double>(result.items) / result.medianSec : 0.0;
+    const double bytesPerEvent = result.events ? result.allocatedBytes / static_cast<double>(result.events) : 0.0;
+    if (settings.csv)
+    {
+        std::printf("%s,%zu,%zu,%zu,%.9f,%.1f,%.3f,%.1f,%s\n", result.name.c_str(), result.events, result.items, result.runs,
+            result.medianSec, itemsPerSec, bytesPerEvent, result.allocations, result.speedup ? std::to_string(*result.speedup).c_str() : "");
+        return;
+    }
+    char speedup[16] = "";
+    if (result.speedup)
+    {
+        std::snprintf(speedup, sizeof(speedup), "%.2fx", *result.speedup);
+    }
+    std::printf("%-52s %8zu %12.4f %12.2f %12.2f %10.1f %9s\n", result.name.c_str(), result.runs, result.medianSec * 1e3,
+        itemsPerSec / 1e6, bytesPerEvent, result.allocations, speedup);
+}
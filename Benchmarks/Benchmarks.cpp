@@ -0,0 +1,1035 @@
+// Benchmark suite: every core operation and every engine on synthetic logs from 1K to 100M events.
+//
+//   Benchmarks.exe                                     1K, 100K and 1M events, 64 sources, 0.5s disorder
+//   Benchmarks.exe --events 10000000,100000000 --filter group/
+//   Benchmarks.exe --sources 4096 --disorder 2 --csv > results.csv
+//
+// Each line is the median run: ms/run, millions of items/s (items are events unless the name says otherwise),
+// heap bytes allocated per event and allocations per run. "speedup" is against the benchmark's baseline on the
+// same data: the original vector<SimulationEvent> algorithm for the engines, the serial version for the parallel ones.
+// The "(original)" rows are the first version's algorithms minus their console printing; the other vector rows
+// call the library's EventTasks.cpp, the same code the GUI runs.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "BenchmarkHarness.h"
+
+#include "BinaryEventLog.h"
+#include "CompressedEventStore.h"
+#include "EventAggregator.h"
+#include "EventColumnStore.h"
+#include "EventGenerator.h"
+#include "EventQueue.h"
+#include "EventTasks.h"
+#include "EventViews.h"
+#include "FlatHashMap.h"
+#include "LogView.h"
+#include "ParallelAlgorithms.h"
+#include "Pipeline.h"
+#include "Query.h"
+#include "QueryArena.h"
+#include "QueryCache.h"
+#include "Resample.h"
+#include "RunComparison.h"
+#include "ShardedAggregation.h"
+#include "SimulationEvent.h"
+#include "StreamIngestor.h"
+#include "StreamMerge.h"
+#include "TextLogParser.h"
+#include "TimeIndex.h"
+#include "WindowAggregator.h"
+#include "ZoneMap.h"
+
+// ** Allocation counting **
+// Replacing the global operator new is what lets every benchmark report bytes/event without touching the engines.
+
+static void* CountedAllocate(std::size_t size)
+{
+    GlobalAllocations().allocations.fetch_add(1, std::memory_order_relaxed);
+    GlobalAllocations().bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size ? size : 1))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc{};
+}
+
+static void* CountedAllocateAligned(std::size_t size, std::align_val_t alignment)
+{
+    GlobalAllocations().allocations.fetch_add(1, std::memory_order_relaxed);
+    GlobalAllocations().bytes.fetch_add(size, std::memory_order_relaxed);
+    const auto align = static_cast<std::size_t>(alignment);
+#if defined(_MSC_VER)
+    void* pointer = _aligned_malloc(size ? size : 1, align);
+#else
+    void* pointer = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align);
+#endif
+    if (!pointer)
+    {
+        throw std::bad_alloc{};
+    }
+    return pointer;
+}
+
+static void FreeAligned(void* pointer)
+{
+#if defined(_MSC_VER)
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+void* operator new(std::size_t size) { return CountedAllocate(size); }
+void* operator new[](std::size_t size) { return CountedAllocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return CountedAllocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return CountedAllocateAligned(size, alignment); }
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { FreeAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { FreeAligned(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { FreeAligned(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { FreeAligned(pointer); }
+
+// ** Helpers **
+
+static std::uint64_t Checksum(double value) { return static_cast<std::uint64_t>(value); }
+
+// A time that splits the log roughly in half, so FirstEventAfter has to scan half of it.
+static double MedianTime(const BenchmarkData& data)
+{
+    return static_cast<double>(data.options.events) / data.options.rateHz / 2.0;
+}
+
+static std::string FormatTextLog(const EventColumnStore& store)
+{
+    std::string text{};
+    text.reserve(store.Size() * 40);
+    char line[160];
+    for (std::size_t row = 0; row < store.Size(); ++row)
+    {
+        const int length = std::snprintf(line, sizeof(line), "%.6f,%s,%s,%.6f\n", store.Timestamps()[row],
+            EventTypeNames[static_cast<std::size_t>(store.Types()[row])].data(), store.SourceName(store.SourceIds()[row]).c_str(), store.Values()[row]);
+        text.append(line, static_cast<std::size_t>(length));
+    }
+    return text;
+}
+
+// CompareRuns splits run A into chunks (32 on an 8-thread pool, whatever this machine has): it must report exactly
+// what one serial walk over the whole runs finds.
+static void CheckCompareRunsChunking(const SimulationRun& a, const SimulationRun& b, double toleranceSec)
+{
+    std::vector<AlignedStretch> stretches{};
+    std::uint64_t onlyInA = 0;
+    AlignRuns(a.timestamps, b.timestamps, 0, a.Size(), 0, toleranceSec, stretches, onlyInA);
+    std::uint64_t matched = 0;
+    for (const AlignedStretch& stretch : stretches) matched += stretch.length;
+
+    RunComparisonOptions options{};
+    options.timeToleranceSec = toleranceSec;
+    ThreadPool pool{ 8 };
+    const RunComparisonReport report = CompareRuns(a, b, options, pool);
+    bool same = report.matched == matched && report.onlyInA == onlyInA && report.onlyInB == b.Size() - matched;
+    for (std::size_t field = 0; field < a.fields.size(); ++field)
+    {
+        double sumSquares = 0.0;
+        double maxAbs = 0.0;
+        for (const AlignedStretch& stretch : stretches)
+        {
+            const StretchDiff diff = DiffSlices(a.fields[field].data() + stretch.rowA, b.fields[field].data() + stretch.rowB, stretch.length);
+            sumSquares += diff.sumSquares;
+            maxAbs = std::max(maxAbs, diff.maxAbs);
+        }
+        const double rmse = matched > 0 ? std::sqrt(sumSquares / static_cast<double>(matched)) : 0.0;
+        same = same && report.fields[field].maxAbsDiff == maxAbs && std::abs(report.fields[field].rmse - rmse) <= 1e-9 * (1.0 + rmse);// sums in another order
+    }
+    if (!same)
+    {
+        throw std::logic_error("CompareRuns: the chunked comparison disagrees with one serial walk");
+    }
+}
+
+// ** The suite **
+
+static std::vector<Benchmark> RegisterBenchmarks()
+{
+    std::vector<Benchmark> benchmarks{};
+    auto add = [&benchmarks](std::string name, std::function<BenchmarkRun(const BenchmarkData&)> setup, bool needsEvents = false, std::string baseline = {})
+    {
+        benchmarks.push_back({ std::move(name), std::move(setup), needsEvents, std::move(baseline) });
+    };
+    constexpr bool Events = true;
+
+    //1. Sort by timestamp
+    add("sort/stable_sort vector (original)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data]
+                {
+                    std::vector<SimulationEvent> sorted{ data.events };
+                    std::ranges::stable_sort(sorted, {}, &SimulationEvent::timestampSec);
+                    return Checksum(sorted.front().timestampSec);
+                } };
+        }, Events);
+    add("sort/SortedOrderByTime vector (radix)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ SortedOrderByTime(data.events).front() }; } };
+        }, Events, "sort/stable_sort vector (original)");
+    add("sort/SortByTime vector (radix + gather)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return Checksum(SortByTime(data.events).front().timestampSec); } };
+        }, Events, "sort/stable_sort vector (original)");
+    add("sort/SortedOrderByTime store (radix)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ SortedOrderByTime(data.store).front() }; } };
+        }, false, "sort/stable_sort vector (original)");
+    add("sort/SortByTime store (radix + gather)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return Checksum(SortByTime(data.store).Timestamps().front()); } };
+        }, false, "sort/stable_sort vector (original)");
+    add("sort/ParallelSortedOrderByTime store", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ ParallelSortedOrderByTime(data.store).front() }; } };
+        }, false, "sort/SortedOrderByTime store (radix)");
+
+    //2. Filter by type
+    add("filter/copy_if vector (original)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data]
+                {
+                    std::vector<SimulationEvent> filtered{};
+                    std::ranges::copy_if(data.events, std::back_inserter(filtered), [](const SimulationEvent& event) { return event.type == EventType::SENSOR_READING; });
+                    return std::uint64_t{ filtered.size() };
+                } };
+        }, Events);
+    add("filter/FilterByTypeView vector (count)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return static_cast<std::uint64_t>(std::ranges::distance(FilterByTypeView(data.events, EventType::SENSOR_READING))); } };
+        }, Events, "filter/copy_if vector (original)");
+    add("filter/SelectByType store (SIMD selection)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ SelectByType(data.store, EventType::SENSOR_READING).size() }; } };
+        }, false, "filter/copy_if vector (original)");
+    add("filter/FilterByType store (selection + gather)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ FilterByType(data.store, EventType::SENSOR_READING).Size() }; } };
+        }, false, "filter/copy_if vector (original)");
+    add("filter/Select<Where<Type, TimeBetween>> store", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            const TimeBetween firstHalf{ 0.0, MedianTime(data) };
+            return { [&data, firstHalf] { return std::uint64_t{ Select<Where<Type<EventType::SENSOR_READING>, TimeBetween>>::Run(data.store, { {}, firstHalf }).size() }; } };
+        });
+    add("filter/SelectByType store (arena)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto arena = std::make_shared<QueryArena>();
+            return { [&data, arena]
+                {
+                    arena->Reset();
+                    return std::uint64_t{ SelectByType(data.store, EventType::SENSOR_READING, arena->Resource()).size() };
+                } };
+        }, false, "filter/SelectByType store (SIMD selection)");
+
+    //3. Group by source / type
+    add("group/unordered_map by source vector (original)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data]
+                {
+                    std::unordered_map<std::string, std::vector<SimulationEvent>> grouped{};
+                    for (const SimulationEvent& event : data.events)
+                    {
+                        grouped[event.source].push_back(event);
+                    }
+                    return std::uint64_t{ grouped.size() };
+                } };
+        }, Events);
+    add("group/GroupBySource vector (flat map)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ GroupBySource(data.events).Size() }; } };
+        }, Events, "group/unordered_map by source vector (original)");
+    add("group/ParallelGroupBySource vector (flat map)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ ParallelGroupBySource(data.events).Size() }; } };
+        }, Events, "group/unordered_map by source vector (original)");
+    add("group/GroupBySource store (flat map)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ GroupBySource(data.store).Size() }; } };
+        }, false, "group/unordered_map by source vector (original)");
+    add("group/GroupBySourceId store", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ GroupBySourceId(data.store).size() }; } };
+        }, false, "group/unordered_map by source vector (original)");
+    add("group/GroupBySourceId store (arena)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto arena = std::make_shared<QueryArena>();
+            return { [&data, arena]
+                {
+                    arena->Reset();
+                    return std::uint64_t{ GroupBySourceId(data.store, arena->Resource()).size() };
+                } };
+        }, false, "group/GroupBySourceId store");
+    add("group/PartitionBySourceId store", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ PartitionBySourceId(data.store).GroupCount() }; } };
+        }, false, "group/GroupBySourceId store");
+    add("group/ParallelGroupBySourceId store", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ ParallelGroupBySourceId(data.store).size() }; } };
+        }, false, "group/GroupBySourceId store");
+    add("group/ParallelPartitionBySourceId store", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ ParallelPartitionBySourceId(data.store).GroupCount() }; } };
+        }, false, "group/PartitionBySourceId store");
+    add("group/GroupByType store (dense enum map)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ GroupByType(data.store).Size() }; } };
+        });
+    add("group/PartitionByType store", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ PartitionByType(data.store).RowCount() }; } };
+        }, false, "group/GroupByType store (dense enum map)");
+    add("group/ParallelGroupByType store", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ ParallelGroupByType(data.store)[0].size() }; } };
+        }, false, "group/GroupByType store (dense enum map)");
+
+    //4. Totals and aggregates
+    add("total/accumulate by source vector (original)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data]
+                {
+                    const std::string source{ "engine1" };
+                    return Checksum(std::accumulate(data.events.begin(), data.events.end(), 0.0,
+                        [&source](double sum, const SimulationEvent& event) { return sum + (event.source == source ? event.value : 0.0); }));
+                } };
+        }, Events);
+    add("total/Acumulate vector (Query.h fused)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return Checksum(Acumulate(data.events, "engine1")); } };
+        }, Events, "total/accumulate by source vector (original)");
+    add("total/ComputeTotalValueBySource store (SIMD)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return Checksum(ComputeTotalValueBySource(data.store, "engine1")); } };
+        }, false, "total/accumulate by source vector (original)");
+    add("total/AcumulatebySource store (SIMD)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return Checksum(AcumulatebySource(data.store, EventType::SENSOR_READING)); } };
+        });
+    add("total/RunQuery mean type+source+time store", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            QuerySpec spec{ QueryAggregate::Mean, EventType::SENSOR_READING, data.store.FindSource("engine1"), 0.0, MedianTime(data) };
+            return { [&data, spec] { return Checksum(RunQuery(data.store, spec)); } };
+        });
+    add("total/ComputeTotalValueBySourceId store (all sources)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return Checksum(ComputeTotalValueBySourceId(data.store).front()); } };
+        });
+    add("total/AggregateEvents store (every statistic)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return AggregateEvents(data.store).overall.count; } };
+        });
+    add("total/ParallelAggregateEvents store", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return ParallelAggregateEvents(data.store).overall.count; } };
+        }, false, "total/AggregateEvents store (every statistic)");
+
+    //5. First event after a time
+    add("first/find_if vector (original)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            const double threshold = MedianTime(data);
+            return { [&data, threshold]
+                {
+                    auto it = std::ranges::find_if(data.events, [threshold](const SimulationEvent& event) { return event.timestampSec > threshold; });
+                    return static_cast<std::uint64_t>(it - data.events.begin());
+                } };
+        }, Events);
+    add("first/FirstEventAfter store (column scan)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            const double threshold = MedianTime(data);
+            return { [&data, threshold] { return std::uint64_t{ FirstEventAfter(data.store, threshold).value_or(0) }; } };
+        }, false, "first/find_if vector (original)");
+    add("first/TimeIndex build", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ TimeIndex{ data.store }.Size() }; } };
+        });
+    add("first/TimeIndex FirstAfter (1000 lookups)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto index = std::make_shared<TimeIndex>(data.store);
+            const double span = static_cast<double>(data.options.events) / data.options.rateHz;
+            return { [index, span]
+                {
+                    std::uint64_t sum = 0;
+                    for (int lookup = 0; lookup < 1000; ++lookup)
+                    {
+                        sum += index->FirstAfter(span * lookup / 1000.0).value_or(0);
+                    }
+                    return sum;
+                }, 1000 };
+        });
+
+    //6. Streaming engines
+    add("window/AggregateWindows 10s tumbling by source", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ AggregateWindows(data.store, { 10.0, 10.0, WindowKey::Source }).size() }; } };
+        });
+    add("window/AggregateWindows 10s/1s sliding by source", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ AggregateWindows(data.store, { 10.0, 1.0, WindowKey::Source }).size() }; } };
+        });
+    add("pipeline/PushStore filter -> accumulate", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data]
+                {
+                    Pipeline pipeline{};
+                    pipeline.Then<FilterByTypeOperator>(EventType::SENSOR_READING);
+                    auto& total = pipeline.Then<AccumulateOperator>();
+                    PushStore(data.store, pipeline);
+                    return total.Stats().count;
+                } };
+        });
+    add("pipeline/PushStore group by source -> accumulate", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data]
+                {
+                    Pipeline pipeline{};
+                    auto& groups = pipeline.Then<GroupBySourceOperator>([](SourceId) { return std::make_unique<AccumulateOperator>(); });
+                    PushStore(data.store, pipeline);
+                    return std::uint64_t{ groups.GroupCount() };
+                } };
+        });
+    add("ingest/StreamIngestor reorder buffer", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data]
+                {
+                    EventColumnStore output{ data.store.SharedSources() };
+                    output.Reserve(data.store.Size());
+                    StreamIngestor ingestor{ output, { 4096 } };
+                    for (std::size_t row = 0; row < data.store.Size(); ++row)
+                    {
+                        ingestor.Ingest(data.store.Timestamps()[row], data.store.Types()[row], data.store.SourceIds()[row], data.store.Values()[row]);
+                    }
+                    ingestor.Flush();
+                    return ingestor.Stats().released;
+                } };
+        });
+    add("queue/SPSC producer thread -> pipeline", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data]
+                {
+                    SpscRingBuffer<QueuedEvent> queue{ 1 << 14 };
+                    Pipeline pipeline{};
+                    auto& total = pipeline.Then<AccumulateOperator>();
+                    EventQueueConsumer consumer{ queue, pipeline, data.store.SharedSources() };
+                    std::atomic<bool> done{};
+
+                    std::thread producer{ [&]
+                        {
+                            for (std::size_t row = 0; row < data.store.Size(); ++row)
+                            {
+                                PushWithBackoff(queue, QueuedEvent{ data.store.Timestamps()[row], data.store.Values()[row], data.store.SourceIds()[row], data.store.Types()[row] });
+                            }
+                            done.store(true, std::memory_order_release);
+                        } };
+                    consumer.Run(done);
+                    producer.join();
+                    return total.Stats().count;
+                } };
+        });
+
+    //7. Hash lookups: one lookup per event, by the event's source name
+    add("hash/unordered_map<string> find", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto table = std::make_shared<std::unordered_map<std::string, SourceId>>();
+            for (SourceId id = 0; id < data.store.SourceCount(); ++id)
+            {
+                table->emplace(data.store.SourceName(id), id);
+            }
+            return { [&data, table]
+                {
+                    std::uint64_t sum = 0;
+                    for (const SimulationEvent& event : data.events)
+                    {
+                        sum += table->find(event.source)->second;
+                    }
+                    return sum;
+                } };
+        }, Events);
+    add("hash/FlatStringMap find", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto table = std::make_shared<FlatStringMap<SourceId>>();
+            for (SourceId id = 0; id < data.store.SourceCount(); ++id)
+            {
+                table->TryEmplace(data.store.SourceName(id), id);
+            }
+            return { [&data, table]
+                {
+                    std::uint64_t sum = 0;
+                    for (const SimulationEvent& event : data.events)
+                    {
+                        sum += *table->Find(event.source);
+                    }
+                    return sum;
+                } };
+        }, Events, "hash/unordered_map<string> find");
+
+    //8. Loading
+    add("load/EventColumnStore from vector", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ EventColumnStore{ data.events }.Size() }; } };
+        }, Events);
+    add("load/TextLogParser in memory", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto text = std::make_shared<std::string>(FormatTextLog(data.store));
+            return { [text]
+                {
+                    std::uint64_t events = 0;
+                    TextLogParser parser{ std::make_shared<SourceDictionary>(), [&events](const EventColumnStore& batch) { events += batch.Size(); } };
+                    parser.Feed(*text);
+                    parser.Finish();
+                    return events;
+                } };
+        });
+    add("load/LoadBinaryEventLog (memory-mapped)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto path = std::make_shared<std::filesystem::path>(std::filesystem::temp_directory_path() / "esp_benchmark.evlog");
+            WriteBinaryEventLog(data.store, *path);
+            return { [path]
+                {
+                    EventColumnStore loaded = LoadBinaryEventLog(*path);
+                    return Checksum(ComputeTotalValueBySource(loaded, "engine1"));// touch the mapped columns too
+                } };
+        }, false, "load/TextLogParser in memory");
+
+    //9. GUI log view: what one button press and one frame cost
+    add("view/format every line store (original)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data]
+                {
+                    std::vector<std::string> lines{};
+                    lines.reserve(data.store.Size());
+                    for (EventIndex row = 0; row < data.store.Size(); ++row)
+                    {
+                        lines.push_back(FormatEventLine(data.store, row));
+                    }
+                    return std::uint64_t{ lines.size() };
+                } };
+        });
+    add("view/LogView all rows + first screen", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data]
+                {
+                    auto log = std::make_unique<LogView>();
+                    log->AddAllRows(data.store);
+                    std::uint64_t bytes = 0;
+                    for (std::size_t line = 0; line < std::min<std::size_t>(25, log->Size()); ++line)
+                    {
+                        bytes += log->Line(line).size();
+                    }
+                    return bytes;
+                } };
+        }, false, "view/format every line store (original)");
+    add("view/LogView scroll 3 lines (1000 frames)", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto log = std::make_shared<LogView>();
+            log->AddRows(data.store, SortedOrderByTime(data.store));
+            return { [log]
+                {
+                    std::uint64_t bytes = 0;
+                    for (int frame = 0; frame < 1000; ++frame)
+                    {
+                        log->ScrollBy(3, 25);
+                        for (std::size_t line = log->Top(); line < std::min(log->Size(), log->Top() + 25); ++line)
+                        {
+                            bytes += log->Line(line).size();
+                        }
+                    }
+                    return bytes;
+                }, 1000 };
+        });
+
+    //10. Repeated queries on a growing store: a dashboard refresh after 1000 new events
+    // Each run appends the next 1000 events (copies of the log's own rows) to a private copy of the store, then asks
+    // the same three questions again.
+    auto appendBatch = [](EventColumnStore& store, const EventColumnStore& source, std::size_t& next)
+        {
+            for (int i = 0; i < 1000; ++i, ++next)
+            {
+                const std::size_t row = next % source.Size();
+                store.Append(source.Timestamps()[row], source.Types()[row], source.SourceIds()[row], source.Values()[row]);
+            }
+        };
+    add("cache/RunQuery full rescan after 1000 appended events", [appendBatch](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto store = std::make_shared<EventColumnStore>(data.store);
+            auto next = std::make_shared<std::size_t>();
+            const QuerySpec spec{ QueryAggregate::Sum, {}, data.store.FindSource("engine1") };
+            return { [store, next, spec, appendBatch, &data]
+                {
+                    appendBatch(*store, data.store, *next);
+                    double checksum = RunQuery(*store, spec);
+                    checksum += static_cast<double>(RunSelect(*store, { QueryAggregate::Count, EventType::CONTROL_INPUT }).size());
+                    checksum += static_cast<double>(AggregateEvents(*store).overall.count);
+                    return Checksum(checksum);
+                }, 1000 };
+        });
+    add("cache/QueryCache after 1000 appended events", [appendBatch](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto store = std::make_shared<EventColumnStore>(data.store);
+            auto next = std::make_shared<std::size_t>();
+            auto cache = std::make_shared<QueryCache>(*store);
+            const QuerySpec spec{ QueryAggregate::Sum, {}, data.store.FindSource("engine1") };
+            return { [store, next, cache, spec, appendBatch, &data]
+                {
+                    appendBatch(*store, data.store, *next);
+                    double checksum = cache->Run(spec);
+                    checksum += static_cast<double>(cache->Select({ QueryAggregate::Count, EventType::CONTROL_INPUT }).size());
+                    checksum += static_cast<double>(cache->Aggregates().overall.count);
+                    return Checksum(checksum);
+                }, 1000 };
+        }, false, "cache/RunQuery full rescan after 1000 appended events");
+
+    //11. K-way merge: one time-sorted stream per source, merged back into time order
+    auto sortedRuns = [](const BenchmarkData& data)
+        {
+            auto runs = std::make_shared<std::vector<std::vector<EventIndex>>>(GroupBySourceId(data.store));
+            auto timestamps = data.store.Timestamps();
+            for (auto& run : *runs)
+            {
+                std::ranges::stable_sort(run, {}, [timestamps](EventIndex row) { return timestamps[row]; });
+            }
+            return runs;
+        };
+    add("merge/concatenate runs + sort by time (original)", [sortedRuns](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto runs = sortedRuns(data);
+            return { [&data, runs]
+                {
+                    std::vector<EventIndex> order{};
+                    order.reserve(data.store.Size());
+                    for (const auto& run : *runs) order.insert(order.end(), run.begin(), run.end());
+                    auto timestamps = data.store.Timestamps();
+                    std::ranges::stable_sort(order, {}, [timestamps](EventIndex row) { return timestamps[row]; });
+                    AccumulateOperator total{};
+                    PushOrdered(data.store, order, total);
+                    return total.Stats().count;
+                } };
+        });
+    add("merge/MergeSortedRuns loser tree", [sortedRuns](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto runs = sortedRuns(data);
+            return { [&data, runs]
+                {
+                    AccumulateOperator total{};
+                    MergeSortedRuns(data.store, *runs, total);
+                    return total.Stats().count;
+                } };
+        }, false, "merge/concatenate runs + sort by time (original)");
+    add("merge/PushMerged one store per source", [sortedRuns](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto runs = sortedRuns(data);
+            auto stores = std::make_shared<std::vector<EventColumnStore>>();
+            for (const auto& run : *runs) stores->push_back(data.store.Gather(run));
+            return { [stores]
+                {
+                    std::vector<const EventColumnStore*> streams{};
+                    for (const auto& store : *stores) streams.push_back(&store);
+                    AccumulateOperator total{};
+                    PushMerged(streams, total);
+                    return total.Stats().count;
+                } };
+        }, false, "merge/concatenate runs + sort by time (original)");
+
+    //12. Resampling one source onto a grid of one point per event, then every source onto a per-source share of it
+    auto timeGrid = [](const BenchmarkData& data, std::size_t points)
+        {
+            const auto [first, last] = std::ranges::minmax(data.store.Timestamps());
+            return std::make_shared<std::vector<double>>(UniformGrid(first, last, (last - first) / static_cast<double>(std::max<std::size_t>(points, 2) - 1)));
+        };
+    add("resample/per-point upper_bound + LERP (original)", [timeGrid](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto series = std::make_shared<TimeSeries>(SourceSeries(data.store, SourceId{ 0 }));
+            auto grid = timeGrid(data, data.store.Size());
+            return { [series, grid]
+                {
+                    const auto& times = series->timestamps;
+                    std::vector<double> out(grid->size());
+                    for (std::size_t i = 0; i < grid->size(); ++i)
+                    {
+                        const double x = (*grid)[i];
+                        const auto after = static_cast<std::size_t>(std::ranges::upper_bound(times, x) - times.begin());
+                        if (after == 0) out[i] = series->values.front();
+                        else if (after == times.size()) out[i] = series->values.back();
+                        else out[i] = LERP(series->values[after - 1], series->values[after], (x - times[after - 1]) / (times[after] - times[after - 1]));
+                    }
+                    return Checksum(out[out.size() / 2]);
+                } };
+        });
+    add("resample/Resample kernel one source", [timeGrid](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto series = std::make_shared<TimeSeries>(SourceSeries(data.store, SourceId{ 0 }));
+            auto grid = timeGrid(data, data.store.Size());
+            return { [series, grid]
+                {
+                    std::vector<double> out = Resample(*series, *grid);
+                    return Checksum(out[out.size() / 2]);
+                } };
+        }, false, "resample/per-point upper_bound + LERP (original)");
+    add("resample/ResampleBySource every source", [timeGrid](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto grid = timeGrid(data, data.store.Size() / std::max<std::size_t>(data.store.SourceCount(), 1));
+            return { [&data, grid]
+                {
+                    auto bySource = ResampleBySource(data.store, *grid);
+                    return Checksum(bySource.front()[grid->size() / 2]);
+                } };
+        });
+
+    //13. Regression diff of two simulation runs, one state per event: B drops every 97th state and drifts every 1000th
+    auto simulationRuns = [](const BenchmarkData& data)
+        {
+            auto runs = std::make_shared<std::pair<std::vector<SimulationState>, std::vector<SimulationState>>>();
+            auto values = data.store.Values();
+            for (std::size_t row = 0; row < data.store.Size(); ++row)
+            {
+                const SimulationState state{ 0.01 * static_cast<double>(row), values[row], values[row] * 0.5, 20.0 + values[row] * 0.01 };
+                runs->first.push_back(state);
+                if (row % 97 == 0) continue;
+                runs->second.push_back(state);
+                if (row % 1000 == 0) runs->second.back().velocityY += 1.0;
+            }
+            return runs;
+        };
+    add("compare/merge states into pairs + one pass per field (original)", [simulationRuns](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto runs = simulationRuns(data);
+            return { [runs]
+                {
+                    const auto& [simA, simB] = *runs;
+                    std::vector<std::pair<SimulationState, SimulationState>> matched{};
+                    for (std::size_t i = 0, j = 0; i < simA.size() && j < simB.size();)
+                    {
+                        if (simA[i].timestamp < simB[j].timestamp) ++i;
+                        else if (simB[j].timestamp < simA[i].timestamp) ++j;
+                        else matched.emplace_back(simA[i++], simB[j++]);
+                    }
+                    double rmse[3]{};
+                    std::vector<double> deviating{};
+                    for (const auto& [a, b] : matched) rmse[0] += (a.positionX - b.positionX) * (a.positionX - b.positionX);
+                    for (const auto& [a, b] : matched) rmse[1] += (a.velocityY - b.velocityY) * (a.velocityY - b.velocityY);
+                    for (const auto& [a, b] : matched) rmse[2] += (a.temperature - b.temperature) * (a.temperature - b.temperature);
+                    for (const auto& [a, b] : matched)
+                    {
+                        if (std::abs(a.positionX - b.positionX) > 0.5 || std::abs(a.velocityY - b.velocityY) > 0.5 || std::abs(a.temperature - b.temperature) > 0.5)
+                        {
+                            deviating.push_back(a.timestamp);
+                        }
+                    }
+                    return std::uint64_t{ deviating.size() } + Checksum(std::sqrt(rmse[1] / static_cast<double>(matched.size())) * 1000.0);
+                } };
+        });
+    add("compare/CompareRuns aligned stretches (parallel)", [simulationRuns](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto runs = simulationRuns(data);
+            auto columns = std::make_shared<std::pair<SimulationRun, SimulationRun>>(SimulationRunFromStates(runs->first), SimulationRunFromStates(runs->second));
+            CheckCompareRunsChunking(columns->first, columns->second, 0.0);
+            SimulationRun halfStepLater = columns->first;// every state of A is within tolerance of two of B, at every chunk start too
+            for (double& timestamp : halfStepLater.timestamps) timestamp += 0.005;
+            CheckCompareRunsChunking(columns->first, halfStepLater, 0.006);
+            return { [columns]
+                {
+                    RunComparisonOptions options{};
+                    options.thresholds = { 0.5, 0.5, 0.5 };
+                    const RunComparisonReport report = CompareRuns(columns->first, columns->second, options);
+                    return report.statesExceeded + Checksum(report.fields[1].rmse * 1000.0);
+                } };
+        }, false, "compare/merge states into pairs + one pass per field (original)");
+
+    //14. Compressed history: telemetry-like rows (64 sources round-robin at 100 Hz, readings on a 0.1 grid that hold
+    // or step) and a mean over the middle 80% of the time span
+    auto telemetry = [](const BenchmarkData& data)
+        {
+            auto store = std::make_shared<EventColumnStore>(data.store.SharedSources());
+            std::vector<double> readings(64, 100.0);
+            auto sourceIds = data.store.SourceIds();
+            for (std::size_t row = 0; row < data.store.Size(); ++row)
+            {
+                const SourceId id = static_cast<SourceId>(row % 64);
+                if (sourceIds[row] % 4 == 0) readings[id] += sourceIds[row] % 8 == 0 ? 0.1 : -0.1;
+                store->Append(0.01 * static_cast<double>(row / 64), EventType::SENSOR_READING, id, std::round(readings[id] * 10.0) / 10.0);
+            }
+            return store;
+        };
+    auto middleRange = [](const EventColumnStore& store)
+        {
+            const double span = store.Empty() ? 0.0 : store.Timestamps().back();
+            return QuerySpec{ QueryAggregate::Mean, {}, {}, span * 0.1, span * 0.9 };
+        };
+    add("compress/build CompressedEventStore", [telemetry](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto store = telemetry(data);
+            return { [store]
+                {
+                    const CompressedEventStore history{ *store };
+                    return std::uint64_t{ history.CompressedBytes() };
+                } };
+        });
+    add("compress/range mean, column scan", [telemetry, middleRange](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto store = telemetry(data);
+            return { [store, middleRange] { return Checksum(RunQuery(*store, middleRange(*store))); } };
+        });
+    add("compress/range mean, block headers + edge blocks", [telemetry, middleRange](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto store = telemetry(data);
+            auto history = std::make_shared<const CompressedEventStore>(*store);
+            const QuerySpec spec = middleRange(*store);
+            return { [history, spec] { return Checksum(RunQuery(*history, spec)); } };
+        }, false, "compress/range mean, column scan");
+    add("compress/range mean, one source (decodes every block)", [telemetry, middleRange](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto store = telemetry(data);
+            auto history = std::make_shared<const CompressedEventStore>(*store);
+            QuerySpec spec = middleRange(*store);
+            spec.source = SourceId{ 1 };
+            return { [history, spec] { return Checksum(RunQuery(*history, spec)); } };
+        }, false, "compress/range mean, column scan");
+    add("compress/Decompress", [telemetry](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto history = std::make_shared<const CompressedEventStore>(*telemetry(data));
+            return { [history] { return std::uint64_t{ history->Decompress().Size() }; } };
+        });
+
+    //15. Zone maps: the same questions with 64K-event block summaries; the log is in time order up to its disorder
+    auto spanAt = [](const EventColumnStore& store, double fraction)
+        {
+            const auto [first, last] = std::ranges::minmax(store.Timestamps());
+            return first + (last - first) * fraction;
+        };
+    add("zones/build ZoneMap", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return std::uint64_t{ ZoneMap{ data.store }.Zones().size() }; } };
+        });
+    add("zones/first event after 90% of the span, column scan", [spanAt](const BenchmarkData& data) -> BenchmarkRun
+        {
+            const double threshold = spanAt(data.store, 0.9);
+            return { [&data, threshold] { return std::uint64_t{ FirstEventAfter(data.store, threshold).value_or(0) }; } };
+        });
+    add("zones/first event after 90% of the span, zone map", [spanAt](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto zones = std::make_shared<const ZoneMap>(data.store);
+            const double threshold = spanAt(data.store, 0.9);
+            return { [&data, zones, threshold] { return std::uint64_t{ FirstEventAfter(data.store, *zones, threshold).value_or(0) }; } };
+        }, false, "zones/first event after 90% of the span, column scan");
+    auto narrowRange = [spanAt](const EventColumnStore& store)
+        {
+            return QuerySpec{ QueryAggregate::Sum, EventType::SENSOR_READING, {}, spanAt(store, 0.5), spanAt(store, 0.51) };
+        };
+    add("zones/sensor sum over 1% of the span, column scan", [narrowRange](const BenchmarkData& data) -> BenchmarkRun
+        {
+            const QuerySpec spec = narrowRange(data.store);
+            return { [&data, spec] { return Checksum(RunQuery(data.store, spec)); } };
+        });
+    add("zones/sensor sum over 1% of the span, zone map", [narrowRange](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto zones = std::make_shared<const ZoneMap>(data.store);
+            const QuerySpec spec = narrowRange(data.store);
+            return { [&data, zones, spec] { return Checksum(RunQuery(data.store, *zones, spec)); } };
+        }, false, "zones/sensor sum over 1% of the span, column scan");
+    add("zones/mean per type, column scan", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data]
+                {
+                    double means = 0.0;
+                    for (std::size_t slot = 0; slot < EventTypeCount; ++slot) means += RunQuery(data.store, { QueryAggregate::Mean, static_cast<EventType>(slot) });
+                    return Checksum(means);
+                } };
+        });
+    add("zones/mean per type, zone summaries", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            auto zones = std::make_shared<const ZoneMap>(data.store);
+            return { [&data, zones]
+                {
+                    double means = 0.0;
+                    for (std::size_t slot = 0; slot < EventTypeCount; ++slot) means += RunQuery(data.store, *zones, { QueryAggregate::Mean, static_cast<EventType>(slot) });
+                    return Checksum(means);
+                } };
+        }, false, "zones/mean per type, column scan");
+
+    //16. Sharded stats: 8 nodes each holding the sources hashed to them, partial states encoded, decoded and merged
+    // at a coordinator (in one process: what is measured is the work, not the network)
+    add("shard/AggregateEvents, one node", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            return { [&data] { return AggregateEvents(data.store).overall.count; } };
+        });
+    add("shard/8 source shards, wire format, merge", [](const BenchmarkData& data) -> BenchmarkRun
+        {
+            const ShardPlan plan{ ShardKey::Source, 8 };
+            auto nodes = std::make_shared<std::vector<EventColumnStore>>();
+            for (std::size_t shard = 0; shard < plan.shardCount; ++shard)
+            {
+                nodes->push_back(data.store.Gather(SelectShard(data.store, plan, shard)));
+            }
+            return { [nodes, plan]
+                {
+                    AggregateCoordinator coordinator{ plan };
+                    for (std::size_t shard = 0; shard < plan.shardCount; ++shard)
+                    {
+                        const EventColumnStore& node = (*nodes)[shard];
+                        coordinator.Receive(EncodePartialAggregate(MakePartialAggregate(node, AggregateEvents(node), shard, plan)));
+                    }
+                    return coordinator.Report().overall.count;
+                } };
+        }, false, "shard/AggregateEvents, one node");
+
+    return benchmarks;
+}
+
+// ** Command line **
+
+struct BenchmarkCommandLine
+{
+    std::vector<std::size_t> eventCounts{ 1'000, 100'000, 1'000'000 };
+    EventGeneratorOptions generator{ 0, 64, 1000.0, 0.5, 1.0, 42 };
+    std::size_t maxVectorEvents{ 10'000'000 };
+    std::string filter{};
+    bool list{};
+    BenchmarkSettings settings{};
+};
+
+static std::vector<std::size_t> ParseCounts(std::string_view text)
+{
+    std::vector<std::size_t> counts{};
+    while (!text.empty())
+    {
+        const std::size_t comma = text.find(',');
+        counts.push_back(static_cast<std::size_t>(std::stod(std::string{ text.substr(0, comma) })));// stod: "1e8" works too
+        text = comma == std::string_view::npos ? std::string_view{} : text.substr(comma + 1);
+    }
+    return counts;
+}
+
+static BenchmarkCommandLine ParseCommandLine(int argc, char** argv)
+{
+    BenchmarkCommandLine options{};
+    for (int index = 1; index < argc; ++index)
+    {
+        const std::string_view argument{ argv[index] };
+        auto value = [&]() -> std::string
+        {
+            if (index + 1 >= argc)
+            {
+                throw std::invalid_argument(std::string{ argument } + " needs a value");
+            }
+            return argv[++index];
+        };
+
+        if (argument == "--events") options.eventCounts = ParseCounts(value());
+        else if (argument == "--sources") options.generator.sources = std::stoul(value());
+        else if (argument == "--disorder") options.generator.disorderSec = std::stod(value());
+        else if (argument == "--disorder-fraction") options.generator.disorderFraction = std::stod(value());
+        else if (argument == "--rate") options.generator.rateHz = std::stod(value());
+        else if (argument == "--seed") options.generator.seed = std::stoull(value());
+        else if (argument == "--max-vector-events") options.maxVectorEvents = static_cast<std::size_t>(std::stod(value()));
+        else if (argument == "--filter") options.filter = value();
+        else if (argument == "--min-time") options.settings.minSeconds = std::stod(value());
+        else if (argument == "--csv") options.settings.csv = true;
+        else if (argument == "--list") options.list = true;
+        else
+        {
+            throw std::invalid_argument("unknown option " + std::string{ argument } +
+                "\noptions: --events N[,N...] --sources N --disorder SEC --disorder-fraction F --rate HZ --seed N"
+                " --max-vector-events N --filter TEXT --min-time SEC --csv --list");
+        }
+    }
+    return options;
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkCommandLine options{};
+    try
+    {
+        options = ParseCommandLine(argc, argv);
+    }
+    catch (const std::exception& error)
+    {
+        std::fprintf(stderr, "Benchmarks: %s\n", error.what());
+        return 2;
+    }
+
+    std::vector<Benchmark> benchmarks = RegisterBenchmarks();
+    std::erase_if(benchmarks, [&options](const Benchmark& benchmark) { return benchmark.name.find(options.filter) == std::string::npos; });
+    if (options.list)
+    {
+        for (const Benchmark& benchmark : benchmarks)
+        {
+            std::printf("%s\n", benchmark.name.c_str());
+        }
+        return 0;
+    }
+
+    if (options.settings.csv)
+    {
+        std::printf("benchmark,events,items,runs,median_sec,items_per_sec,alloc_bytes_per_event,allocs_per_run,speedup\n");
+    }
+    else
+    {
+        std::printf("SIMD kernels: %s, threads: %zu\n", SimdKernelIsa, SharedThreadPool().ThreadCount());
+    }
+    try
+    {
+        for (std::size_t events : options.eventCounts)
+        {
+            BenchmarkData data{};
+            data.options = options.generator;
+            data.options.events = events;
+            data.store = GenerateEventStore(data.options);
+            const bool withEvents = events <= options.maxVectorEvents;
+            if (withEvents)
+            {
+                data.events = GenerateEventVector(data.options);
+            }
+
+            PrintBenchmarkHeader(data, options.settings);
+            std::map<std::string, double> medians{};
+            for (const Benchmark& benchmark : benchmarks)
+            {
+                if (benchmark.needsEvents && !withEvents)
+                {
+                    continue;
+                }
+                BenchmarkResult result = RunBenchmark(benchmark, data, options.settings);
+                medians[benchmark.name] = result.medianSec;
+                if (auto baseline = medians.find(benchmark.baseline); baseline != medians.end() && result.medianSec > 0.0)
+                {
+                    result.speedup = baseline->second / result.medianSec;
+                }
+                PrintBenchmarkResult(result, options.settings);
+            }
+        }
+    }
+    catch (const std::exception& error)
+    {
+        std::fprintf(stderr, "Benchmarks: %s\n", error.what());
+        return 1;
+    }
+    std::filesystem::remove(std::filesystem::temp_directory_path() / "esp_benchmark.evlog");
+    return 0;
+}
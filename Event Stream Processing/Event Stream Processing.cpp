@@ -1,13 +1,6 @@
 //Event Stream Processing
-//Simulate a log of timestamped events(sensor readings, actuator commands).You need to :
-//  Parse / store SimulationEvent structs.
-//  Sort them by time.
-//  Filter by event type or component.
-//  Accumulate values like total force, average RPM, etc.
-
-//Problem Prompt:
-//You are given a sequence of discrete simulation events representing actions or readings in a flight simulation environment.Each event is defined with EventType.
-//Write the functions using C++20 and STL algorithms :
+//Raylib front end: the event log window and its buttons. The engines and the original tasks (EventTasks.cpp)
+//live in the EventStreamCore library; EventStreamCli runs the same queries without a window.
 
 #include <iostream>
 #include <algorithm>   // for std::ranges::sort
@@ -17,320 +10,77 @@
 #include <unordered_map> 
 #include <numeric>   // for std::accumulate
 #include <functional>
+#include <random>
+#include <filesystem>
 
 extern "C" 
 {
 #include "raylib.h"
 }
 
-enum class EventType 
-{
-    SENSOR_READING,
-    CONTROL_INPUT,
-    ACTUATOR_COMMAND//2
-};
-
-struct SimulationEvent 
-{
-    double timestampSec{};        // Time in seconds since simulation start
-    EventType type{};             // What kind of event this is
-    std::string source{};         // e.g., "engine1", "rudder", etc.
-    double value{};               // A context-dependent value (e.g., throttle %, altitude)
-
-    void ConstructMockingSimulationEventVector(std::vector<SimulationEvent>& events)// Mocking a vector of SimulationEvent for testing purposes
-    {
-        events.push_back({ 5.0, EventType::ACTUATOR_COMMAND, "flaps", 15.0 });
-        events.push_back({1.5, EventType::CONTROL_INPUT, "pilot", 75.0});
-        events.push_back({ 10.5, EventType::CONTROL_INPUT, "pilot", 85.0 });
-        events.push_back({ 0.0, EventType::SENSOR_READING, "engine1", 100.0 });
-        events.push_back({3.2, EventType::SENSOR_READING, "altimeter", 5000.0});
-        events.push_back({4.5, EventType::CONTROL_INPUT, "pilot", 80.0});
-        events.push_back({ 9.2, EventType::SENSOR_READING, "altimeter", 6000.0 });
-        events.push_back({ 2.0, EventType::ACTUATOR_COMMAND, "rudder", 30.0 });
-        events.push_back({ 6.0, EventType::SENSOR_READING, "engine2", 110.0 });
-        events.push_back({ 7.5, EventType::CONTROL_INPUT, "pilot", 70.0 });
-        events.push_back({ 8.0, EventType::ACTUATOR_COMMAND, "aileron", 20.0 });
-	}
-};
-
-void PrintEvents(const std::vector<SimulationEvent>& events) 
-{
-    for (const auto& event : events) 
-    {
-        std::cout << "Timestamp: " << event.timestampSec
-            << ", Type: " << static_cast<int>(event.type)
-            << ", Source: " << event.source
-            << ", Value: " << event.value << '\n';
-    }
-    std::cout << std::endl << "----------------------------------------" << std::endl;
-}
-
-
-// ** TASKS **
-//1. Sort Events by Timestamp
-std::vector<SimulationEvent> SortByTime(const std::vector<SimulationEvent>& events)
-{
-    auto sorted{ events };
-
-    //std::ranges::sort(sorted, {}, sorted.timestampSec);//why wouldn't this work? => sorted is a vector of SimulationEvent, we need to look into each SimulationEvent to access the memeber timestampSec
-    std::ranges::sort(sorted, {}, &SimulationEvent::timestampSec);//and why are we using memeber pointer here? what are the underlying reason? what  are the rule of thumb for using memeber pointer as arguments? 
-    // => projection argument( how to extract a key from each element in the range): underneath is a pointer to member, so for each element in the range(each event), the projection access the members like this: | event.*(&SimulationEvent::timestampSec) |
-    // => is to say: "sort by this field"
-    return sorted;
-}
-
-std::vector<SimulationEvent> SortByTimeAndReturnACopy(const std::vector<SimulationEvent>& events)
-{
-    std::vector<SimulationEvent> sortedByTime{ events };
-    std::ranges::sort(sortedByTime, {}, &SimulationEvent::timestampSec);
-    return sortedByTime;
-}
-
-void SortEventsByTime(std::vector<SimulationEvent>& events)// Key STL concept: sort with a projection.
-{
-    std::cout << "SortEventsByTime, in-place" << "\n";
-
-    std::ranges::sort(events, {}, &SimulationEvent::timestampSec);//Sort events in ascending order using the value of timestampSec for comparison
-	PrintEvents(events);//NOTE: ranges::sort() is in-place
-}
-
-void SortEventsByTime(const std::vector<SimulationEvent>& events, bool isAscending = true)//is this const a legal overload?
-{
-    std::cout << "SortEventsByTime, value" << "\n";
-
-    std::vector<SimulationEvent> sortedByTimeEvents{ events };
-    if (isAscending)
-    {
-        std::ranges::sort(sortedByTimeEvents, {}, &SimulationEvent::timestampSec);
-    }
-    else
-    {
-        std::ranges::sort(sortedByTimeEvents, std::greater<double>(), &SimulationEvent::timestampSec);
-    }
-    PrintEvents(sortedByTimeEvents);//NOTE: ranges::sort() is in-place
-}
-
-// Explanation:
-// - std::ranges::sort is part of the new C++20 ranges library.
-// - It allows a "projection" function (the 3rd argument here), which is like saying:
-//     "please compare elements by their .timestamp field".
-// - Equivalent to writing a lambda: [](const auto& a, const auto& b) { return a.timestamp < b.timestamp; }
-// - But using `&SimulationEvent::timestamp` is more concise, idiomatic, and efficient.
-
-// ** QUESTIONS **
-//1. what does discrete means in "discrete simulation events"?
-//  => evolves in steps, not continuously, only log when something actually happens
-//2. std::ranges::sort(events, {}, &SimulationEvent::timestampSec); => what is the {} for?,  and what does 3rd argument called "projection" mean? shouldn't it mean comparison?
-//  => {} means empty which means default comparator, which is "<" aka "less than" which means sort in ascending order
-//3. is ranges::sort() in place? as in does it change the origianal data? what if the original data should not be changed?
-//  => yes, in-place, Make a copy first if don't want change
-
-
-//2. Filter Events by Source & Type
-std::vector<SimulationEvent> FilterByType(const std::vector<SimulationEvent>& events, EventType typeToFilter)
-{
-    std::cout << "FilterByType" << "\n";
-
-    std::vector<SimulationEvent> filtered{};
-
-    std::ranges::copy_if
-    (
-        events, 
-        std::back_inserter(filtered), //(source, output, predicate), predicate is a lambda, a condition
-        [typeToFilter](const SimulationEvent& ev)//have to capture the value of typeToFilter because lambda are saperate scope like a differernt function, not a normal codeblock; Copy elements from events into filtered
-        {//always const xxx& x, if we don't want to change the input
-            return ev.type == typeToFilter; // but only if their type == typeToFilter.
-        }
-    );//last arg: lambda predicate; captures typeToFilter by value
-
-    PrintEvents(filtered);
-    return filtered;
-}
-// Key idea: Use ranges::views::filter to create a lazy-filtered range
-// Then convert it into a new vector using ranges::to (in <ranges> in C++23,
-// or just use std::copy for C++20 fallback)
-
-// ** QUESTIONS **
-//1. std::ranges::copy_if()'s argument are crazy, can you break everything down? so much going on
-// => (source, output iteritor, lambda predicate)
-//2. why is type's value needs to be captured? doesn't it live inside copy_if()? which is inside the bigger function scope which should have access to the argument of the bigger function which have type already? how can I conceptulize lambda's scope and access?
-// => lambdas are separate function objects, not regular code blocks.
-
-//3. Group Events by Type/Source
-//Return a std::unordered_map<std::string, std::vector<SimulationEvent>> where each key is the source name.
-std::unordered_map<EventType, std::vector<SimulationEvent>> GroupByType(const std::vector<SimulationEvent>& events, const EventType& type)
-{
-    std::unordered_map<EventType, std::vector<SimulationEvent>> grouped{};
-
-    for (const auto& event : events)
-    {
-        grouped[event.type].push_back(event);
+#include "SimulationEvent.h"
+#include "EventTasks.h"
+#include "EventColumnStore.h"
+#include "EventAggregator.h"
+#include "EventViews.h"
+#include "TimeIndex.h"
+#include "FlatHashMap.h"
+#include "StreamIngestor.h"
+#include "WindowAggregator.h"
+#include "Pipeline.h"
+#include "QueryCache.h"
+#include "Query.h"
+#include "Instrumentation.h"
+#include "LogView.h"
+#include "QueryExecutor.h"
+#include "BinaryEventLog.h"
+#include "TextLogParser.h"
+
+
+// Draws only the lines on screen (LogView formats them on demand), so a frame costs the same for 30 events or 10M.
+// Mouse wheel scrolls 3 lines, Page Up/Down a page, Home/End jump to either end.
+void DrawEventLog(LogView& log, int x, int y, int lineHeight, Font font) {
+    const std::size_t visible = static_cast<std::size_t>(std::max(1, (GetScreenHeight() - 20 - y) / lineHeight));
+    const auto page = static_cast<std::ptrdiff_t>(visible);
+    if (float wheel = GetMouseWheelMove(); wheel != 0.0f) log.ScrollBy(static_cast<std::ptrdiff_t>(-wheel * 3.0f), visible);
+    if (IsKeyPressed(KEY_PAGE_DOWN)) log.ScrollBy(page, visible);
+    if (IsKeyPressed(KEY_PAGE_UP)) log.ScrollBy(-page, visible);
+    if (IsKeyPressed(KEY_HOME)) log.ScrollTo(0, visible);
+    if (IsKeyPressed(KEY_END)) log.ScrollTo(log.Size(), visible);
+
+    const std::size_t end = std::min(log.Size(), log.Top() + visible);
+    for (std::size_t line = log.Top(); line < end; ++line) {
+        DrawTextEx(font, log.Line(line).c_str(), { (float)x, (float)(y + (line - log.Top()) * lineHeight) }, 18, 1, LIGHTGRAY);
     }
-    //learned from mistake: what is the value's structure? need to put more thoughts into that, I initally made the value as one event which of course is not right, it's a vector of events, make sense if I just take a minute to think about it, each group SHOULD have MULTIPLE events!
-    return grouped;
-}
-
-std::unordered_map<std::string, std::vector<SimulationEvent>> GroupBySource(const std::vector<SimulationEvent>& events)
-{
-    std::unordered_map<std::string, std::vector<SimulationEvent>> grouped{};
 
-    for (const SimulationEvent& event : events)
-    {
-        grouped[event.source].push_back(event);//would this make a new key pair if have not seen it before?
+    if (log.Size() > visible) {// scroll bar: the thumb is the visible share of the log, never thinner than 8 px
+        const float trackX = (float)(GetScreenWidth() - 12), trackHeight = (float)(visible * lineHeight);
+        const float thumbHeight = std::max(8.0f, trackHeight * visible / log.Size());
+        const float thumbY = y + (trackHeight - thumbHeight) * log.Top() / (log.Size() - visible);
+        DrawRectangleRec({ trackX, (float)y, 6, trackHeight }, DARKGRAY);
+        DrawRectangleRec({ trackX, thumbY, 6, thumbHeight }, LIGHTGRAY);
+        const std::string position = "Lines " + std::to_string(log.Top() + 1) + "-" + std::to_string(end) + " of " + std::to_string(log.Size());
+        DrawTextEx(font, position.c_str(), { (float)(GetScreenWidth() - 20) - MeasureTextEx(font, position.c_str(), 16, 1).x, 80.0f }, 16, 1, GRAY);
     }
-    return grouped;
-    //{
-    //{"sources", [event0, event2]}, 
-    //{"source1", [event1, event4]},
-    //...
-    //}
 }
 
-std::unordered_map<std::string, std::vector<SimulationEvent>> GroupBySources(const std::vector<SimulationEvent>& events)
-{
-    //pre. translate into a hashmap
-    //1. loop through, 
-    //2. add into Grouped by it's source
-    std::unordered_map<std::string, std::vector<SimulationEvent>> GroupedBySource{};//{ key: "source", value: {event0, event1, event2 }
-    for (const SimulationEvent& event : events)
-    {
-            GroupedBySource[event.source].push_back(event);//[] operator is overloaded, it'll add new key and new values if not exist yet => side effect: if look up with [] it will add the key, use .find() instead
-    }
-    return GroupedBySource;
-}
-// We want to group all events that came from the same source string.
-// A map from string (source) to vector of events is the natural structure.
-
-//4. Compute Total Value for a Given Source, Return the sum of.value for a specific source.
-double Acumulate(const std::vector<SimulationEvent>& events, const std::string& source)
-{
-    return std::accumulate(events.begin(), events.end(), 0.0,
-        [&source](double sum, const SimulationEvent& event)
-        {
-            return sum + (event.source == source ? event.value : 0.0);
-        });
-}
-
-double AcumulatebySource(const std::vector<SimulationEvent>& events, const EventType& type)
-{
-    return std::accumulate(events.begin(), events.end(), 0.0,
-        [&type](double sum, const SimulationEvent& event)//what is the rule comes to the const XXX& parameter in a lambda function? => same with normal function: 1. non-trival to copy. 2. don't wish to mutate original
-        //why not const double& xx => avoid pointer-indriection, compiler can make it pass-by-register(by value but do not involve copying, CPU's register can just store the double and other primare types),
-        //which is cheaper than passing by reference; because passing by reference still need to pass the pointer); pass-by-register is 0-1 cpu cycles(no memory lookup), pass-by-reference takes 1-4 cycles
-        {
-            return sum + (type == event.type ? event.value : 0.0);//why do we have to return for the second time? => this lambda return's a value to the std::acumulate() at each step(with a new sum each time for the algo)
-        });
-}
-
-double AcumulateTotalBySource(const std::vector<SimulationEvent>& events, const std::string& source)
-{
-    return std::accumulate(events.begin(), events.end(), 0.0,
-        [&source](double sum, const SimulationEvent& event)
-        {
-            return sum + (event.source == source ? event.value : 0.0);
-        }
-    );
-}
-
-double AccumalateValueBySource(const std::vector<SimulationEvent>& events, const std::string& source)
-{
-    return std::accumulate(events.begin(), events.end(), 0.0,//start with the return?? is this the only way to write?
-        [&source](double sum, const SimulationEvent& event)//You MUST follow the signature that accumulate(): (accumulated_value, current_element)
-            { 
-                return sum + (event.source == source ? event.value : 0.0);//does the lamdbda HAVE to be in this format??
-                //=> YES, in the case of this lambda's parameters 
-                //the body of lamdbda tells the acumulate() HOW to combine them
-                //MUST return the updated accumulator.
-            }
-        );//how can I conceptualize it? so hard to memerize the syntax, for the lambda, what is the thought process behind the syntax?
-}
-
-double ComputeTotalValueBySource(const std::vector<SimulationEvent>& events, const std::string& source)
-{
-    return std::accumulate(events.begin(), events.end(), 0.0,
-        [&source](double sum, const SimulationEvent& event)
-        {
-            return sum + (event.source == source ? event.value : 0.0);
-        }
-    );//accuulte()'s 4th argument need to be a bool operation
-}
-
-//5. Find the First Event After a Time Threshold
-//Return a pointer to the first event after a given timestamp(or nullptr if none found).
-const SimulationEvent* FirstEvent(const std::vector<SimulationEvent>& events, double time)
-{
-    auto iterator = std::ranges::find_if(events,
-        [&time](const SimulationEvent& event)
-        {
-            return event.timestampSec > time;
-        });
-
-    //return iterator != events.end() ? &(*iterator) : nullptr;
-    return iterator != events.end() ? std::to_address(iterator) : nullptr;
-}
-
-const SimulationEvent* FirstEventAfter(const std::vector<SimulationEvent>& events, double thresholdTime)//const SimulationEvent* return a pointer to the event, but I never seen this syntax before, is this regular?
-//returning a pointer to a 'const SimulationEvent', the caller can read, but can not mutate, AKA returning a read only pointer; plus, can return a nullptr if no valid object exits
-{
-    auto it = std::ranges::find_if(events,//find more info on find_if() basics, argument types, lambda requirments, qurik etc
-        //=> (range, unary predicate), returns a iterator, returns .end() if not found
-                [&thresholdTime](const SimulationEvent& event)//HAVE TO BE: take one argument(element matches container's type), and return a bool
-                {
-                    return event.timestampSec > thresholdTime;//true for the matching case
-                });
-
-    return (it != events.end()) ? &(*it) : nullptr;//why compare to the last iterator? 
-    // => MUST check valid before access it, .end() indicate invaild found
-    //what is this??&(*it)
-    // => *it: dereference it to get the actual event
-    // &(): get the address of the event; AKA, a pointer
-    // NOTE: I have the wrong Conception that a literator is a pointer
-    // => A pointer is a kind of iterator, but not all iterators are pointers. => a iterator is a pointer with some logics built in; some cannot just be dereferenced
-}
-
-const SimulationEvent* FirstEventAfterThis(
-    const std::vector<SimulationEvent>& events,
-    double thresholdTime)
-{
-    // Use std::ranges::find_if to find the first event where timestamp > threshold
-    auto it = std::ranges::find_if(events,
-        [thresholdTime](const SimulationEvent& ev) {
-            return ev.timestampSec > thresholdTime;
-        });
-
-    // Return a pointer if found, or nullptr if not
-    return (it != events.end()) ? &(*it) : nullptr;
-}
-
-std::string EventTypeToString(EventType type) {
-    switch (type) {
-    case EventType::SENSOR_READING: return "SENSOR_READING";
-    case EventType::CONTROL_INPUT: return "CONTROL_INPUT";
-    case EventType::ACTUATOR_COMMAND: return "ACTUATOR_COMMAND";
-    default: return "UNKNOWN";
-    }
-}
-
-void DrawEventLog(const std::vector<std::string>& logs, int x, int y, int lineHeight, Font font) {
-    int line = 0;
-    for (const auto& log : logs) {
-        DrawTextEx(font, log.c_str(), { (float)x, (float)(y + line * lineHeight) }, 18, 1, LIGHTGRAY);
-        line++;
-        if (y + line * lineHeight > GetScreenHeight() - 20) break;
+// The log named on the command line (.evlog memory-mapped, anything else read as a text log), or the mock log.
+EventColumnStore LoadEventLog(int argc, char** argv) {
+    if (argc > 1) {
+        const std::filesystem::path path{ argv[1] };
+        return path.extension() == ".evlog" ? LoadBinaryEventLog(path) : LoadTextLog(path);
     }
+    std::vector<SimulationEvent> events{};
+    SimulationEvent{}.ConstructMockingSimulationEventVector(events);
+    PrintEvents(events);
+    return EventColumnStore{ events };
 }
 
-// --- Helper to format events for log ---
-std::vector<std::string> FormatEvents(const std::vector<SimulationEvent>& events) {
-    std::vector<std::string> logs;
-    for (const auto& event : events) {
-        logs.push_back("T: " + std::to_string(event.timestampSec) +
-            " | " + EventTypeToString(event.type) +
-            " | " + event.source +
-            " | " + std::to_string(event.value));
-    }
-    return logs;
-}
+// What a button's query hands back to the frame loop: the new log and the "Last Action" text.
+struct LogUpdate {
+    LogView log{};
+    std::string action{};
+};
 
 // --- Raylib Button Helper ---
 bool Button(int x, int y, int w, int h, const char* text, Font font) {
@@ -344,12 +94,16 @@ bool Button(int x, int y, int w, int h, const char* text, Font font) {
     return hovered && IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
 }
 
-int main()
+int main(int argc, char** argv)
 {
-	SimulationEvent event;
-    std::vector<SimulationEvent> events{};
-    event.ConstructMockingSimulationEventVector(events);
-	PrintEvents(events);
+    EventColumnStore store = LoadEventLog(argc, argv);// every button queries this; the log view shows its rows
+    TimeIndex timeIndex{ store };// built once, every time lookup below is a binary search
+
+    // Live ingestion demo: jittered events go through the reorder buffer and land in liveStore already sorted.
+    EventColumnStore liveStore{ std::make_shared<SourceDictionary>() };// its own dictionary: queries read store's from a worker
+    StreamIngestor ingestor{ liveStore, { 16, 1.0 } };
+    std::mt19937 jitterEngine{ 42 };
+    double liveClock = 0.0;
 
     std::cout << "Hello Simulated World!\n";
 
@@ -365,95 +119,248 @@ int main()
 
     SetTargetFPS(60);
 
-    std::vector<std::string> eventLog = FormatEvents(events);
-    std::string lastAction = "Initial event log.";
+    // Buttons submit their query to a worker and the window keeps drawing; the result is swapped in when it is ready.
+    // A query only reads store and timeIndex, which never change after this point, and runs one at a time, so the
+    // cache needs no lock. A click while one runs cancels it.
+    QueryCache storeCache{ store };// repeated button presses are answered from here instead of rescanning the log
+    QueryCache liveCache{ liveStore };// render thread only: refreshed incrementally after every ingest
+    QueryExecutor<LogUpdate> queries{};// declared after what the queries use: its destructor waits for the running one
+
+    LogUpdate shown{};// the front buffer: what the window draws
+    shown.log.AddAllRows(store);
+    shown.action = "Initial event log.";
+
+    // The quick, render-thread-only actions (live ingestion, metrics, reset) replace the log directly.
+    auto showNow = [&queries, &shown](LogUpdate update) {
+        queries.Cancel();
+        shown = std::move(update);
+    };
 
     while (!WindowShouldClose())
     {
+        queries.SwapResult(shown);
+
         BeginDrawing();
         ClearBackground(BLACK);
 
         DrawTextEx(nasaFont, "Simulation Event Log", { 20, 20 }, 28, 1, YELLOW);
+        DrawFPS(screenWidth - 100, 20);
 
         // --- Buttons ---
         int bx = 20, by = 60, bw = 220, bh = 32, gap = 8;
         int buttonY = by;
         if (Button(bx, buttonY, bw, bh, "Sort By Time (Asc)", nasaFont)) {
-            auto sorted = SortByTime(events);
-            eventLog = FormatEvents(sorted);
-            lastAction = "Sorted by time ascending.";
+            queries.Submit("Sort By Time (Asc)", [&store](QueryProgress& progress) {
+                LogUpdate update{};
+                progress.Report(0.0, "radix sort");
+                update.log.AddRows(store, SortedOrderByTime(store));// permutation only, lines are formatted as they scroll into view
+                update.action = "Sorted by time ascending.";
+                return update;
+            });
         }
         buttonY += bh + gap;
         if (Button(bx, buttonY, bw, bh, "Sort By Time (Desc)", nasaFont)) {
-            auto sorted = events;
-            std::ranges::sort(sorted, std::greater<double>(), &SimulationEvent::timestampSec);
-            eventLog = FormatEvents(sorted);
-            lastAction = "Sorted by time descending.";
+            queries.Submit("Sort By Time (Desc)", [&store](QueryProgress& progress) {
+                LogUpdate update{};
+                progress.Report(0.0, "radix sort");
+                update.log.AddRows(store, SortedOrderByTime(store, false));
+                update.action = "Sorted by time descending.";
+                return update;
+            });
         }
         buttonY += bh + gap;
-        if (Button(bx, buttonY, bw, bh, "Filter: SENSOR_READING", nasaFont)) {
-            auto filtered = FilterByType(events, EventType::SENSOR_READING);
-            eventLog = FormatEvents(filtered);
-            lastAction = "Filtered SENSOR_READING.";
+        for (EventType type : { EventType::SENSOR_READING, EventType::CONTROL_INPUT, EventType::ACTUATOR_COMMAND }) {
+            const std::string name = EventTypeToString(type);
+            if (Button(bx, buttonY, bw, bh, ("Filter: " + name).c_str(), nasaFont)) {
+                queries.Submit("Filter: " + name, [&store, &storeCache, type, name](QueryProgress& progress) {
+                    LogUpdate update{};
+                    progress.Report(0.0, "selecting");
+                    update.log.AddRows(store, storeCache.Select({ QueryAggregate::Count, type }));
+                    update.action = "Filtered " + name + ".";
+                    return update;
+                });
+            }
+            buttonY += bh + gap;
+        }
+        if (Button(bx, buttonY, bw, bh, "Group By Source", nasaFont)) {
+            queries.Submit("Group By Source", [&store, &storeCache](QueryProgress& progress) {
+                LogUpdate update{};
+                progress.Report(0.0, "grouping");
+                const auto& grouped = storeCache.GroupBySourceId();// built on the first press, then a cache hit
+                for (SourceId id = 0; id < grouped.size(); ++id) {
+                    if (progress.Cancelled()) break;
+                    progress.Report(0.5 + 0.5 * id / grouped.size(), "building the view");
+                    if (grouped[id].empty()) continue;
+                    update.log.AddLine("Source: " + store.SourceName(id));
+                    update.log.AddRows(store, grouped[id], "  ");
+                }
+                update.action = "Grouped by source.";
+                return update;
+            });
         }
         buttonY += bh + gap;
-        if (Button(bx, buttonY, bw, bh, "Filter: CONTROL_INPUT", nasaFont)) {
-            auto filtered = FilterByType(events, EventType::CONTROL_INPUT);
-            eventLog = FormatEvents(filtered);
-            lastAction = "Filtered CONTROL_INPUT.";
+        if (Button(bx, buttonY, bw, bh, "Total Value: engine1", nasaFont)) {
+            queries.Submit("Total Value: engine1", [&store, &storeCache](QueryProgress& progress) {
+                LogUpdate update{};
+                progress.Report(0.0, "summing");
+                if (auto engine = store.FindSource("engine1")) {
+                    double total = storeCache.Run({ QueryAggregate::Sum, {}, engine });
+                    update.log.AddLine("Total value for engine1: " + std::to_string(total));
+                }
+                else {
+                    update.log.AddLine("No events from engine1.");
+                }
+                update.action = "Computed total value for engine1.";
+                return update;
+            });
         }
         buttonY += bh + gap;
-        if (Button(bx, buttonY, bw, bh, "Filter: ACTUATOR_COMMAND", nasaFont)) {
-            auto filtered = FilterByType(events, EventType::ACTUATOR_COMMAND);
-            eventLog = FormatEvents(filtered);
-            lastAction = "Filtered ACTUATOR_COMMAND.";
+        if (Button(bx, buttonY, bw, bh, "Stats By Source", nasaFont)) {
+            queries.Submit("Stats By Source", [&store, &storeCache](QueryProgress& progress) {
+                LogUpdate update{};
+                progress.Report(0.0, "aggregating");
+                const AggregateReport& report = storeCache.Aggregates();// one pass for every source, the first time only
+                for (SourceId id = 0; id < report.bySource.size(); ++id) {
+                    const AggregateStats& stats = report.Source(id);
+                    if (stats.Empty()) continue;
+                    update.log.AddLine(store.SourceName(id) +
+                        " | n: " + std::to_string(stats.count) +
+                        " | sum: " + std::to_string(stats.sum) +
+                        " | mean: " + std::to_string(stats.mean) +
+                        " | min: " + std::to_string(stats.min) +
+                        " | max: " + std::to_string(stats.max) +
+                        " | sd: " + std::to_string(stats.StdDev()));
+                }
+                update.action = "Computed stats for every source.";
+                return update;
+            });
         }
         buttonY += bh + gap;
-        if (Button(bx, buttonY, bw, bh, "Group By Source", nasaFont)) {
-            auto grouped = GroupBySource(events);
-            eventLog.clear();
-            for (const auto& [src, evs] : grouped) {
-                eventLog.push_back("Source: " + src);
-                for (const auto& e : evs) {
-                    eventLog.push_back("  T: " + std::to_string(e.timestampSec) +
-                        " | " + EventTypeToString(e.type) +
-                        " | " + std::to_string(e.value));
+        if (Button(bx, buttonY, bw, bh, "First Event After 5s", nasaFont)) {
+            queries.Submit("First Event After 5s", [&store, &timeIndex](QueryProgress&) {
+                LogUpdate update{};
+                auto row = FirstEventAfter(store, timeIndex, 5.0);
+                if (row) {
+                    update.log.AddLine("First event after 5s:");
+                    update.log.AddLine(FormatEventLine(store, *row));
                 }
-            }
-            lastAction = "Grouped by source.";
+                else {
+                    update.log.AddLine("No event found after 5s.");
+                }
+                update.action = "Found first event after 5s.";
+                return update;
+            });
         }
         buttonY += bh + gap;
-        if (Button(bx, buttonY, bw, bh, "Total Value: engine1", nasaFont)) {
-            double total = ComputeTotalValueBySource(events, "engine1");
-            eventLog = { "Total value for engine1: " + std::to_string(total) };
-            lastAction = "Computed total value for engine1.";
+        if (Button(bx, buttonY, bw, bh, "Events In [5s, 10s)", nasaFont)) {
+            queries.Submit("Events In [5s, 10s)", [&store, &timeIndex](QueryProgress&) {
+                LogUpdate update{};
+                update.log.AddRows(store, timeIndex.Range(5.0, 10.0));
+                update.action = "Listed events between 5s and 10s.";
+                return update;
+            });
         }
         buttonY += bh + gap;
-        if (Button(bx, buttonY, bw, bh, "First Event After 5s", nasaFont)) {
-            auto ptr = FirstEventAfter(events, 5.0);
-            eventLog.clear();
-            if (ptr) {
-                eventLog.push_back("First event after 5s:");
-                eventLog.push_back("T: " + std::to_string(ptr->timestampSec) +
-                    " | " + EventTypeToString(ptr->type) +
-                    " | " + ptr->source +
-                    " | " + std::to_string(ptr->value));
+        if (Button(bx, buttonY, bw, bh, "Ingest Live Events", nasaFont)) {
+            std::uniform_real_distribution<double> jitter(-0.4, 0.4);
+            for (int i = 0; i < 25; ++i) {
+                liveClock += 0.1;
+                double arrival = liveClock + jitter(jitterEngine);
+                if (i == 24) arrival -= 3.0;// one straggler per batch, far behind the watermark
+                ingestor.Ingest({ arrival, EventType::SENSOR_READING, "engine1", 100.0 + i });
             }
-            else {
-                eventLog.push_back("No event found after 5s.");
+            const IngestStats& stats = ingestor.Stats();
+            LogUpdate update{};
+            update.log.AddLine("Received: " + std::to_string(stats.received) + " | Released: " + std::to_string(stats.released) +
+                " | Buffered: " + std::to_string(ingestor.Pending()));
+            update.log.AddLine("Reordered: " + std::to_string(stats.reordered) + " | Late: " + std::to_string(stats.late) +
+                " | Max lateness: " + std::to_string(stats.maxLatenessSec) + "s");
+            update.log.AddLine("Latest released events:");
+            auto timestamps = liveStore.Timestamps();
+            auto values = liveStore.Values();
+            for (std::size_t row = liveStore.Size() > 15 ? liveStore.Size() - 15 : 0; row < liveStore.Size(); ++row) {
+                update.log.AddLine("  T: " + std::to_string(timestamps[row]) + " | " + std::to_string(values[row]));
             }
-            lastAction = "Found first event after 5s.";
+            const std::uint64_t scannedBefore = liveCache.Stats().rowsScanned;
+            const AggregateStats& live = liveCache.Aggregates().overall;// folds in only the events released by this batch
+            update.log.AddLine("Live totals: n: " + std::to_string(live.count) + " | mean: " + std::to_string(live.mean) +
+                " | max: " + std::to_string(live.max) + " (" + std::to_string(liveCache.Stats().rowsScanned - scannedBefore) + " new rows read)");
+            update.action = "Ingested 25 live events.";
+            showNow(std::move(update));
+        }
+        buttonY += bh + gap;
+        if (Button(bx, buttonY, bw, bh, "10s Sensor Averages", nasaFont)) {
+            queries.Submit("10s Sensor Averages", [&store](QueryProgress& progress) {
+                // filter -> group by source -> tumbling window, pushed through in 4K-event batches with no vector in between
+                std::vector<WindowResult> windows;
+                Pipeline pipeline{};
+                pipeline.Then<FilterByTypeOperator>(EventType::SENSOR_READING);
+                pipeline.Then<GroupBySourceOperator>([&windows](SourceId) {
+                    return std::make_unique<WindowOperator>(WindowOptions{ 10.0, 10.0, WindowKey::Source },
+                        [&windows](const WindowResult& window) { windows.push_back(window); });
+                });
+                progress.Report(0.0, "sorting");
+                auto order = SortedOrderByTime(store);
+                progress.Report(0.3, "windowing");
+                PushOrdered(store, order, pipeline);
+
+                progress.Report(0.8, "formatting");
+                std::ranges::stable_sort(windows, {}, &WindowResult::startSec);// each source emits on its own; interleave by window
+                LogUpdate update{};
+                for (const WindowResult& window : windows) {
+                    if (progress.Cancelled()) break;
+                    update.log.AddLine("[" + std::to_string(window.startSec) + "s, " + std::to_string(window.endSec) + "s) " +
+                        store.SourceName(*window.sourceId) +
+                        " | n: " + std::to_string(window.count) +
+                        " | avg: " + std::to_string(window.Mean()) +
+                        " | total: " + std::to_string(window.sum));
+                }
+                update.action = "Averaged sensor readings per source over 10-second windows.";
+                return update;
+            });
+        }
+        buttonY += bh + gap;
+        if (Button(bx, buttonY, bw, bh, "Show Metrics", nasaFont)) {
+            LogUpdate update{};
+            update.log.AddLine("operation | calls | events | p50 | p99 | max (us)");
+            Metrics().ForEach([&update](const OperationMetrics& operation) {
+                const LatencyHistogram& latency = operation.latency;
+                if (latency.Count() == 0) return;
+                update.log.AddLine(operation.name +
+                    " | " + std::to_string(latency.Count()) +
+                    " | " + std::to_string(operation.events.Value()) +
+                    " | " + std::to_string(latency.Percentile(0.5) / 1000.0) +
+                    " | " + std::to_string(latency.Percentile(0.99) / 1000.0) +
+                    " | " + std::to_string(latency.MaxNanoseconds() / 1000.0));
+            });
+            update.action = "Showed the latency of every operation run so far.";
+            showNow(std::move(update));
         }
         buttonY += bh + gap;
         if (Button(bx, buttonY, bw, bh, "Reset Log", nasaFont)) {
-            eventLog = FormatEvents(events);
-            lastAction = "Reset to initial event log.";
+            LogUpdate update{};
+            update.log.AddAllRows(store);
+            update.action = "Reset to initial event log.";
+            showNow(std::move(update));
         }
 
         // --- Log Output ---
+        const int logX = bx + bw + 40;
+        const QueryStatus status = queries.Status();
+        std::string action = "Last Action: " + shown.action;
+        if (status.running) {
+            action = TextFormat("Running %s... %.1fs", status.name.c_str(), status.elapsedSec);
+            const float barWidth = 200.0f;
+            DrawRectangleLines(logX, 82, static_cast<int>(barWidth), 12, DARKGRAY);
+            DrawRectangleRec({ static_cast<float>(logX + 1), 83.0f, (barWidth - 2) * static_cast<float>(status.fraction), 10.0f }, SKYBLUE);
+            DrawTextEx(nasaFont, std::string{ status.stage }.c_str(), { static_cast<float>(logX) + barWidth + 10, 80.0f }, 16, 1, GRAY);
+        }
+        else if (!status.error.empty()) {
+            action = status.name + " failed: " + status.error;
+        }
         //DrawTextEx(nasaFont, ("Last Action: " + lastAction).c_str(), { bx + bw + 40, 60 }, 20, 1, GREEN);
-        DrawTextEx(nasaFont, ("Last Action: " + lastAction).c_str(), { static_cast<float>(bx + bw + 40), 60.0f }, 20, 1, GREEN);
-        DrawEventLog(eventLog, bx + bw + 40, 100, 24, nasaFont);
+        DrawTextEx(nasaFont, action.c_str(), { static_cast<float>(logX), 60.0f }, 20, 1, status.error.empty() ? GREEN : RED);
+        DrawEventLog(shown.log, logX, 100, 24, nasaFont);
 
         EndDrawing();
     }
@@ -0,0 +1,564 @@
+// Headless batch front end: loads a log, runs one query over it and writes the result, with no window and no frame loop.
+//
+//   EventStreamCli stats --input flight.evlog
+//   EventStreamCli query --input flight.csv --aggregate mean --type SENSOR_READING --source engine1 --from 5 --to 10
+//   EventStreamCli select --input flight.csv --type ACTUATOR_COMMAND --sort --output actuators.csv
+//   EventStreamCli windows --generate 10000000 --sources 256 --size 10 --slide 1 --key source
+//   EventStreamCli convert --input flight.csv --output flight.evlog                   # also writes flight.evlog.zones
+//   EventStreamCli resample --input flight.evlog --type SENSOR_READING --step 0.01 --output aligned.csv
+//   EventStreamCli partial --input fleet.evlog --shard 2/8 --shard-key source --output shard2.part   # on each node
+//   EventStreamCli merge --partial shard0.part --partial shard1.part ...                            # on the coordinator
+//
+// Results go to --output (default stdout) as CSV; select writes a text log that --input reads back.
+// Load and run times go to stderr, so they never mix with the results.
+// --metrics FILE dumps the per-operation latencies and counters (Instrumentation.h) after the run, - for stderr;
+// --metrics-format prometheus writes them for a node_exporter textfile collector instead.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "BinaryEventLog.h"
+#include "EventAggregator.h"
+#include "EventColumnStore.h"
+#include "EventGenerator.h"
+#include "Instrumentation.h"
+#include "ParallelAlgorithms.h"
+#include "Query.h"
+#include "Resample.h"
+#include "ShardedAggregation.h"
+#include "SimulationEvent.h"
+#include "TextLogParser.h"
+#include "ThreadPool.h"
+#include "WindowAggregator.h"
+#include "ZoneMap.h"
+
+// ** Command line **
+
+enum class CliCommand : std::uint8_t
+{
+    Stats,
+    Query,
+    Select,
+    Windows,
+    Convert,
+    Resample,
+    Partial,
+    Merge
+};
+
+struct CliOptions
+{
+    CliCommand command{ CliCommand::Stats };
+    std::filesystem::path input{};              // empty: --generate, or the mock log
+    char delimiter{ ',' };
+    std::optional<EventGeneratorOptions> generate{};
+    std::filesystem::path output{};             // empty: stdout
+    QueryAggregate aggregate{ QueryAggregate::Sum };
+    std::optional<EventType> type{};
+    std::optional<std::string> source{};
+    std::optional<double> fromSec{};
+    std::optional<double> toSec{};
+    bool sort{};
+    WindowOptions window{};
+    double stepSec{};                           // resample grid spacing
+    ResampleOptions resample{};
+    ShardPlan shardPlan{};                      // partial: which share of the input this node aggregates
+    std::size_t shard{};
+    std::vector<std::filesystem::path> partials{};// merge: the nodes' partial states
+    std::size_t threads{ std::max<std::size_t>(1, std::thread::hardware_concurrency()) };
+    bool quiet{};
+    std::string metrics{};                      // empty: none, "-": stderr
+    bool prometheus{};
+};
+
+static constexpr std::string_view Usage =
+    "usage: EventStreamCli <stats|query|select|windows|convert|resample|partial|merge> [options]\n"
+    "  stats                 count, sum, mean, min, max, sd per source and per type\n"
+    "  query                 one aggregate over the filtered events: --aggregate sum|count|min|max|mean\n"
+    "  select                the filtered events as a text log; --sort orders them by time\n"
+    "  windows               --size SEC [--slide SEC] [--key all|source|type|source-type]\n"
+    "  convert               the whole input as a binary .evlog (needs --output), and its zone map as .evlog.zones\n"
+    "  resample              every source on one time grid: --step SEC [--hold] [--no-clamp], one column per source\n"
+    "  partial               this node's share of the stats as a binary partial state (needs --output):\n"
+    "                        --shard I/N (default 0/1) --shard-key source|time (time: cuts --from..--to into N ranges)\n"
+    "  merge                 the stats of every --partial FILE (repeat it), merged as one log's\n"
+    "input (default: the built-in mock log):\n"
+    "  --input FILE          .evlog is memory-mapped (query/select skip blocks through its .zones file when it matches),\n"
+    "                        anything else is read as a text log\n"
+    "  --delimiter C         text log field delimiter (default ',')\n"
+    "  --generate N          N synthetic events, shaped by --sources N --disorder SEC --seed N\n"
+    "filters (query, select): --type NAME --source NAME --from SEC --to SEC (resample: --type, and --from/--to bound the grid)\n"
+    "output: --output FILE (default stdout), --threads N, --quiet (no timings on stderr)\n"
+    "metrics: --metrics FILE|- (operation latencies after the run), --metrics-format text|prometheus\n";
+
+static CliCommand ParseCommand(std::string_view name)
+{
+    if (name == "stats") return CliCommand::Stats;
+    if (name == "query") return CliCommand::Query;
+    if (name == "select") return CliCommand::Select;
+    if (name == "windows") return CliCommand::Windows;
+    if (name == "convert") return CliCommand::Convert;
+    if (name == "resample") return CliCommand::Resample;
+    if (name == "partial") return CliCommand::Partial;
+    if (name == "merge") return CliCommand::Merge;
+    throw std::invalid_argument("unknown command " + std::string{ name });
+}
+
+static QueryAggregate ParseAggregate(std::string_view name)
+{
+    if (name == "sum") return QueryAggregate::Sum;
+    if (name == "count") return QueryAggregate::Count;
+    if (name == "min") return QueryAggregate::Min;
+    if (name == "max") return QueryAggregate::Max;
+    if (name == "mean") return QueryAggregate::Mean;
+    throw std::invalid_argument("unknown aggregate " + std::string{ name });
+}
+
+static ShardKey ParseShardKey(std::string_view name)
+{
+    if (name == "source") return ShardKey::Source;
+    if (name == "time") return ShardKey::Time;
+    throw std::invalid_argument("unknown shard key " + std::string{ name });
+}
+
+static WindowKey ParseWindowKey(std::string_view name)
+{
+    if (name == "all") return WindowKey::All;
+    if (name == "source") return WindowKey::Source;
+    if (name == "type") return WindowKey::Type;
+    if (name == "source-type") return WindowKey::SourceAndType;
+    throw std::invalid_argument("unknown window key " + std::string{ name });
+}
+
+static CliOptions ParseCommandLine(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        throw std::invalid_argument("missing command");
+    }
+
+    CliOptions options{};
+    options.command = ParseCommand(argv[1]);
+    bool slideGiven = false;
+    auto generator = [&options]() -> EventGeneratorOptions& { return options.generate ? *options.generate : options.generate.emplace(); };
+    for (int index = 2; index < argc; ++index)
+    {
+        const std::string_view argument{ argv[index] };
+        auto value = [&]() -> std::string
+        {
+            if (index + 1 >= argc)
+            {
+                throw std::invalid_argument(std::string{ argument } + " needs a value");
+            }
+            return argv[++index];
+        };
+
+        if (argument == "--input") options.input = value();
+        else if (argument == "--delimiter")
+        {
+            const std::string delimiter = value();
+            if (delimiter.size() != 1)
+            {
+                throw std::invalid_argument("--delimiter takes one character");
+            }
+            options.delimiter = delimiter[0];
+        }
+        else if (argument == "--generate") generator().events = static_cast<std::size_t>(std::stod(value()));// stod: "1e8" works too
+        else if (argument == "--sources") generator().sources = std::stoul(value());
+        else if (argument == "--disorder") generator().disorderSec = std::stod(value());
+        else if (argument == "--seed") generator().seed = std::stoull(value());
+        else if (argument == "--output") options.output = value();
+        else if (argument == "--aggregate") options.aggregate = ParseAggregate(value());
+        else if (argument == "--type")
+        {
+            const std::string name = value();
+            options.type = EventTypeFromString(name);
+            if (!options.type)
+            {
+                throw std::invalid_argument("unknown event type " + name);
+            }
+        }
+        else if (argument == "--source") options.source = value();
+        else if (argument == "--from") options.fromSec = std::stod(value());
+        else if (argument == "--to") options.toSec = std::stod(value());
+        else if (argument == "--sort") options.sort = true;
+        else if (argument == "--size") options.window.sizeSec = std::stod(value());
+        else if (argument == "--slide") { options.window.slideSec = std::stod(value()); slideGiven = true; }
+        else if (argument == "--key") options.window.key = ParseWindowKey(value());
+        else if (argument == "--step") options.stepSec = std::stod(value());
+        else if (argument == "--hold") options.resample.mode = ResampleMode::Hold;
+        else if (argument == "--no-clamp") options.resample.clampEdges = false;
+        else if (argument == "--shard")
+        {
+            const std::string shard = value();
+            const std::size_t slash = shard.find('/');
+            if (slash == std::string::npos)
+            {
+                throw std::invalid_argument("--shard takes I/N");
+            }
+            options.shard = std::stoul(shard.substr(0, slash));
+            options.shardPlan.shardCount = std::stoul(shard.substr(slash + 1));
+        }
+        else if (argument == "--shard-key") options.shardPlan.key = ParseShardKey(value());
+        else if (argument == "--partial") options.partials.emplace_back(value());
+        else if (argument == "--threads") options.threads = std::max<std::size_t>(1, std::stoul(value()));
+        else if (argument == "--quiet") options.quiet = true;
+        else if (argument == "--metrics") options.metrics = value();
+        else if (argument == "--metrics-format")
+        {
+            const std::string format = value();
+            if (format != "text" && format != "prometheus")
+            {
+                throw std::invalid_argument("unknown metrics format " + format);
+            }
+            options.prometheus = format == "prometheus";
+        }
+        else
+        {
+            throw std::invalid_argument("unknown option " + std::string{ argument });
+        }
+    }
+
+    if (!slideGiven)
+    {
+        options.window.slideSec = options.window.sizeSec;// tumbling unless asked otherwise
+    }
+    if (!options.input.empty() && options.generate)
+    {
+        throw std::invalid_argument("--input and --generate are exclusive");
+    }
+    if (options.command == CliCommand::Convert && options.output.empty())
+    {
+        throw std::invalid_argument("convert needs --output");
+    }
+    if (options.command == CliCommand::Resample && !(options.stepSec > 0.0))
+    {
+        throw std::invalid_argument("resample needs a positive --step");
+    }
+    if (options.command == CliCommand::Partial)
+    {
+        if (options.output.empty())
+        {
+            throw std::invalid_argument("partial needs --output");
+        }
+        if (options.shard >= options.shardPlan.shardCount)
+        {
+            throw std::invalid_argument("--shard I/N needs I < N");
+        }
+        if (options.shardPlan.key == ShardKey::Time)
+        {
+            if (!options.fromSec || !options.toSec || !(*options.toSec > *options.fromSec))
+            {
+                throw std::invalid_argument("--shard-key time needs --from < --to, the same on every node");
+            }
+            options.shardPlan.fromSec = *options.fromSec;
+            options.shardPlan.toSec = *options.toSec;
+        }
+    }
+    if (options.command == CliCommand::Merge && (options.partials.empty() || !options.input.empty() || options.generate))
+    {
+        throw std::invalid_argument("merge reads one or more --partial files, and no --input");
+    }
+    return options;
+}
+
+// ** Input **
+
+static EventColumnStore LoadInput(const CliOptions& options)
+{
+    if (options.generate)
+    {
+        return GenerateEventStore(*options.generate);
+    }
+    if (options.input.empty())
+    {
+        std::vector<SimulationEvent> events{};
+        SimulationEvent{}.ConstructMockingSimulationEventVector(events);
+        return EventColumnStore{ events };
+    }
+    if (options.input.extension() == ".evlog")
+    {
+        return LoadBinaryEventLog(options.input);
+    }
+
+    TextLogReport report{};
+    TextLogOptions textOptions{};
+    textOptions.delimiter = options.delimiter;
+    EventColumnStore store = LoadTextLog(options.input, &report, textOptions);
+    if (!report.Ok())
+    {
+        std::cerr << "EventStreamCli: " << report.malformed << " malformed line(s) skipped in " << options.input.string() << '\n';
+        for (const TextLogError& error : report.errors)
+        {
+            std::cerr << "  line " << error.line << ": " << error.message << '\n';
+        }
+    }
+    return store;
+}
+
+// The zone map convert saved next to an .evlog input, or an empty map (queries then scan every row). A map that does
+// not match the log (the log was rewritten or replaced after convert) is reported and ignored: slower, never wrong.
+static ZoneMap LoadInputZones(const CliOptions& options, const EventColumnStore& store)
+{
+    const std::filesystem::path path = ZoneMapPath(options.input);
+    if (options.generate || options.input.extension() != ".evlog" || !std::filesystem::exists(path))
+    {
+        return {};
+    }
+    try
+    {
+        return LoadZoneMap(path, store);
+    }
+    catch (const std::runtime_error& error)
+    {
+        std::cerr << "EventStreamCli: " << error.what() << "; scanning every event (convert rebuilds the zone map)\n";
+        return {};
+    }
+}
+
+static QuerySpec MakeQuerySpec(const CliOptions& options, const EventColumnStore& store)
+{
+    QuerySpec spec{ options.aggregate, options.type, {}, options.fromSec, options.toSec };
+    if (options.source)
+    {
+        spec.source = store.FindSource(*options.source).value_or(static_cast<SourceId>(store.SourceCount()));// unknown: matches nothing
+    }
+    return spec;
+}
+
+static void WriteMetrics(const CliOptions& options)
+{
+    std::ofstream file{};
+    if (options.metrics != "-")
+    {
+        file.open(options.metrics, std::ios::binary);
+        if (!file)
+        {
+            throw std::runtime_error("cannot open " + options.metrics);
+        }
+    }
+    std::ostream& out = file.is_open() ? static_cast<std::ostream&>(file) : std::cerr;
+    if (options.prometheus)
+    {
+        WritePrometheusMetrics(Metrics(), out);
+    }
+    else
+    {
+        WriteMetricsText(Metrics(), out);
+    }
+    out.flush();
+    if (!out)
+    {
+        throw std::runtime_error("writing the metrics failed");
+    }
+}
+
+// ** Commands **
+
+static void WriteStatsLine(std::ostream& out, std::string_view group, std::string_view key, const AggregateStats& stats)
+{
+    out << group << ',' << key << ',' << stats.count << ',' << stats.sum << ',' << stats.mean << ','
+        << stats.min << ',' << stats.max << ',' << stats.StdDev() << '\n';
+}
+
+static void WriteStatsReport(const AggregateReport& report, const SourceDictionary& sources, std::ostream& out)
+{
+    out << "group,key,count,sum,mean,min,max,sd\n";
+    WriteStatsLine(out, "all", "all", report.overall);
+    for (SourceId id = 0; id < report.bySource.size(); ++id)
+    {
+        if (!report.Source(id).Empty()) WriteStatsLine(out, "source", sources.Name(id), report.Source(id));
+    }
+    for (std::size_t slot = 0; slot < EventTypeCount; ++slot)
+    {
+        const AggregateStats& stats = report.Type(static_cast<EventType>(slot));
+        if (!stats.Empty()) WriteStatsLine(out, "type", EventTypeNames[slot], stats);
+    }
+}
+
+static void RunStats(const EventColumnStore& store, ThreadPool& pool, std::ostream& out)
+{
+    WriteStatsReport(ParallelAggregateEvents(store, pool), store.Sources(), out);
+}
+
+static void RunPartial(const EventColumnStore& store, const CliOptions& options)
+{
+    const std::vector<std::byte> message = EncodePartialAggregate(AggregateShard(store, options.shardPlan, options.shard));
+    std::ofstream file(options.output, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(message.data()), static_cast<std::streamsize>(message.size()));
+    if (!file)
+    {
+        throw std::runtime_error("cannot write " + options.output.string());
+    }
+}
+
+static void RunMerge(const CliOptions& options, std::ostream& out)
+{
+    std::optional<AggregateCoordinator> coordinator{};
+    for (const std::filesystem::path& path : options.partials)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<std::byte> message(file ? static_cast<std::size_t>(std::filesystem::file_size(path)) : 0);
+        if (!file || !file.read(reinterpret_cast<char*>(message.data()), static_cast<std::streamsize>(message.size())))
+        {
+            throw std::runtime_error("cannot read " + path.string());
+        }
+        const PartialAggregate partial = DecodePartialAggregate(message);
+        if (!coordinator)
+        {
+            coordinator.emplace(partial.plan);// every other file must come from the same plan
+        }
+        coordinator->Merge(partial);
+    }
+    WriteStatsReport(coordinator->Report(), coordinator->Sources(), out);
+    if (!coordinator->Complete())
+    {
+        std::cerr << "EventStreamCli: only " << coordinator->ShardsReceived() << " of " << coordinator->ShardCount() << " shards merged, the stats are partial\n";
+    }
+    else if (!options.quiet)
+    {
+        std::cerr << "EventStreamCli: merged " << coordinator->ShardCount() << " shard(s), " << coordinator->Events() << " events\n";
+    }
+}
+
+static void RunSelection(const EventColumnStore& store, const ZoneMap& zones, const QuerySpec& spec, bool sort, ThreadPool& pool, std::ostream& out, char delimiter)
+{
+    const std::vector<EventIndex> rows = RunSelect(store, zones, spec);
+    if (!sort)
+    {
+        WriteTextLog(store, rows, out, delimiter);
+        return;
+    }
+    const EventColumnStore selected = store.Gather(rows);
+    WriteTextLog(selected, ParallelSortedOrderByTime(selected, true, pool), out, delimiter);
+}
+
+static void RunWindows(const EventColumnStore& store, const WindowOptions& window, std::ostream& out)
+{
+    out << "start,end,source,type,count,sum,mean\n";
+    for (const WindowResult& result : AggregateWindows(store, window))
+    {
+        out << result.startSec << ',' << result.endSec << ','
+            << (result.sourceId ? store.SourceName(*result.sourceId) : std::string{}) << ','
+            << (result.type ? EventTypeNames[static_cast<std::size_t>(*result.type)] : std::string_view{}) << ','
+            << result.count << ',' << result.sum << ',' << result.Mean() << '\n';
+    }
+}
+
+static void RunResample(const EventColumnStore& store, const CliOptions& options, std::ostream& out)
+{
+    if (store.Size() == 0)
+    {
+        out << "time\n";
+        return;
+    }
+    const auto [first, last] = std::ranges::minmax(store.Timestamps());
+    const std::vector<double> grid = UniformGrid(options.fromSec.value_or(first), options.toSec.value_or(last), options.stepSec);
+    const std::vector<std::vector<double>> bySource = ResampleBySource(store, grid, options.resample, options.type);
+
+    out << "time";
+    for (SourceId id = 0; id < bySource.size(); ++id)
+    {
+        out << ',' << store.SourceName(id);
+    }
+    out << '\n';
+    for (std::size_t point = 0; point < grid.size(); ++point)
+    {
+        out << grid[point];
+        for (const std::vector<double>& values : bySource)
+        {
+            out << ',' << values[point];// NaN outside a series with --no-clamp, or for a source without events
+        }
+        out << '\n';
+    }
+}
+
+int main(int argc, char** argv)
+{
+    using Clock = std::chrono::steady_clock;
+    auto milliseconds = [](Clock::time_point since) { return std::chrono::duration<double, std::milli>(Clock::now() - since).count(); };
+
+    CliOptions options{};
+    try
+    {
+        options = ParseCommandLine(argc, argv);
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << "EventStreamCli: " << error.what() << '\n' << Usage;
+        return 2;
+    }
+
+    try
+    {
+        std::ios::sync_with_stdio(false);
+        const Clock::time_point loadStart = Clock::now();
+        const EventColumnStore store = options.command == CliCommand::Merge ? EventColumnStore{} : LoadInput(options);
+        const ZoneMap zones = LoadInputZones(options, store);
+        const double loadMs = milliseconds(loadStart);
+
+        std::ofstream file{};
+        if (!options.output.empty() && options.command != CliCommand::Convert && options.command != CliCommand::Partial)
+        {
+            file.open(options.output, std::ios::binary);
+            if (!file)
+            {
+                throw std::runtime_error("cannot open " + options.output.string());
+            }
+        }
+        std::ostream& out = file.is_open() ? static_cast<std::ostream&>(file) : std::cout;
+        out.precision(17);// round-trips every double
+
+        ThreadPool pool{ options.threads };
+        const Clock::time_point runStart = Clock::now();
+        switch (options.command)
+        {
+        case CliCommand::Stats: RunStats(store, pool, out); break;
+        case CliCommand::Query: out << RunQuery(store, zones, MakeQuerySpec(options, store)) << '\n'; break;
+        case CliCommand::Select: RunSelection(store, zones, MakeQuerySpec(options, store), options.sort, pool, out, options.delimiter); break;
+        case CliCommand::Windows: RunWindows(store, options.window, out); break;
+        case CliCommand::Convert:
+            WriteBinaryEventLog(store, options.output);
+            WriteZoneMap(ZoneMap{ store }, store, ZoneMapPath(options.output));
+            break;
+        case CliCommand::Resample: RunResample(store, options, out); break;
+        case CliCommand::Partial: RunPartial(store, options); break;
+        case CliCommand::Merge: RunMerge(options, out); break;
+        }
+        out.flush();
+        if (!out)
+        {
+            throw std::runtime_error("writing the results failed");
+        }
+
+        if (!options.quiet && options.command != CliCommand::Merge)
+        {
+            std::cerr << "EventStreamCli: " << store.Size() << " events, " << store.SourceCount() << " sources; loaded in "
+                << loadMs << " ms, ran in " << milliseconds(runStart) << " ms\n";
+        }
+        if (!options.metrics.empty())
+        {
+            WriteMetrics(options);
+        }
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << "EventStreamCli: " << error.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,202 @@
+#pragma once
+// Compact binary event log, loaded by memory-mapping instead of parsing.
+//
+// Layout (little-endian, every column starts on a 64-byte boundary so the mapped spans are aligned for SIMD):
+//   BinaryLogHeader
+//   timestamps  double[eventCount]
+//   values      double[eventCount]
+//   sourceIds   uint32[eventCount]
+//   types       uint8[eventCount]
+//   dictionary  sourceCount x { uint32 length, char name[length] }, in SourceId order
+//
+// LoadBinaryEventLog maps the file and hands the column spans to EventColumnStore::Borrow, so opening a
+// multi-gigabyte log only reads the header and the (small) dictionary; columns are paged in when a query touches them.
+// NOTE: sourceIds/types are trusted as written; checking them would page in both columns at load time.
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "EventColumnStore.h"
+#include "Instrumentation.h"
+#include "MappedFile.h"
+#include "SourceDictionary.h"
+
+static_assert(std::endian::native == std::endian::little, "BinaryEventLog assumes a little-endian host");
+
+inline constexpr char BinaryLogMagic[8] = { 'E', 'S', 'P', 'E', 'V', 'L', 'O', 'G' };
+inline constexpr std::uint32_t BinaryLogVersion = 1;
+inline constexpr std::uint64_t BinaryLogAlignment = 64;
+
+struct BinaryLogHeader
+{
+    char magic[8]{};
+    std::uint32_t version{};
+    std::uint32_t headerBytes{};
+    std::uint64_t eventCount{};
+    std::uint64_t sourceCount{};
+    std::uint64_t timestampsOffset{};
+    std::uint64_t valuesOffset{};
+    std::uint64_t sourceIdsOffset{};
+    std::uint64_t typesOffset{};
+    std::uint64_t dictionaryOffset{};
+    std::uint64_t dictionaryBytes{};
+};
+static_assert(sizeof(BinaryLogHeader) == 80, "BinaryLogHeader is an on-disk format, keep it packed");
+
+inline constexpr std::uint64_t AlignUp(std::uint64_t offset, std::uint64_t alignment) { return (offset + alignment - 1) / alignment * alignment; }
+
+// Every offset follows from eventCount, so the writer and the loader share one layout function.
+inline void LayOutBinaryLog(BinaryLogHeader& header)
+{
+    const std::uint64_t n = header.eventCount;
+    header.timestampsOffset = AlignUp(sizeof(BinaryLogHeader), BinaryLogAlignment);
+    header.valuesOffset = AlignUp(header.timestampsOffset + n * sizeof(double), BinaryLogAlignment);
+    header.sourceIdsOffset = AlignUp(header.valuesOffset + n * sizeof(double), BinaryLogAlignment);
+    header.typesOffset = AlignUp(header.sourceIdsOffset + n * sizeof(SourceId), BinaryLogAlignment);
+    header.dictionaryOffset = AlignUp(header.typesOffset + n * sizeof(EventType), BinaryLogAlignment);
+}
+
+inline BinaryLogHeader MakeBinaryLogHeader(std::uint64_t eventCount, const SourceDictionary& sources)
+{
+    BinaryLogHeader header{};
+    std::memcpy(header.magic, BinaryLogMagic, sizeof(header.magic));
+    header.version = BinaryLogVersion;
+    header.headerBytes = sizeof(BinaryLogHeader);
+    header.eventCount = eventCount;
+    header.sourceCount = sources.Size();
+    LayOutBinaryLog(header);
+
+    for (const std::string& name : sources.Names())
+    {
+        header.dictionaryBytes += sizeof(std::uint32_t) + name.size();
+    }
+    return header;
+}
+
+inline void WriteBinaryEventLog(const EventColumnStore& store, const std::filesystem::path& path)
+{
+    ESP_TIME_OPERATION("write_binary_log", store.Size());
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        throw std::runtime_error("WriteBinaryEventLog: cannot create " + path.string());
+    }
+
+    const BinaryLogHeader header = MakeBinaryLogHeader(store.Size(), store.Sources());
+    auto padTo = [&file](std::uint64_t offset)
+    {
+        static constexpr char zeros[BinaryLogAlignment]{};
+        const auto at = static_cast<std::uint64_t>(file.tellp());
+        file.write(zeros, static_cast<std::streamsize>(offset - at));
+    };
+    auto writeColumn = [&file, &padTo](std::uint64_t offset, auto column)
+    {
+        padTo(offset);
+        file.write(reinterpret_cast<const char*>(column.data()), static_cast<std::streamsize>(column.size_bytes()));
+    };
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeColumn(header.timestampsOffset, store.Timestamps());
+    writeColumn(header.valuesOffset, store.Values());
+    writeColumn(header.sourceIdsOffset, store.SourceIds());
+    writeColumn(header.typesOffset, store.Types());
+
+    padTo(header.dictionaryOffset);
+    for (const std::string& name : store.Sources().Names())
+    {
+        const auto length = static_cast<std::uint32_t>(name.size());
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file.write(name.data(), static_cast<std::streamsize>(name.size()));
+    }
+
+    if (!file)
+    {
+        throw std::runtime_error("WriteBinaryEventLog: write failed for " + path.string());
+    }
+    ESP_COUNT_BYTES("write_binary_log", header.dictionaryOffset + header.dictionaryBytes);
+}
+
+// Maps path and returns a store that reads its columns straight out of the mapping (zero copy, zero parse).
+// The mapping stays open while any copy of the returned store is alive.
+inline EventColumnStore LoadBinaryEventLog(const std::filesystem::path& path)
+{
+    ESP_TIME_OPERATION("load_binary_log", 0);
+    auto file = std::make_shared<const MappedFile>(path);
+    const std::span<const std::byte> bytes = file->Bytes();
+    auto fail = [&path](const char* why) { return std::runtime_error("LoadBinaryEventLog: " + path.string() + ": " + why); };
+
+    if (bytes.size() < sizeof(BinaryLogHeader))
+    {
+        throw fail("file too small for a header");
+    }
+    BinaryLogHeader header{};
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, BinaryLogMagic, sizeof(header.magic)) != 0)
+    {
+        throw fail("not a binary event log");
+    }
+    if (header.version != BinaryLogVersion || header.headerBytes != sizeof(BinaryLogHeader))
+    {
+        throw fail("unsupported version");
+    }
+    if (header.eventCount > std::numeric_limits<EventIndex>::max())
+    {
+        throw fail("too many events for a 32-bit EventIndex");
+    }
+
+    // Recomputing the layout from the counts validates every offset at once.
+    BinaryLogHeader expected = header;
+    LayOutBinaryLog(expected);
+    if (std::memcmp(&header, &expected, sizeof(header)) != 0)
+    {
+        throw fail("corrupt column offsets");
+    }
+    if (header.dictionaryOffset + header.dictionaryBytes > bytes.size())
+    {
+        throw fail("truncated file");
+    }
+
+    auto dictionary = std::make_shared<SourceDictionary>();
+    std::uint64_t at = header.dictionaryOffset;
+    const std::uint64_t dictionaryEnd = header.dictionaryOffset + header.dictionaryBytes;
+    for (std::uint64_t id = 0; id < header.sourceCount; ++id)
+    {
+        std::uint32_t length = 0;
+        if (at + sizeof(length) > dictionaryEnd)
+        {
+            throw fail("truncated source dictionary");
+        }
+        std::memcpy(&length, bytes.data() + at, sizeof(length));
+        at += sizeof(length);
+        if (at + length > dictionaryEnd)
+        {
+            throw fail("truncated source dictionary");
+        }
+        dictionary->Intern(std::string_view{ reinterpret_cast<const char*>(bytes.data() + at), length });
+        at += length;
+    }
+    if (dictionary->Size() != header.sourceCount)
+    {
+        throw fail("duplicate source names");
+    }
+
+    const auto n = static_cast<std::size_t>(header.eventCount);
+    ESP_COUNT_EVENTS("load_binary_log", n);
+    ESP_COUNT_BYTES("load_binary_log", bytes.size());// mapped; the columns are only read when a query touches them
+    const std::byte* base = bytes.data();
+    return EventColumnStore::Borrow(file,
+        { reinterpret_cast<const double*>(base + header.timestampsOffset), n },
+        { reinterpret_cast<const EventType*>(base + header.typesOffset), n },
+        { reinterpret_cast<const SourceId*>(base + header.sourceIdsOffset), n },
+        { reinterpret_cast<const double*>(base + header.valuesOffset), n },
+        std::move(dictionary));
+}
@@ -0,0 +1,752 @@
+#pragma once
+// Compressed in-memory history: the same events as an EventColumnStore, at a fraction of its 21 bytes per event.
+// Events are sealed in blocks of CompressedBlockRows; each block packs its columns into one bit stream:
+//   sourceIds   '0' when the id is the one that followed the previous event's source last time (round-robin
+//               interleaving), else '1' + the id in the block's id width
+//   types       '0' when the same as this source's previous type, else '1' + 2 bits
+//   timestamps  per-source delta-of-delta: a steady sample rate is '0' per event
+//   values      per-source deltas when the block's values are decimals (readings rounded to 0.1); otherwise Gorilla
+//               XOR against the source's previous value: an unchanged reading is '0', a small change keeps the
+//               previous leading/trailing-zero window and stores only the bits in between
+// Timestamps and decimal values are coded as integer ticks of a power of ten the block picks (see DecimalKey), and
+// fall back to the double's bit pattern when no power fits (NaN, -0.0, arbitrary doubles).
+// Every block header keeps its time span and the Totals (sum, count, min, max) of its values, so a time-range
+// aggregate answers fully covered blocks from the header, skips disjoint ones and decodes only the edges.
+//
+//   CompressedEventStore history{ store.SharedSources() };
+//   for (...) history.Append(time, EventType::SENSOR_READING, engineId, rpm);    // the last block stays raw until it fills
+//   double lastHour = RunQuery(history, { QueryAggregate::Mean, {}, {}, now - 3600.0, now });
+//   EventColumnStore window = history.Decompress(SelectTimeRange(history, now - 60.0, now));
+//   std::printf("%.1fx smaller\n", double(history.RawBytes()) / double(history.CompressedBytes()));
+//
+// Decoding is exact: every double comes back bit for bit, NaN payloads and negative zero included.
+// NOTE: const members only read, so concurrent queries are safe; Append() is not safe alongside them.
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "EventColumnStore.h"
+#include "Instrumentation.h"
+#include "Query.h"
+#include "SimulationEvent.h"
+#include "SourceDictionary.h"
+
+inline constexpr std::size_t CompressedBlockRows = 4096;
+
+// ** Bit streams **
+// LSB-first into 64-bit words: the first bit written is bit 0 of the first word.
+
+class BitWriter
+{
+public:
+    explicit BitWriter(std::vector<std::uint64_t>& words) : words{ &words } {}
+
+    // Appends the low count bits of bits (count <= 64; the bits above count must be zero).
+    void Write(std::uint64_t bits, unsigned count)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        const unsigned used = static_cast<unsigned>(position % 64);
+        if (used == 0)
+        {
+            words->push_back(0);
+        }
+        words->back() |= bits << used;
+        if (used + count > 64)
+        {
+            words->push_back(bits >> (64 - used));
+        }
+        position += count;
+    }
+
+    std::uint64_t Position() const { return position; }
+
+private:
+    std::vector<std::uint64_t>* words;
+    std::uint64_t position{};
+};
+
+class BitReader
+{
+public:
+    BitReader(std::span<const std::uint64_t> words, std::uint64_t position) : words{ words }, position{ position } {}
+
+    std::uint64_t Read(unsigned count)
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+        const std::size_t word = static_cast<std::size_t>(position / 64);
+        const unsigned used = static_cast<unsigned>(position % 64);
+        std::uint64_t bits = words[word] >> used;
+        if (used + count > 64)
+        {
+            bits |= words[word + 1] << (64 - used);
+        }
+        position += count;
+        return count == 64 ? bits : bits & ((std::uint64_t{ 1 } << count) - 1);
+    }
+
+    bool ReadBit()
+    {
+        const bool bit = (words[static_cast<std::size_t>(position / 64)] >> (position % 64)) & 1;
+        ++position;
+        return bit;
+    }
+
+private:
+    std::span<const std::uint64_t> words;
+    std::uint64_t position;
+};
+
+inline std::uint64_t ZigZag(std::int64_t value) { return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63); }
+inline std::int64_t UnZigZag(std::uint64_t value) { return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1); }
+
+// ** Decimal ticks **
+// Decimals like 12.3 or 0.01 * k have long binary mantissas but are small integers once scaled by a power of ten:
+// a column that steps by 0.1 deltas to +-1 tick. A key is the tick plus the (at most one ulp) difference between the
+// double and tick / scale, so decoding gives back every bit.
+
+inline constexpr double DecimalScales[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+inline constexpr std::uint8_t NoDecimalScale = 0xFF;
+
+struct DecimalKey
+{
+    std::uint64_t key{};                // the tick (two's complement), or the raw bit pattern without a scale
+    std::uint64_t residual{};           // bits(x) - bits(tick / scale): 0, 1 or -1
+};
+
+inline double FromDecimalKey(const DecimalKey& key, double scale)
+{
+    return std::bit_cast<double>(std::bit_cast<std::uint64_t>(static_cast<double>(static_cast<std::int64_t>(key.key)) / scale) + key.residual);
+}
+
+// nullopt for NaN, infinities, -0.0, ticks beyond 2^53 and values more than one ulp from their tick.
+inline std::optional<DecimalKey> ToDecimalKey(double x, double scale)
+{
+    const double scaled = x * scale;
+    if (!(std::abs(scaled) < 0x1p53))
+    {
+        return std::nullopt;
+    }
+    const DecimalKey key{ static_cast<std::uint64_t>(std::llround(scaled)), 0 };
+    const std::uint64_t residual = std::bit_cast<std::uint64_t>(x) - std::bit_cast<std::uint64_t>(FromDecimalKey(key, scale));
+    if (residual + 1 > 2)
+    {
+        return std::nullopt;
+    }
+    return DecimalKey{ key.key, residual };
+}
+
+// The smallest power of ten whose ticks hold every value of column, or NoDecimalScale.
+inline std::uint8_t FindDecimalScale(std::span<const double> column)
+{
+    for (std::uint8_t scale = 0; scale < std::size(DecimalScales); ++scale)
+    {
+        if (std::ranges::all_of(column, [scale](double x) { return ToDecimalKey(x, DecimalScales[scale]).has_value(); }))
+        {
+            return scale;
+        }
+    }
+    return NoDecimalScale;
+}
+
+// ** Blocks **
+
+struct CompressedBlock
+{
+    std::uint64_t firstRow{};           // row number of the block's first event in the whole store
+    std::uint64_t firstWord{};          // the block's bit stream starts at words[firstWord]
+    std::uint32_t rows{};
+    std::uint32_t typesBit{};           // where each column starts, in bits from firstWord
+    std::uint32_t timestampsBit{};
+    std::uint32_t valuesBit{};
+    SourceId maxSourceId{};             // sizes the per-source decoder state
+    std::uint8_t sourceBits{};          // width of an id that was not predicted
+    std::uint8_t timeScale{};           // index into DecimalScales, or NoDecimalScale
+    std::uint8_t valueScale{};
+    double minTime{};                   // NaN when any timestamp is NaN: the block is then never taken or skipped whole
+    double maxTime{};
+    Totals totals{};                    // of every value in the block
+
+    // Whether every timestamp of the block is in [fromSec, toSec), or none is.
+    bool InsideRange(double fromSec, double toSec) const { return minTime >= fromSec && maxTime < toSec; }
+    bool OutsideRange(double fromSec, double toSec) const { return maxTime < fromSec || minTime >= toSec; }
+};
+
+// One block's columns after decoding.
+struct DecodedBlock
+{
+    std::vector<double> timestamps{};
+    std::vector<EventType> types{};
+    std::vector<SourceId> sourceIds{};
+    std::vector<double> values{};
+};
+
+class CompressedEventStore
+{
+public:
+    explicit CompressedEventStore(std::shared_ptr<SourceDictionary> dictionary = std::make_shared<SourceDictionary>())
+        : open{ std::move(dictionary) }
+    {
+        open.Reserve(CompressedBlockRows);
+    }
+
+    // Compresses every row of store (sharing its dictionary); the rows of the last, partial block stay raw.
+    explicit CompressedEventStore(const EventColumnStore& store) : CompressedEventStore{ store.SharedSources() }
+    {
+        ESP_TIME_OPERATION("compress_store", store.Size());
+        auto timestamps = store.Timestamps();
+        auto types = store.Types();
+        auto sourceIds = store.SourceIds();
+        auto values = store.Values();
+        for (std::size_t row = 0; row < store.Size(); ++row)
+        {
+            Append(timestamps[row], types[row], sourceIds[row], values[row]);
+        }
+    }
+
+    void Append(const SimulationEvent& event)
+    {
+        Append(event.timestampSec, event.type, open.InternSource(event.source), event.value);
+    }
+
+    void Append(double timestampSec, EventType type, SourceId sourceId, double value)
+    {
+        open.Append(timestampSec, type, sourceId, value);
+        if (open.Size() == CompressedBlockRows)
+        {
+            SealOpenBlock();
+        }
+    }
+
+    // Compresses the rows appended since the last full block now, e.g. before the store is kept for a long time.
+    // The block is shorter than CompressedBlockRows; later appends start a new one.
+    void SealOpenBlock()
+    {
+        if (open.Empty())
+        {
+            return;
+        }
+        ESP_TIME_OPERATION("compress_block", open.Size());
+        blocks.push_back(Encode(open.Timestamps(), open.Types(), open.SourceIds(), open.Values()));
+        sealedRows += open.Size();
+        open.Clear();
+    }
+
+    std::size_t Size() const { return sealedRows + open.Size(); }
+    bool Empty() const { return Size() == 0; }
+
+    std::size_t BlockCount() const { return blocks.size(); }
+    const CompressedBlock& Block(std::size_t index) const { return blocks[index]; }
+
+    // The rows after the last sealed block, still uncompressed: rows [SealedRows(), Size()).
+    const EventColumnStore& OpenBlock() const { return open; }
+    std::size_t SealedRows() const { return sealedRows; }
+
+    const std::string& SourceName(SourceId id) const { return open.SourceName(id); }
+    std::size_t SourceCount() const { return open.SourceCount(); }
+    const std::shared_ptr<SourceDictionary>& SharedSources() const { return open.SharedSources(); }
+
+    // Bytes held for the events: bit streams, block headers and the open block (the dictionary is not counted).
+    std::size_t CompressedBytes() const
+    {
+        return words.size() * sizeof(std::uint64_t) + blocks.size() * sizeof(CompressedBlock) + open.Size() * RawRowBytes;
+    }
+
+    // What the same events take in an EventColumnStore.
+    std::size_t RawBytes() const { return Size() * RawRowBytes; }
+
+    // Decodes block index into out (sizes every column to the block's rows).
+    void DecodeBlock(std::size_t index, DecodedBlock& out) const
+    {
+        const CompressedBlock& block = blocks[index];
+        ResizeColumns(out, block.rows);
+        DecodeSourceIds(block, out.sourceIds);
+        DecodeTypes(block, out.sourceIds, out.types);
+        DecodeTimestamps(block, out.sourceIds, out.timestamps);
+        DecodeValues(block, out.sourceIds, out.values);
+    }
+
+    // Only the ids and timestamps: enough for time-range searches, without decoding types and values.
+    void DecodeBlockTimestamps(std::size_t index, DecodedBlock& out) const
+    {
+        const CompressedBlock& block = blocks[index];
+        out.sourceIds.resize(block.rows);
+        out.timestamps.resize(block.rows);
+        DecodeSourceIds(block, out.sourceIds);
+        DecodeTimestamps(block, out.sourceIds, out.timestamps);
+    }
+
+    // Every row back in an EventColumnStore that shares this store's dictionary.
+    EventColumnStore Decompress() const
+    {
+        ESP_TIME_OPERATION("decompress_store", Size());
+        EventColumnStore store{ open.SharedSources() };
+        store.Reserve(Size());
+        DecodedBlock decoded{};
+        for (std::size_t index = 0; index < blocks.size(); ++index)
+        {
+            DecodeBlock(index, decoded);
+            AppendRows(store, decoded.timestamps, decoded.types, decoded.sourceIds, decoded.values, 0, decoded.values.size());
+        }
+        AppendRows(store, open.Timestamps(), open.Types(), open.SourceIds(), open.Values(), 0, open.Size());
+        return store;
+    }
+
+    // Only rows (ascending row numbers, e.g. from SelectTimeRange), in that order; blocks without any are not decoded.
+    EventColumnStore Decompress(std::span<const EventIndex> rows) const
+    {
+        ESP_TIME_OPERATION("decompress_rows", rows.size());
+        EventColumnStore store{ open.SharedSources() };
+        store.Reserve(rows.size());
+        DecodedBlock decoded{};
+        std::size_t decodedIndex = blocks.size();
+        for (EventIndex row : rows)
+        {
+            if (row >= sealedRows)
+            {
+                AppendRows(store, open.Timestamps(), open.Types(), open.SourceIds(), open.Values(), row - sealedRows, row - sealedRows + 1);
+                continue;
+            }
+            const std::size_t index = BlockOf(row);
+            if (index != decodedIndex)
+            {
+                DecodeBlock(index, decoded);
+                decodedIndex = index;
+            }
+            const std::size_t at = row - blocks[index].firstRow;
+            AppendRows(store, decoded.timestamps, decoded.types, decoded.sourceIds, decoded.values, at, at + 1);
+        }
+        return store;
+    }
+
+    // Index of the sealed block holding row (row < SealedRows()).
+    std::size_t BlockOf(std::size_t row) const
+    {
+        auto it = std::ranges::upper_bound(blocks, static_cast<std::uint64_t>(row), {}, &CompressedBlock::firstRow);
+        return static_cast<std::size_t>(it - blocks.begin()) - 1;
+    }
+
+private:
+    static constexpr std::size_t RawRowBytes = sizeof(double) * 2 + sizeof(SourceId) + sizeof(EventType);
+
+    static constexpr unsigned DeltaBucketBits[] = { 7, 14, 24 };// see WriteBucketed
+
+    struct ValueWindow
+    {
+        std::uint8_t leading{};
+        std::uint8_t trailing{};
+        bool valid{};
+    };
+
+    static void ResizeColumns(DecodedBlock& out, std::size_t rows)
+    {
+        out.timestamps.resize(rows);
+        out.types.resize(rows);
+        out.sourceIds.resize(rows);
+        out.values.resize(rows);
+    }
+
+    static void AppendRows(EventColumnStore& store, std::span<const double> timestamps, std::span<const EventType> types,
+        std::span<const SourceId> sourceIds, std::span<const double> values, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t row = begin; row < end; ++row)
+        {
+            store.Append(timestamps[row], types[row], sourceIds[row], values[row]);
+        }
+    }
+
+    static std::size_t StateSize(const CompressedBlock& block) { return std::size_t{ block.maxSourceId } + 1; }
+
+    CompressedBlock Encode(std::span<const double> timestamps, std::span<const EventType> types, std::span<const SourceId> sourceIds, std::span<const double> values)
+    {
+        const std::size_t rows = values.size();
+        CompressedBlock block{};
+        block.firstRow = sealedRows;
+        block.firstWord = words.size();
+        block.rows = static_cast<std::uint32_t>(rows);
+        const auto [minTime, maxTime] = std::ranges::minmax(timestamps);
+        const bool unordered = std::ranges::any_of(timestamps, [](double t) { return std::isnan(t); });
+        block.minTime = unordered ? std::numeric_limits<double>::quiet_NaN() : minTime;
+        block.maxTime = unordered ? std::numeric_limits<double>::quiet_NaN() : maxTime;
+        for (double value : values)
+        {
+            block.totals.AddIf(true, value);
+        }
+        block.maxSourceId = std::ranges::max(sourceIds);
+        block.sourceBits = static_cast<std::uint8_t>(std::bit_width(block.maxSourceId));
+        const std::size_t states = StateSize(block);
+        BitWriter writer{ words };
+
+        //1. Source ids, predicted from the id that followed the previous event's source last time.
+        std::vector<SourceId> next(states);
+        std::iota(next.begin(), next.end(), SourceId{ 0 });
+        SourceId previous = 0;
+        for (SourceId id : sourceIds)
+        {
+            if (id == next[previous])
+            {
+                writer.Write(0, 1);
+            }
+            else
+            {
+                writer.Write(1, 1);
+                writer.Write(id, block.sourceBits);
+                next[previous] = id;
+            }
+            previous = id;
+        }
+
+        //2. Types: per source, a change is the rare case.
+        block.typesBit = static_cast<std::uint32_t>(writer.Position());
+        std::vector<std::uint8_t> lastType(states);
+        for (std::size_t row = 0; row < rows; ++row)
+        {
+            const auto type = static_cast<std::uint8_t>(types[row]);
+            if (type == lastType[sourceIds[row]])
+            {
+                writer.Write(0, 1);
+            }
+            else
+            {
+                writer.Write(1 | (std::uint64_t{ type } << 1), 3);
+                lastType[sourceIds[row]] = type;
+            }
+        }
+
+        //3. Timestamps: per-source delta-of-delta, of decimal ticks when the block has a scale (0.01 * k is tick k at
+        // 10^2), else of the bit pattern. Every source starts from the first row's key, which is written raw.
+        block.timestampsBit = static_cast<std::uint32_t>(writer.Position());
+        block.timeScale = FindDecimalScale(timestamps);
+        const double timeScale = block.timeScale == NoDecimalScale ? 0.0 : DecimalScales[block.timeScale];
+        const auto timeKey = [timeScale](double t) { return timeScale == 0.0 ? DecimalKey{ std::bit_cast<std::uint64_t>(t) } : *ToDecimalKey(t, timeScale); };
+        const std::uint64_t base = timeKey(timestamps[0]).key;
+        writer.Write(base, 64);
+        std::vector<std::uint64_t> lastKey(states, base);
+        std::vector<std::uint64_t> lastDelta(states);
+        for (std::size_t row = 0; row < rows; ++row)
+        {
+            const SourceId id = sourceIds[row];
+            const DecimalKey key = timeKey(timestamps[row]);
+            const std::uint64_t delta = key.key - lastKey[id];// wraps: unsigned arithmetic round-trips any key
+            WriteBucketed(writer, ZigZag(static_cast<std::int64_t>(delta - lastDelta[id])));
+            WriteResidual(writer, key, timeScale);
+            lastKey[id] = key.key;
+            lastDelta[id] = delta;
+        }
+
+        //4. Values: per-source deltas of decimal ticks when the block has a scale (sensor readings rounded to 0.1),
+        // else Gorilla XOR with this source's previous value (0.0 at the start of a block).
+        block.valuesBit = static_cast<std::uint32_t>(writer.Position());
+        block.valueScale = FindDecimalScale(values);
+        if (block.valueScale != NoDecimalScale)
+        {
+            const double valueScale = DecimalScales[block.valueScale];
+            std::vector<std::uint64_t> lastValue(states);
+            for (std::size_t row = 0; row < rows; ++row)
+            {
+                const DecimalKey key = *ToDecimalKey(values[row], valueScale);
+                WriteBucketed(writer, ZigZag(static_cast<std::int64_t>(key.key - lastValue[sourceIds[row]])));
+                WriteResidual(writer, key, valueScale);
+                lastValue[sourceIds[row]] = key.key;
+            }
+            return block;
+        }
+        std::vector<std::uint64_t> lastValue(states);
+        std::vector<ValueWindow> windows(states);
+        for (std::size_t row = 0; row < rows; ++row)
+        {
+            const SourceId id = sourceIds[row];
+            const std::uint64_t bits = std::bit_cast<std::uint64_t>(values[row]);
+            const std::uint64_t x = bits ^ lastValue[id];
+            lastValue[id] = bits;
+            if (x == 0)
+            {
+                writer.Write(0, 1);
+                continue;
+            }
+            const unsigned leading = std::min(static_cast<unsigned>(std::countl_zero(x)), 31u);
+            const unsigned trailing = static_cast<unsigned>(std::countr_zero(x));
+            ValueWindow& window = windows[id];
+            if (window.valid && leading >= window.leading && trailing >= window.trailing)
+            {
+                writer.Write(0b01, 2);
+                writer.Write(x >> window.trailing, 64 - window.leading - window.trailing);
+            }
+            else
+            {
+                const unsigned meaningful = 64 - leading - trailing;
+                writer.Write(0b11, 2);
+                writer.Write(leading, 5);
+                writer.Write(meaningful - 1, 6);
+                writer.Write(x >> trailing, meaningful);
+                window = { static_cast<std::uint8_t>(leading), static_cast<std::uint8_t>(trailing), true };
+            }
+        }
+        return block;
+    }
+
+    BitReader ReaderAt(const CompressedBlock& block, std::uint32_t bit) const
+    {
+        return { std::span<const std::uint64_t>{ words }.subspan(static_cast<std::size_t>(block.firstWord)), bit };
+    }
+
+    void DecodeSourceIds(const CompressedBlock& block, std::span<SourceId> out) const
+    {
+        BitReader reader = ReaderAt(block, 0);
+        std::vector<SourceId> next(StateSize(block));
+        std::iota(next.begin(), next.end(), SourceId{ 0 });
+        SourceId previous = 0;
+        for (SourceId& id : out)
+        {
+            if (reader.ReadBit())
+            {
+                next[previous] = static_cast<SourceId>(reader.Read(block.sourceBits));
+            }
+            id = next[previous];
+            previous = id;
+        }
+    }
+
+    void DecodeTypes(const CompressedBlock& block, std::span<const SourceId> sourceIds, std::span<EventType> out) const
+    {
+        BitReader reader = ReaderAt(block, block.typesBit);
+        std::vector<std::uint8_t> lastType(StateSize(block));
+        for (std::size_t row = 0; row < out.size(); ++row)
+        {
+            std::uint8_t& last = lastType[sourceIds[row]];
+            if (reader.ReadBit())
+            {
+                last = static_cast<std::uint8_t>(reader.Read(2));
+            }
+            out[row] = static_cast<EventType>(last);
+        }
+    }
+
+    void DecodeTimestamps(const CompressedBlock& block, std::span<const SourceId> sourceIds, std::span<double> out) const
+    {
+        BitReader reader = ReaderAt(block, block.timestampsBit);
+        const double timeScale = block.timeScale == NoDecimalScale ? 0.0 : DecimalScales[block.timeScale];
+        const std::uint64_t base = reader.Read(64);
+        std::vector<std::uint64_t> lastKey(StateSize(block), base);
+        std::vector<std::uint64_t> lastDelta(StateSize(block));
+        for (std::size_t row = 0; row < out.size(); ++row)
+        {
+            const SourceId id = sourceIds[row];
+            lastDelta[id] += static_cast<std::uint64_t>(UnZigZag(ReadBucketed(reader)));
+            lastKey[id] += lastDelta[id];
+            out[row] = ReadValue(reader, lastKey[id], timeScale);
+        }
+    }
+
+    void DecodeValues(const CompressedBlock& block, std::span<const SourceId> sourceIds, std::span<double> out) const
+    {
+        BitReader reader = ReaderAt(block, block.valuesBit);
+        std::vector<std::uint64_t> lastValue(StateSize(block));
+        if (block.valueScale != NoDecimalScale)
+        {
+            const double valueScale = DecimalScales[block.valueScale];
+            for (std::size_t row = 0; row < out.size(); ++row)
+            {
+                std::uint64_t& last = lastValue[sourceIds[row]];
+                last += static_cast<std::uint64_t>(UnZigZag(ReadBucketed(reader)));
+                out[row] = ReadValue(reader, last, valueScale);
+            }
+            return;
+        }
+        std::vector<ValueWindow> windows(StateSize(block));
+        for (std::size_t row = 0; row < out.size(); ++row)
+        {
+            const SourceId id = sourceIds[row];
+            if (reader.ReadBit())
+            {
+                ValueWindow& window = windows[id];
+                if (reader.ReadBit())
+                {
+                    const auto leading = static_cast<unsigned>(reader.Read(5));
+                    const auto meaningful = static_cast<unsigned>(reader.Read(6)) + 1;
+                    window = { static_cast<std::uint8_t>(leading), static_cast<std::uint8_t>(64 - leading - meaningful), true };
+                }
+                lastValue[id] ^= reader.Read(64 - window.leading - window.trailing) << window.trailing;
+            }
+            out[row] = std::bit_cast<double>(lastValue[id]);
+        }
+    }
+
+    // Zigzagged deltas: '0' for 0, '10' + 7 bits, '110' + 14, '1110' + 24, '1111' + 64.
+    static void WriteBucketed(BitWriter& writer, std::uint64_t zigzag)
+    {
+        if (zigzag == 0)
+        {
+            writer.Write(0, 1);
+            return;
+        }
+        unsigned bucket = 0;
+        while (bucket < std::size(DeltaBucketBits) && static_cast<unsigned>(std::bit_width(zigzag)) > DeltaBucketBits[bucket])
+        {
+            ++bucket;
+        }
+        if (bucket < std::size(DeltaBucketBits))
+        {
+            writer.Write((std::uint64_t{ 1 } << (bucket + 1)) - 1, bucket + 2);// bucket + 1 ones, then a zero
+            writer.Write(zigzag, DeltaBucketBits[bucket]);
+        }
+        else
+        {
+            writer.Write(0b1111, 4);
+            writer.Write(zigzag, 64);
+        }
+    }
+
+    static std::uint64_t ReadBucketed(BitReader& reader)
+    {
+        if (!reader.ReadBit())
+        {
+            return 0;
+        }
+        unsigned bucket = 0;
+        while (bucket < std::size(DeltaBucketBits) && reader.ReadBit())
+        {
+            ++bucket;
+        }
+        return reader.Read(bucket < std::size(DeltaBucketBits) ? DeltaBucketBits[bucket] : 64);
+    }
+
+    // With a decimal scale, the ulp between the value and tick / scale: '0', '10' for +1, '11' for -1. Nothing without.
+    static void WriteResidual(BitWriter& writer, const DecimalKey& key, double scale)
+    {
+        if (scale != 0.0)
+        {
+            writer.Write(key.residual == 0 ? 0b0 : key.residual == 1 ? 0b01 : 0b11, key.residual == 0 ? 1 : 2);
+        }
+    }
+
+    static double ReadValue(BitReader& reader, std::uint64_t key, double scale)
+    {
+        if (scale == 0.0)
+        {
+            return std::bit_cast<double>(key);
+        }
+        const std::uint64_t residual = !reader.ReadBit() ? 0 : reader.ReadBit() ? ~std::uint64_t{ 0 } : 1;
+        return FromDecimalKey({ key, residual }, scale);
+    }
+
+    std::vector<std::uint64_t> words{};         // every sealed block's bit stream, back to back
+    std::vector<CompressedBlock> blocks{};
+    std::size_t sealedRows{};
+    EventColumnStore open;                      // rows of the block being filled, within the dictionary
+};
+
+// ** Queries **
+
+// Totals of spec's filters over every row, the same as RunQueryTotals on the decompressed store (sums may round
+// differently). Without a type or source filter, blocks inside the time range are answered from their header and
+// blocks outside it are skipped: only the blocks straddling fromSec/toSec are decoded.
+inline Totals RunQueryTotals(const CompressedEventStore& store, const QuerySpec& spec)
+{
+    ESP_TIME_OPERATION("compressed_query", store.Size());
+    const double fromSec = spec.fromSec.value_or(-std::numeric_limits<double>::infinity());
+    const double toSec = spec.toSec.value_or(std::numeric_limits<double>::infinity());
+    const bool headersAnswer = !spec.type && !spec.source;
+    const bool byTime = spec.fromSec || spec.toSec;
+    Totals totals{};
+    DecodedBlock decoded{};
+    for (std::size_t index = 0; index < store.BlockCount(); ++index)
+    {
+        const CompressedBlock& block = store.Block(index);
+        if (byTime && block.OutsideRange(fromSec, toSec))
+        {
+            continue;
+        }
+        if (headersAnswer && (!byTime || block.InsideRange(fromSec, toSec)))
+        {
+            totals.Merge(block.totals);
+            continue;
+        }
+        store.DecodeBlock(index, decoded);
+        const EventColumnStore view = EventColumnStore::Borrow({}, decoded.timestamps, decoded.types, decoded.sourceIds, decoded.values, store.SharedSources());
+        totals.Merge(RunQueryTotals(view, spec));
+    }
+    totals.Merge(RunQueryTotals(store.OpenBlock(), spec));
+    return totals;
+}
+
+inline double RunQuery(const CompressedEventStore& store, const QuerySpec& spec)
+{
+    return RunQueryTotals(store, spec).Of(spec.aggregate);
+}
+
+// Rows with timestamps in [fromSec, toSec), ascending. Blocks are taken whole or skipped from their header; only
+// blocks straddling the range decode their timestamps (and ids), never their types or values.
+inline std::vector<EventIndex> SelectTimeRange(const CompressedEventStore& store, double fromSec, double toSec)
+{
+    ESP_TIME_OPERATION("compressed_time_range", store.Size());
+    std::vector<EventIndex> rows{};
+    DecodedBlock decoded{};
+    const auto appendMatching = [&rows, fromSec, toSec](std::span<const double> timestamps, std::size_t firstRow)
+        {
+            for (std::size_t row = 0; row < timestamps.size(); ++row)
+            {
+                if (timestamps[row] >= fromSec && timestamps[row] < toSec)
+                {
+                    rows.push_back(static_cast<EventIndex>(firstRow + row));
+                }
+            }
+        };
+    for (std::size_t index = 0; index < store.BlockCount(); ++index)
+    {
+        const CompressedBlock& block = store.Block(index);
+        if (block.OutsideRange(fromSec, toSec))
+        {
+            continue;
+        }
+        if (block.InsideRange(fromSec, toSec))
+        {
+            const std::size_t begin = rows.size();
+            rows.resize(begin + block.rows);
+            std::iota(rows.begin() + static_cast<std::ptrdiff_t>(begin), rows.end(), static_cast<EventIndex>(block.firstRow));
+            continue;
+        }
+        store.DecodeBlockTimestamps(index, decoded);
+        appendMatching(decoded.timestamps, static_cast<std::size_t>(block.firstRow));
+    }
+    appendMatching(store.OpenBlock().Timestamps(), store.SealedRows());
+    return rows;
+}
+
+// First row with a timestamp after thresholdTime, or nullopt; blocks that end at or before it are never decoded.
+inline std::optional<EventIndex> FirstEventAfter(const CompressedEventStore& store, double thresholdTime)
+{
+    ESP_TIME_OPERATION("compressed_first_event_after", 0);
+    DecodedBlock decoded{};
+    for (std::size_t index = 0; index < store.BlockCount(); ++index)
+    {
+        const CompressedBlock& block = store.Block(index);
+        if (block.maxTime <= thresholdTime)
+        {
+            continue;
+        }
+        store.DecodeBlockTimestamps(index, decoded);
+        auto it = std::ranges::find_if(decoded.timestamps, [thresholdTime](double t) { return t > thresholdTime; });
+        if (it == decoded.timestamps.end())
+        {
+            continue;// only NaN timestamps after the threshold
+        }
+        return static_cast<EventIndex>(block.firstRow + static_cast<std::uint64_t>(it - decoded.timestamps.begin()));
+    }
+    std::optional<EventIndex> open = FirstEventAfter(store.OpenBlock(), thresholdTime);
+    return open ? std::optional<EventIndex>{ static_cast<EventIndex>(store.SealedRows() + *open) } : std::nullopt;
+}
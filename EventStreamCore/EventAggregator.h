@@ -0,0 +1,148 @@
+#pragma once
+// Single-pass multi-aggregate engine.
+// One walk over the type/sourceId/value columns fills sum, count, min, max, mean and variance
+// for every source, every EventType and the whole log at once, instead of one full pass per statistic.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "EventColumnStore.h"
+#include "Instrumentation.h"
+
+struct AggregateStats
+{
+    std::uint64_t count{};
+    double sum{};
+    double min{ std::numeric_limits<double>::infinity() };
+    double max{ -std::numeric_limits<double>::infinity() };
+    double mean{};
+    double m2{};    // sum of squared distances from the mean (Welford), variance = m2 / count
+
+    void Add(double value)
+    {
+        ++count;
+        sum += value;
+        min = std::min(min, value);
+        max = std::max(max, value);
+
+        // Welford's update: numerically stable, no second pass and no sum of squares that can cancel out.
+        const double delta = value - mean;
+        mean += delta / static_cast<double>(count);
+        m2 += delta * (value - mean);
+    }
+
+    // Combines two partial results (Chan et al.), so partitions/threads/nodes can aggregate independently.
+    void Merge(const AggregateStats& other)
+    {
+        if (other.count == 0)
+        {
+            return;
+        }
+        if (count == 0)
+        {
+            *this = other;
+            return;
+        }
+
+        const double total = static_cast<double>(count + other.count);
+        const double delta = other.mean - mean;
+        mean += delta * static_cast<double>(other.count) / total;
+        m2 += other.m2 + delta * delta * static_cast<double>(count) * static_cast<double>(other.count) / total;
+        count += other.count;
+        sum += other.sum;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+
+    bool Empty() const { return count == 0; }
+    double Variance() const { return count > 0 ? m2 / static_cast<double>(count) : 0.0; }              // population
+    double SampleVariance() const { return count > 1 ? m2 / static_cast<double>(count - 1) : 0.0; }
+    double StdDev() const { return std::sqrt(Variance()); }
+};
+
+inline std::size_t TypeSlot(EventType type) { return static_cast<std::size_t>(type); }
+
+struct AggregateReport
+{
+    std::vector<AggregateStats> bySource{};                         // indexed by SourceId
+    std::array<AggregateStats, EventTypeCount> byType{};            // indexed by TypeSlot(type)
+    std::vector<AggregateStats> bySourceAndType{};                  // [id * EventTypeCount + TypeSlot(type)], e.g. engine1 sensor readings only
+    AggregateStats overall{};
+
+    void Add(EventType type, SourceId source, double value)
+    {
+        if (source >= bySource.size())// ids are dense, so this only grows when a new source shows up
+        {
+            bySource.resize(source + 1);
+            bySourceAndType.resize((source + 1) * EventTypeCount);
+        }
+        bySource[source].Add(value);
+        byType[TypeSlot(type)].Add(value);
+        bySourceAndType[source * EventTypeCount + TypeSlot(type)].Add(value);
+        overall.Add(value);
+    }
+
+    void Merge(const AggregateReport& other)
+    {
+        if (other.bySource.size() > bySource.size())
+        {
+            bySource.resize(other.bySource.size());
+            bySourceAndType.resize(other.bySourceAndType.size());
+        }
+        for (std::size_t id = 0; id < other.bySource.size(); ++id)
+        {
+            bySource[id].Merge(other.bySource[id]);
+        }
+        for (std::size_t slot = 0; slot < other.bySourceAndType.size(); ++slot)
+        {
+            bySourceAndType[slot].Merge(other.bySourceAndType[slot]);
+        }
+        for (std::size_t slot = 0; slot < EventTypeCount; ++slot)
+        {
+            byType[slot].Merge(other.byType[slot]);
+        }
+        overall.Merge(other.overall);
+    }
+
+    // Lookups for ids/types that never appeared return an empty AggregateStats instead of throwing.
+    const AggregateStats& Source(SourceId id) const { return id < bySource.size() ? bySource[id] : EmptyStats(); }
+    const AggregateStats& Type(EventType type) const { return byType[TypeSlot(type)]; }
+    const AggregateStats& SourceAndType(SourceId id, EventType type) const
+    {
+        return id < bySource.size() ? bySourceAndType[id * EventTypeCount + TypeSlot(type)] : EmptyStats();
+    }
+
+private:
+    static const AggregateStats& EmptyStats()
+    {
+        static const AggregateStats empty{};
+        return empty;
+    }
+};
+
+// The one pass: rows [begin, end) of the store, every statistic for every key.
+inline AggregateReport AggregateEvents(const EventColumnStore& store, std::size_t begin, std::size_t end)
+{
+    AggregateReport report{};
+    report.bySource.resize(store.SourceCount());
+    report.bySourceAndType.resize(store.SourceCount() * EventTypeCount);
+
+    auto types = store.Types();
+    auto sourceIds = store.SourceIds();
+    auto values = store.Values();
+    for (std::size_t row = begin; row < end; ++row)
+    {
+        report.Add(types[row], sourceIds[row], values[row]);
+    }
+    return report;
+}
+
+inline AggregateReport AggregateEvents(const EventColumnStore& store)
+{
+    ESP_TIME_OPERATION("aggregate_events", store.Size());
+    return AggregateEvents(store, 0, store.Size());
+}
@@ -0,0 +1,411 @@
+#pragma once
+// Columnar (struct-of-arrays) event storage.
+// std::vector<SimulationEvent> keeps every field of a record side by side, so a scan over one field
+// (summing values, searching timestamps) drags the whole record and its std::string through cache.
+// EventColumnStore keeps one contiguous array per field instead; a query only touches the columns it reads.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "FlatHashMap.h"
+#include "Instrumentation.h"
+#include "RadixSort.h"
+#include "RowPartitions.h"
+#include "SimdKernels.h"
+#include "SimulationEvent.h"
+#include "SourceDictionary.h"
+
+class EventColumnStore
+{
+public:
+    EventColumnStore() = default;
+
+    // Stores built from the same dictionary agree on every SourceId, so their ids can be compared and merged directly.
+    explicit EventColumnStore(std::shared_ptr<SourceDictionary> dictionary)
+        : sources{ std::move(dictionary) }
+    {
+    }
+
+    explicit EventColumnStore(const std::vector<SimulationEvent>& events, std::shared_ptr<SourceDictionary> dictionary = std::make_shared<SourceDictionary>())// explicit: converting a whole log should never happen by accident
+        : sources{ std::move(dictionary) }
+    {
+        Reserve(events.size());
+        for (const SimulationEvent& event : events)
+        {
+            Append(event);
+        }
+    }
+
+    // Columns owned by someone else, e.g. a memory-mapped log (see BinaryEventLog.h). Nothing is copied:
+    // the store reads straight from the spans, and owner keeps that memory alive for as long as any copy of the store exists.
+    // The first Append()/Reserve() copies the columns into the store's own arrays (copy-on-write).
+    static EventColumnStore Borrow(std::shared_ptr<const void> owner,
+        std::span<const double> timestamps, std::span<const EventType> types, std::span<const SourceId> sourceIds, std::span<const double> values,
+        std::shared_ptr<SourceDictionary> dictionary)
+    {
+        EventColumnStore store{ std::move(dictionary) };
+        store.borrowed = std::make_shared<const BorrowedColumns>(BorrowedColumns{ std::move(owner), timestamps, types, sourceIds, values });
+        return store;
+    }
+
+    bool IsBorrowed() const { return borrowed != nullptr; }
+
+    void Reserve(std::size_t count)
+    {
+        DetachBorrowed();
+        timestamps.reserve(count);
+        types.reserve(count);
+        sourceIds.reserve(count);
+        values.reserve(count);
+    }
+
+    // Drops every row but keeps capacity and the dictionary, so a reused batch stops allocating after warm-up.
+    void Clear()
+    {
+        epoch = {};
+        borrowed.reset();
+        timestamps.clear();
+        types.clear();
+        sourceIds.clear();
+        values.clear();
+    }
+
+    void Append(const SimulationEvent& event)
+    {
+        Append(event.timestampSec, event.type, InternSource(event.source), event.value);
+    }
+
+    void Append(double timestampSec, EventType type, SourceId sourceId, double value)
+    {
+        DetachBorrowed();
+        timestamps.push_back(timestampSec);
+        types.push_back(type);
+        sourceIds.push_back(sourceId);
+        values.push_back(value);
+    }
+
+    // Returns the id of source, adding it to the dictionary the first time it is seen.
+    SourceId InternSource(std::string_view source) { return sources->Intern(source); }
+    std::optional<SourceId> FindSource(std::string_view source) const { return sources->Find(source); }// never inserts
+
+    const std::string& SourceName(SourceId id) const { return sources->Name(id); }
+    std::size_t SourceCount() const { return sources->Size(); }
+
+    const SourceDictionary& Sources() const { return *sources; }
+    const std::shared_ptr<SourceDictionary>& SharedSources() const { return sources; }
+
+    std::size_t Size() const { return Timestamps().size(); }
+    bool Empty() const { return Size() == 0; }
+
+    // Dataset version for cached results (QueryCache.h). While the epoch stays the same rows are only ever appended,
+    // so a result over the first n rows is still right and just needs rows n.. folded in. Clear() starts a new epoch,
+    // and so does every copy or assignment: two stores never share one, even when they start from the same rows.
+    std::uint64_t Epoch() const { return epoch.value; }
+
+    // One check per call, not per element: loops take the span once and index it.
+    std::span<const double> Timestamps() const { return borrowed ? borrowed->timestamps : std::span<const double>{ timestamps }; }
+    std::span<const EventType> Types() const { return borrowed ? borrowed->types : std::span<const EventType>{ types }; }
+    std::span<const SourceId> SourceIds() const { return borrowed ? borrowed->sourceIds : std::span<const SourceId>{ sourceIds }; }
+    std::span<const double> Values() const { return borrowed ? borrowed->values : std::span<const double>{ values }; }
+
+    // Rebuilds one row as a SimulationEvent (copies the source name, so keep it off hot paths).
+    SimulationEvent EventAt(EventIndex row) const
+    {
+        return { Timestamps()[row], Types()[row], sources->Name(SourceIds()[row]), Values()[row] };
+    }
+
+    std::vector<SimulationEvent> ToEvents() const
+    {
+        std::vector<SimulationEvent> events{};
+        events.reserve(Size());
+        for (std::size_t row = 0; row < Size(); ++row)
+        {
+            events.push_back(EventAt(static_cast<EventIndex>(row)));
+        }
+        return events;
+    }
+
+    // New store holding the given rows in the given order; it shares this store's dictionary, so the source ids stay valid.
+    EventColumnStore Gather(std::span<const EventIndex> rows) const
+    {
+        EventColumnStore gathered{ sources };
+        gathered.Reserve(rows.size());
+
+        auto fromTimestamps = Timestamps();
+        auto fromTypes = Types();
+        auto fromSourceIds = SourceIds();
+        auto fromValues = Values();
+        for (EventIndex row : rows)
+        {
+            gathered.Append(fromTimestamps[row], fromTypes[row], fromSourceIds[row], fromValues[row]);
+        }
+        return gathered;
+    }
+
+private:
+    struct BorrowedColumns
+    {
+        std::shared_ptr<const void> owner{};
+        std::span<const double> timestamps{};
+        std::span<const EventType> types{};
+        std::span<const SourceId> sourceIds{};
+        std::span<const double> values{};
+    };
+
+    void DetachBorrowed()
+    {
+        if (!borrowed)
+        {
+            return;
+        }
+        timestamps.assign(borrowed->timestamps.begin(), borrowed->timestamps.end());
+        types.assign(borrowed->types.begin(), borrowed->types.end());
+        sourceIds.assign(borrowed->sourceIds.begin(), borrowed->sourceIds.end());
+        values.assign(borrowed->values.begin(), borrowed->values.end());
+        borrowed.reset();
+    }
+
+    std::vector<double> timestamps{};
+    std::vector<EventType> types{};
+    std::vector<SourceId> sourceIds{};
+    std::vector<double> values{};
+
+    struct StoreEpoch
+    {
+        std::uint64_t value{ Next() };
+
+        StoreEpoch() = default;
+        StoreEpoch(const StoreEpoch&) : value{ Next() } {}
+        StoreEpoch& operator=(const StoreEpoch&)
+        {
+            value = Next();
+            return *this;
+        }
+
+        static std::uint64_t Next()
+        {
+            static std::atomic<std::uint64_t> next{ 1 };
+            return next.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    std::shared_ptr<SourceDictionary> sources{ std::make_shared<SourceDictionary>() };
+    std::shared_ptr<const BorrowedColumns> borrowed{};// set only for Borrow()ed stores
+    StoreEpoch epoch{};
+};
+
+// ** Columnar ports of the vector<SimulationEvent> tasks **
+// Same names as the originals so call sites only change the type they pass in.
+
+//1. Sort by timestamp: radix-sort the timestamp column into a permutation (RadixSort.h), then gather every column once.
+inline std::vector<EventIndex> SortedOrderByTime(const EventColumnStore& store, bool isAscending = true)
+{
+    ESP_TIME_OPERATION("sort_by_time", store.Size());
+    return RadixSortedOrder(store.Timestamps(), isAscending);
+}
+
+inline EventColumnStore SortByTime(const EventColumnStore& store)
+{
+    return store.Gather(SortedOrderByTime(store));
+}
+
+//2. Filter by type: the SIMD kernel scans only the type column and yields a selection vector of matching rows.
+// Use the selection directly when the caller can work with row numbers; FilterByType gathers it into a new store.
+inline std::vector<EventIndex> SelectByType(const EventColumnStore& store, EventType typeToFilter)
+{
+    ESP_TIME_OPERATION("select_by_type", store.Size());
+    return SelectByType(store.Types(), typeToFilter);
+}
+
+inline std::vector<EventIndex> SelectBySource(const EventColumnStore& store, SourceId source)
+{
+    ESP_TIME_OPERATION("select_by_source", store.Size());
+    return SelectBySource(store.SourceIds(), source);
+}
+
+inline EventColumnStore FilterByType(const EventColumnStore& store, EventType typeToFilter)
+{
+    return store.Gather(SelectByType(store, typeToFilter));
+}
+
+//3. Group by type/source: each group is a list of row numbers; call Gather() on it if a standalone store is needed.
+inline FlatHashMap<EventType, std::vector<EventIndex>> GroupByType(const EventColumnStore& store)// dense enum key: an array of 3 lists
+{
+    ESP_TIME_OPERATION("group_by_type", store.Size());
+    FlatHashMap<EventType, std::vector<EventIndex>> grouped{};
+
+    auto types = store.Types();
+    for (std::size_t row = 0; row < types.size(); ++row)
+    {
+        grouped[types[row]].push_back(static_cast<EventIndex>(row));
+    }
+    return grouped;
+}
+
+// Flat array indexed by SourceId: no hashing at all, and sources with no events just have an empty list.
+inline std::vector<std::vector<EventIndex>> GroupBySourceId(const EventColumnStore& store)
+{
+    ESP_TIME_OPERATION("group_by_source", store.Size());
+    std::vector<std::vector<EventIndex>> grouped(store.SourceCount());
+
+    auto sourceIds = store.SourceIds();
+    for (std::size_t row = 0; row < sourceIds.size(); ++row)
+    {
+        grouped[sourceIds[row]].push_back(static_cast<EventIndex>(row));
+    }
+    return grouped;
+}
+
+inline FlatStringMap<std::vector<EventIndex>> GroupBySource(const EventColumnStore& store)
+{
+    // Bucket by id first (no string hashing per event), then attach the names once per source.
+    auto byId = GroupBySourceId(store);
+
+    FlatStringMap<std::vector<EventIndex>> grouped{};
+    grouped.Reserve(byId.size());
+    for (SourceId id = 0; id < byId.size(); ++id)
+    {
+        if (!byId[id].empty())
+        {
+            grouped.TryEmplace(store.SourceName(id), std::move(byId[id]));
+        }
+    }
+    return grouped;
+}
+
+// Contiguous partitions (RowPartitions.h): one count pass and one scatter pass, every group a span of one shared buffer.
+// Preferred over the vector-per-group versions above for per-source loops; pass an arena resource to make it allocation-free.
+inline RowPartitions PartitionBySourceId(const EventColumnStore& store, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+{
+    ESP_TIME_OPERATION("partition_by_source", store.Size());
+    RowPartitions partitions{ resource };
+    PartitionRows(store.SourceIds(), store.SourceCount(), partitions);
+    return partitions;
+}
+
+inline RowPartitions PartitionByType(const EventColumnStore& store, std::pmr::memory_resource* resource = std::pmr::get_default_resource())// group k is static_cast<EventType>(k)
+{
+    ESP_TIME_OPERATION("partition_by_type", store.Size());
+    RowPartitions partitions{ resource };
+    PartitionRows(store.Types(), EventTypeCount, partitions);
+    return partitions;
+}
+
+// ** Arena versions (QueryArena.h) **
+// Same results in std::pmr containers drawn from `resource`; group sizes are counted first so no group ever regrows
+// (a monotonic arena cannot reuse what a regrowing vector leaves behind).
+
+inline std::pmr::vector<EventIndex> SelectByType(const EventColumnStore& store, EventType typeToFilter, std::pmr::memory_resource* resource)
+{
+    ESP_TIME_OPERATION("select_by_type", store.Size());
+    std::pmr::vector<EventIndex> selection{ resource };
+    SelectByType(store.Types(), typeToFilter, selection);
+    return selection;
+}
+
+inline std::pmr::vector<EventIndex> SelectBySource(const EventColumnStore& store, SourceId source, std::pmr::memory_resource* resource)
+{
+    ESP_TIME_OPERATION("select_by_source", store.Size());
+    std::pmr::vector<EventIndex> selection{ resource };
+    SelectBySource(store.SourceIds(), source, selection);
+    return selection;
+}
+
+inline std::pmr::vector<std::pmr::vector<EventIndex>> GroupBySourceId(const EventColumnStore& store, std::pmr::memory_resource* resource)
+{
+    ESP_TIME_OPERATION("group_by_source", store.Size());
+    auto sourceIds = store.SourceIds();
+    std::pmr::vector<std::size_t> counts(store.SourceCount(), resource);
+    for (SourceId id : sourceIds)
+    {
+        ++counts[id];
+    }
+
+    std::pmr::vector<std::pmr::vector<EventIndex>> grouped{ resource };// inner vectors inherit the resource
+    grouped.resize(store.SourceCount());
+    for (SourceId id = 0; id < grouped.size(); ++id)
+    {
+        grouped[id].reserve(counts[id]);
+    }
+    for (std::size_t row = 0; row < sourceIds.size(); ++row)
+    {
+        grouped[sourceIds[row]].push_back(static_cast<EventIndex>(row));
+    }
+    return grouped;
+}
+
+inline std::pmr::vector<std::pmr::vector<EventIndex>> GroupByType(const EventColumnStore& store, std::pmr::memory_resource* resource)// indexed by static_cast<size_t>(type)
+{
+    ESP_TIME_OPERATION("group_by_type", store.Size());
+    auto types = store.Types();
+    std::array<std::size_t, EventTypeCount> counts{};
+    for (EventType type : types)
+    {
+        ++counts[static_cast<std::size_t>(type)];
+    }
+
+    std::pmr::vector<std::pmr::vector<EventIndex>> grouped{ resource };
+    grouped.resize(EventTypeCount);
+    for (std::size_t slot = 0; slot < EventTypeCount; ++slot)
+    {
+        grouped[slot].reserve(counts[slot]);
+    }
+    for (std::size_t row = 0; row < types.size(); ++row)
+    {
+        grouped[static_cast<std::size_t>(types[row])].push_back(static_cast<EventIndex>(row));
+    }
+    return grouped;
+}
+
+//4. Totals: only the sourceIds and values columns are read, comparing 32-bit ids instead of strings.
+inline double ComputeTotalValueBySource(const EventColumnStore& store, SourceId source)
+{
+    ESP_TIME_OPERATION("total_by_source", store.Size());
+    return SumWhereSource(store.SourceIds(), store.Values(), source);// id compare -> bitmask -> masked sum, no branch per event
+}
+
+inline double ComputeTotalValueBySource(const EventColumnStore& store, std::string_view source)// name is resolved once, not per event
+{
+    auto id = store.FindSource(source);
+    return id ? ComputeTotalValueBySource(store, *id) : 0.0;
+}
+
+// Every source's total in one pass, indexed by SourceId.
+inline std::vector<double> ComputeTotalValueBySourceId(const EventColumnStore& store)
+{
+    ESP_TIME_OPERATION("totals_by_source", store.Size());
+    std::vector<double> totals(store.SourceCount(), 0.0);
+
+    auto sourceIds = store.SourceIds();
+    auto values = store.Values();
+    for (std::size_t row = 0; row < values.size(); ++row)
+    {
+        totals[sourceIds[row]] += values[row];
+    }
+    return totals;
+}
+
+inline double AcumulatebySource(const EventColumnStore& store, EventType type)
+{
+    ESP_TIME_OPERATION("total_by_type", store.Size());
+    return SumWhereType(store.Types(), store.Values(), type);
+}
+
+//5. First event after a threshold: scans the timestamp column only; returns the row, or nullopt if none found.
+inline std::optional<EventIndex> FirstEventAfter(const EventColumnStore& store, double thresholdTime)
+{
+    ESP_TIME_OPERATION("first_event_after", 0);// stops at the first match: no event count
+    auto timestamps = store.Timestamps();
+    auto it = std::ranges::find_if(timestamps, [thresholdTime](double t) { return t > thresholdTime; });
+
+    return it != timestamps.end() ? std::optional<EventIndex>{ static_cast<EventIndex>(it - timestamps.begin()) } : std::nullopt;
+}
@@ -0,0 +1,114 @@
+#pragma once
+// Synthetic event logs at realistic scale, for the benchmarks and for trying the GUI/CLI on more than the mock events.
+// Deterministic for a given seed: the same options always give the same log, so benchmark runs are comparable.
+// Timestamps advance at rateHz; disorderSec pushes a share of them later by up to that much, which is how
+// out-of-order arrival looks to the sort, the reorder buffer and the window operators (0 gives a sorted log).
+// The store version writes the columns directly (no per-event std::string), so 100M events fit in about 2 GB.
+//
+//   EventColumnStore store = GenerateEventStore({ .events = 10'000'000, .sources = 256, .disorderSec = 0.5 });
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "EventColumnStore.h"
+#include "SimulationEvent.h"
+#include "SourceDictionary.h"
+
+struct EventGeneratorOptions
+{
+    std::size_t events{ 1'000'000 };
+    std::size_t sources{ 16 };          // source cardinality
+    double rateHz{ 1000.0 };            // events per simulated second
+    double disorderSec{ 0.0 };          // a disordered event is pushed later by up to this much
+    double disorderFraction{ 1.0 };     // share of events that get the jitter
+    std::uint64_t seed{ 42 };
+};
+
+// SplitMix64: cheap, and good enough to keep the branch predictor and the hash tables honest.
+struct GeneratorRandom
+{
+    std::uint64_t state{};
+
+    std::uint64_t Next()
+    {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    double Unit() { return static_cast<double>(Next() >> 11) * 0x1.0p-53; }// [0, 1)
+    std::size_t Below(std::size_t bound) { return static_cast<std::size_t>(Next() % bound); }// the modulo bias is far below anything a benchmark notices
+};
+
+// The mock log's names first, then sensorN.
+inline std::string GeneratedSourceName(std::size_t index)
+{
+    static constexpr std::array<std::string_view, 7> Known{ "engine1", "engine2", "altimeter", "pilot", "rudder", "flaps", "aileron" };
+    return index < Known.size() ? std::string{ Known[index] } : "sensor" + std::to_string(index);
+}
+
+// Calls emit(timestampSec, type, sourceIndex, value) once per event, in arrival order.
+template <typename Emit>
+void GenerateEvents(const EventGeneratorOptions& options, Emit emit)
+{
+    GeneratorRandom random{ options.seed };
+    const std::size_t sources = options.sources > 0 ? options.sources : 1;
+    const double step = options.rateHz > 0.0 ? 1.0 / options.rateHz : 0.0;
+
+    for (std::size_t index = 0; index < options.events; ++index)
+    {
+        double timestampSec = static_cast<double>(index) * step;
+        if (options.disorderSec > 0.0 && random.Unit() < options.disorderFraction)
+        {
+            timestampSec += random.Unit() * options.disorderSec;
+        }
+
+        // Mostly sensor readings, like a real sim log: 60% sensor, 25% control, 15% actuator.
+        const std::size_t roll = random.Below(100);
+        const EventType type = roll < 60 ? EventType::SENSOR_READING : roll < 85 ? EventType::CONTROL_INPUT : EventType::ACTUATOR_COMMAND;
+        const std::size_t source = random.Below(sources);
+        const double value = static_cast<double>(source % 10) * 100.0 + random.Unit() * 100.0;
+        emit(timestampSec, type, source, value);
+    }
+}
+
+inline EventColumnStore GenerateEventStore(const EventGeneratorOptions& options, std::shared_ptr<SourceDictionary> dictionary = std::make_shared<SourceDictionary>())
+{
+    EventColumnStore store{ std::move(dictionary) };
+    std::vector<SourceId> ids(options.sources > 0 ? options.sources : 1);
+    for (std::size_t index = 0; index < ids.size(); ++index)
+    {
+        ids[index] = store.InternSource(GeneratedSourceName(index));
+    }
+
+    store.Reserve(options.events);
+    GenerateEvents(options, [&](double timestampSec, EventType type, std::size_t source, double value)
+        {
+            store.Append(timestampSec, type, ids[source], value);
+        });
+    return store;
+}
+
+// Same log as GenerateEventStore with the same options, as SimulationEvents (one std::string per event).
+inline std::vector<SimulationEvent> GenerateEventVector(const EventGeneratorOptions& options)
+{
+    std::vector<std::string> names(options.sources > 0 ? options.sources : 1);
+    for (std::size_t index = 0; index < names.size(); ++index)
+    {
+        names[index] = GeneratedSourceName(index);
+    }
+
+    std::vector<SimulationEvent> events{};
+    events.reserve(options.events);
+    GenerateEvents(options, [&](double timestampSec, EventType type, std::size_t source, double value)
+        {
+            events.push_back({ timestampSec, type, names[source], value });
+        });
+    return events;
+}
@@ -0,0 +1,305 @@
+#pragma once
+// Bounded lock-free queues that carry events from producer threads to the processing thread.
+//   SpscRingBuffer: one producer, one consumer. Each side writes only its own index; the other index is cached and
+//                   re-read only when the cache says full/empty, so a push is a store plus a release-store.
+//   MpscRingBuffer: many producers, one consumer (sensor, control and actuator threads into one pipeline). Producers claim
+//                   a slot with one compare-exchange on the tail; every slot carries a sequence number that tells the
+//                   consumer when it is filled and the producers when it is free again (Vyukov's bounded queue).
+// Both are fixed-size rings of a power-of-two capacity: nothing is allocated after construction.
+//
+// Backpressure: TryPush returns false when the ring is full, so the producer decides to retry, drop or slow down;
+// PushWithBackoff spins then yields until there is room. SizeApprox() lets a producer back off before the ring fills.
+// The consumer pops in batches (TryPopBatch), and EventQueueConsumer feeds those batches straight into a Pipeline.
+//
+// Records are QueuedEvent, the compact 24-byte form: no std::string crosses the queue.
+// NOTE: SourceDictionary is not thread-safe. Intern every source a producer will use up front, on one thread, and hand
+// the producers their SourceIds.
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "EventColumnStore.h"
+#include "Instrumentation.h"
+#include "Pipeline.h"
+#include "SimulationEvent.h"
+#include "SourceDictionary.h"
+
+inline constexpr std::size_t CacheLineBytes = 64;
+
+struct QueuedEvent
+{
+    double timestampSec{};
+    double value{};
+    SourceId sourceId{};
+    EventType type{};
+};
+static_assert(sizeof(QueuedEvent) == 24, "QueuedEvent should stay compact");
+
+//1. Single producer, single consumer.
+template <typename T>
+class SpscRingBuffer
+{
+    static_assert(std::is_trivially_copyable_v<T>, "ring slots are copied, not constructed");
+
+public:
+    explicit SpscRingBuffer(std::size_t capacity)
+        : capacity{ std::bit_ceil(std::max<std::size_t>(capacity, 2)) }, mask{ this->capacity - 1 }, slots{ std::make_unique<T[]>(this->capacity) }
+    {
+    }
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    // Producer thread only.
+    bool TryPush(const T& value)
+    {
+        const std::size_t tail = producer.tail.load(std::memory_order_relaxed);
+        if (tail - producer.cachedHead == capacity)
+        {
+            producer.cachedHead = consumer.head.load(std::memory_order_acquire);
+            if (tail - producer.cachedHead == capacity)
+            {
+                return false;// full
+            }
+        }
+        slots[tail & mask] = value;
+        producer.tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer thread only. Pushes as many as fit; returns how many.
+    std::size_t TryPushBatch(std::span<const T> values)
+    {
+        const std::size_t tail = producer.tail.load(std::memory_order_relaxed);
+        if (capacity - (tail - producer.cachedHead) < values.size())
+        {
+            producer.cachedHead = consumer.head.load(std::memory_order_acquire);
+        }
+        const std::size_t count = std::min(values.size(), capacity - (tail - producer.cachedHead));
+        for (std::size_t at = 0; at < count; ++at)
+        {
+            slots[(tail + at) & mask] = values[at];
+        }
+        producer.tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer thread only. Pops up to out.size() values; returns how many.
+    std::size_t TryPopBatch(std::span<T> out)
+    {
+        const std::size_t head = consumer.head.load(std::memory_order_relaxed);
+        if (consumer.cachedTail - head < out.size())
+        {
+            consumer.cachedTail = producer.tail.load(std::memory_order_acquire);
+        }
+        const std::size_t count = std::min(out.size(), consumer.cachedTail - head);
+        for (std::size_t at = 0; at < count; ++at)
+        {
+            out[at] = slots[(head + at) & mask];
+        }
+        consumer.head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    std::size_t Capacity() const { return capacity; }
+    std::size_t SizeApprox() const { return producer.tail.load(std::memory_order_relaxed) - consumer.head.load(std::memory_order_relaxed); }
+
+private:
+    // Each side's indices on their own cache line, so the producer and the consumer never write the same line.
+    struct alignas(CacheLineBytes) ProducerSide
+    {
+        std::atomic<std::size_t> tail{};
+        std::size_t cachedHead{};
+    };
+    struct alignas(CacheLineBytes) ConsumerSide
+    {
+        std::atomic<std::size_t> head{};
+        std::size_t cachedTail{};
+    };
+
+    const std::size_t capacity;
+    const std::size_t mask;
+    std::unique_ptr<T[]> slots;
+    ProducerSide producer{};
+    ConsumerSide consumer{};
+};
+
+//2. Many producers, single consumer.
+template <typename T>
+class MpscRingBuffer
+{
+    static_assert(std::is_trivially_copyable_v<T>, "ring slots are copied, not constructed");
+
+public:
+    explicit MpscRingBuffer(std::size_t capacity)
+        : capacity{ std::bit_ceil(std::max<std::size_t>(capacity, 2)) }, mask{ this->capacity - 1 }, slots{ std::make_unique<Slot[]>(this->capacity) }
+    {
+        for (std::size_t index = 0; index < this->capacity; ++index)
+        {
+            slots[index].sequence.store(index, std::memory_order_relaxed);// slot i is free for the push at position i
+        }
+    }
+
+    MpscRingBuffer(const MpscRingBuffer&) = delete;
+    MpscRingBuffer& operator=(const MpscRingBuffer&) = delete;
+
+    // Any thread.
+    bool TryPush(const T& value)
+    {
+        std::size_t position = producers.tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Slot& slot = slots[position & mask];
+            const std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto lag = static_cast<std::ptrdiff_t>(sequence - position);
+            if (lag == 0)
+            {
+                if (producers.tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    slot.value = value;
+                    slot.sequence.store(position + 1, std::memory_order_release);// filled: the consumer may read it
+                    return true;
+                }
+                // lost the race: position now holds the current tail, retry there
+            }
+            else if (lag < 0)
+            {
+                return false;// the slot still holds a value from one lap ago: full
+            }
+            else
+            {
+                position = producers.tail.load(std::memory_order_relaxed);// another producer took this slot
+            }
+        }
+    }
+
+    // Consumer thread only. Pops up to out.size() filled slots, in order; returns how many.
+    std::size_t TryPopBatch(std::span<T> out)
+    {
+        std::size_t head = consumer.head;
+        std::size_t count = 0;
+        while (count < out.size())
+        {
+            Slot& slot = slots[head & mask];
+            if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+            {
+                break;// empty, or the producer that claimed it has not finished writing
+            }
+            out[count++] = slot.value;
+            slot.sequence.store(head + capacity, std::memory_order_release);// free for the push one lap later
+            ++head;
+        }
+        consumer.head = head;
+        consumer.published.store(head, std::memory_order_relaxed);
+        return count;
+    }
+
+    std::size_t Capacity() const { return capacity; }
+    std::size_t SizeApprox() const { return producers.tail.load(std::memory_order_relaxed) - consumer.published.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot
+    {
+        std::atomic<std::size_t> sequence{};
+        T value{};
+    };
+    struct alignas(CacheLineBytes) ProducerSide
+    {
+        std::atomic<std::size_t> tail{};
+    };
+    struct alignas(CacheLineBytes) ConsumerSide
+    {
+        std::size_t head{};
+        std::atomic<std::size_t> published{};   // head as seen by SizeApprox() on other threads
+    };
+
+    const std::size_t capacity;
+    const std::size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    ProducerSide producers{};
+    ConsumerSide consumer{};
+};
+
+// Blocking push for producers that must not drop: spin briefly (the consumer is usually mid-batch), then yield.
+template <typename Queue, typename T>
+void PushWithBackoff(Queue& queue, const T& value)
+{
+    for (int attempt = 0; !queue.TryPush(value); ++attempt)
+    {
+        if (attempt >= 64)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+//3. Consumer side: pops batches of up to PipelineBatchRows events and pushes each one through a pipeline.
+template <typename Queue>
+class EventQueueConsumer
+{
+public:
+    EventQueueConsumer(Queue& queue, BatchOperator& pipeline, std::shared_ptr<SourceDictionary> dictionary)
+        : queue{ queue }, pipeline{ pipeline }, batch{ std::move(dictionary) }, popped(PipelineBatchRows), rows(PipelineBatchRows)
+    {
+        std::iota(rows.begin(), rows.end(), EventIndex{ 0 });
+        batch.Reserve(PipelineBatchRows);
+    }
+
+    // Moves at most one batch from the queue into the pipeline; returns the number of events (0 when the queue is empty).
+    std::size_t Poll()
+    {
+        const std::size_t count = queue.TryPopBatch(popped);
+        if (count == 0)
+        {
+            return 0;
+        }
+        ESP_TIME_OPERATION("queue_poll", count);// the pipeline push included
+        batch.Clear();
+        for (std::size_t at = 0; at < count; ++at)
+        {
+            const QueuedEvent& event = popped[at];
+            batch.Append(event.timestampSec, event.type, event.sourceId, event.value);
+        }
+        pipeline.Push({ batch, { rows.data(), count }, true });
+        consumed += count;
+        return count;
+    }
+
+    // Drains until the queue is empty and every producer has said it is done, then finishes the pipeline.
+    void Run(const std::atomic<bool>& producersDone)
+    {
+        for (;;)
+        {
+            if (Poll() > 0)
+            {
+                continue;
+            }
+            if (producersDone.load(std::memory_order_acquire))
+            {
+                while (Poll() > 0) {}// anything pushed just before the flag was set
+                break;
+            }
+            std::this_thread::yield();
+        }
+        pipeline.Finish();
+    }
+
+    std::uint64_t Consumed() const { return consumed; }
+
+private:
+    Queue& queue;
+    BatchOperator& pipeline;
+    EventColumnStore batch;
+    std::vector<QueuedEvent> popped;
+    std::vector<EventIndex> rows;
+    std::uint64_t consumed{};
+};
@@ -0,0 +1,232 @@
+//Event Stream Processing tasks
+//Simulate a log of timestamped events(sensor readings, actuator commands).You need to :
+//  Parse / store SimulationEvent structs.
+//  Sort them by time.
+//  Filter by event type or component.
+//  Accumulate values like total force, average RPM, etc.
+
+//Problem Prompt:
+//You are given a sequence of discrete simulation events representing actions or readings in a flight simulation environment.Each event is defined with EventType.
+//Write the functions using C++20 and STL algorithms :
+
+#include <algorithm>   // for std::ranges::sort
+#include <iterator>
+#include <memory>
+#include <numeric>   // for std::accumulate
+#include <string>
+#include <vector>
+
+#include "EventTasks.h"
+#include "EventViews.h"
+#include "FlatHashMap.h"
+#include "Instrumentation.h"
+#include "Query.h"
+#include "SimulationEvent.h"
+
+// ** TASKS **
+//1. Sort Events by Timestamp
+std::vector<SimulationEvent> SortByTime(const std::vector<SimulationEvent>& events)
+{
+    auto sorted = GatherEvents(events, SortedOrderByTime(events));// radix sort on the keys (RadixSort.h), then one copy per event
+
+    //std::ranges::sort(sorted, {}, sorted.timestampSec);//why wouldn't this work? => sorted is a vector of SimulationEvent, we need to look into each SimulationEvent to access the memeber timestampSec
+    //std::ranges::sort(sorted, {}, &SimulationEvent::timestampSec);//and why are we using memeber pointer here? what are the underlying reason? what  are the rule of thumb for using memeber pointer as arguments? 
+    // => projection argument( how to extract a key from each element in the range): underneath is a pointer to member, so for each element in the range(each event), the projection access the members like this: | event.*(&SimulationEvent::timestampSec) |
+    // => is to say: "sort by this field"
+    return sorted;
+}
+
+std::vector<SimulationEvent> SortByTimeAndReturnACopy(const std::vector<SimulationEvent>& events)
+{
+    return GatherEvents(events, SortedOrderByTime(events));
+}
+
+void SortEventsByTime(std::vector<SimulationEvent>& events)// Key STL concept: sort with a projection.
+{
+    //std::ranges::sort(events, {}, &SimulationEvent::timestampSec);//Sort events in ascending order using the value of timestampSec for comparison
+    ApplyOrder(events, SortedOrderByTime(events));// each event moves once instead of O(n log n) times
+	//NOTE: ranges::sort() is in-place; the caller prints if it wants to (PrintEvents), the sort never does
+}
+
+std::vector<EventIndex> SortEventsByTime(const std::vector<SimulationEvent>& events, bool isAscending)//is this const a legal overload? => yes: const std::vector& and std::vector& are different parameter types, whatever the return type (the default argument lives in EventTasks.h)
+{
+    return SortedOrderByTime(events, isAscending);// one radix sort for both directions, no std::greater branch; PermutedView(events, order) reads it in order without copying a single event
+}
+
+// Explanation:
+// - std::ranges::sort is part of the new C++20 ranges library.
+// - It allows a "projection" function (the 3rd argument here), which is like saying:
+//     "please compare elements by their .timestamp field".
+// - Equivalent to writing a lambda: [](const auto& a, const auto& b) { return a.timestamp < b.timestamp; }
+// - But using `&SimulationEvent::timestamp` is more concise, idiomatic, and efficient.
+
+// ** QUESTIONS **
+//1. what does discrete means in "discrete simulation events"?
+//  => evolves in steps, not continuously, only log when something actually happens
+//2. std::ranges::sort(events, {}, &SimulationEvent::timestampSec); => what is the {} for?,  and what does 3rd argument called "projection" mean? shouldn't it mean comparison?
+//  => {} means empty which means default comparator, which is "<" aka "less than" which means sort in ascending order
+//3. is ranges::sort() in place? as in does it change the origianal data? what if the original data should not be changed?
+//  => yes, in-place, Make a copy first if don't want change
+
+
+//2. Filter Events by Source & Type
+std::vector<SimulationEvent> FilterByType(const std::vector<SimulationEvent>& events, EventType typeToFilter)
+{
+    ESP_TIME_OPERATION("vector_filter_by_type", events.size());
+    std::vector<SimulationEvent> filtered{};
+
+    std::ranges::copy_if
+    (
+        events, 
+        std::back_inserter(filtered), //(source, output, predicate), predicate is a lambda, a condition
+        [typeToFilter](const SimulationEvent& ev)//have to capture the value of typeToFilter because lambda are saperate scope like a differernt function, not a normal codeblock; Copy elements from events into filtered
+        {//always const xxx& x, if we don't want to change the input
+            return ev.type == typeToFilter; // but only if their type == typeToFilter.
+        }
+    );//last arg: lambda predicate; captures typeToFilter by value
+
+    return filtered;
+}
+// Key idea: Use ranges::views::filter to create a lazy-filtered range
+// Then convert it into a new vector using ranges::to (in <ranges> in C++23,
+// or just use std::copy for C++20 fallback)
+
+// ** QUESTIONS **
+//1. std::ranges::copy_if()'s argument are crazy, can you break everything down? so much going on
+// => (source, output iteritor, lambda predicate)
+//2. why is type's value needs to be captured? doesn't it live inside copy_if()? which is inside the bigger function scope which should have access to the argument of the bigger function which have type already? how can I conceptulize lambda's scope and access?
+// => lambdas are separate function objects, not regular code blocks.
+
+//3. Group Events by Type/Source
+//Return a std::unordered_map<std::string, std::vector<SimulationEvent>> where each key is the source name.
+FlatHashMap<EventType, std::vector<SimulationEvent>> GroupByType(const std::vector<SimulationEvent>& events, const EventType& type)// 3 types => an array of 3 groups, no hashing (FlatHashMap.h)
+{
+    FlatHashMap<EventType, std::vector<SimulationEvent>> grouped{};
+
+    for (const auto& event : events)
+    {
+        grouped[event.type].push_back(event);
+    }
+    //learned from mistake: what is the value's structure? need to put more thoughts into that, I initally made the value as one event which of course is not right, it's a vector of events, make sense if I just take a minute to think about it, each group SHOULD have MULTIPLE events!
+    return grouped;
+}
+
+FlatStringMap<std::vector<SimulationEvent>> GroupBySource(const std::vector<SimulationEvent>& events)// flat open-addressing table instead of a node per key
+{
+    ESP_TIME_OPERATION("vector_group_by_source", events.size());
+    FlatStringMap<std::vector<SimulationEvent>> grouped{};
+
+    for (const SimulationEvent& event : events)
+    {
+        grouped[event.source].push_back(event);//would this make a new key pair if have not seen it before?
+    }
+    return grouped;
+    //{
+    //{"sources", [event0, event2]}, 
+    //{"source1", [event1, event4]},
+    //...
+    //}
+}
+
+FlatStringMap<std::vector<SimulationEvent>> GroupBySources(const std::vector<SimulationEvent>& events)
+{
+    //pre. translate into a hashmap
+    //1. loop through, 
+    //2. add into Grouped by it's source
+    FlatStringMap<std::vector<SimulationEvent>> GroupedBySource{};//{ key: "source", value: {event0, event1, event2 }
+    for (const SimulationEvent& event : events)
+    {
+            GroupedBySource[event.source].push_back(event);//[] operator is overloaded, it'll add new key and new values if not exist yet => side effect: if look up with [] it will add the key, use .find() instead
+    }
+    return GroupedBySource;
+}
+// We want to group all events that came from the same source string.
+// A map from string (source) to vector of events is the natural structure.
+
+//4. Compute Total Value for a Given Source, Return the sum of.value for a specific source.
+// The by-source totals below are one query shape (Query.h): sum of value where source == name.
+double Acumulate(const std::vector<SimulationEvent>& events, const std::string& source)
+{
+    return Aggregate<Sum, Where<SourceNameIs>>::Run(events, { SourceNameIs{ source } });
+}
+
+double AcumulatebySource(const std::vector<SimulationEvent>& events, const EventType& type)
+{
+    return std::accumulate(events.begin(), events.end(), 0.0,
+        [&type](double sum, const SimulationEvent& event)//what is the rule comes to the const XXX& parameter in a lambda function? => same with normal function: 1. non-trival to copy. 2. don't wish to mutate original
+        //why not const double& xx => avoid pointer-indriection, compiler can make it pass-by-register(by value but do not involve copying, CPU's register can just store the double and other primare types),
+        //which is cheaper than passing by reference; because passing by reference still need to pass the pointer); pass-by-register is 0-1 cpu cycles(no memory lookup), pass-by-reference takes 1-4 cycles
+        {
+            return sum + (type == event.type ? event.value : 0.0);//why do we have to return for the second time? => this lambda return's a value to the std::acumulate() at each step(with a new sum each time for the algo)
+        });
+}
+
+double AcumulateTotalBySource(const std::vector<SimulationEvent>& events, const std::string& source)
+{
+    return Aggregate<Sum, Where<SourceNameIs>>::Run(events, { SourceNameIs{ source } });
+}
+
+double AccumalateValueBySource(const std::vector<SimulationEvent>& events, const std::string& source)
+{
+    return std::accumulate(events.begin(), events.end(), 0.0,//start with the return?? is this the only way to write?
+        [&source](double sum, const SimulationEvent& event)//You MUST follow the signature that accumulate(): (accumulated_value, current_element)
+            { 
+                return sum + (event.source == source ? event.value : 0.0);//does the lamdbda HAVE to be in this format??
+                //=> YES, in the case of this lambda's parameters 
+                //the body of lamdbda tells the acumulate() HOW to combine them
+                //MUST return the updated accumulator.
+            }
+        );//how can I conceptualize it? so hard to memerize the syntax, for the lambda, what is the thought process behind the syntax?
+}
+
+double ComputeTotalValueBySource(const std::vector<SimulationEvent>& events, const std::string& source)
+{
+    return Aggregate<Sum, Where<SourceNameIs>>::Run(events, { SourceNameIs{ source } });
+}
+
+//5. Find the First Event After a Time Threshold
+//Return a pointer to the first event after a given timestamp(or nullptr if none found).
+const SimulationEvent* FirstEvent(const std::vector<SimulationEvent>& events, double time)
+{
+    auto iterator = std::ranges::find_if(events,
+        [&time](const SimulationEvent& event)
+        {
+            return event.timestampSec > time;
+        });
+
+    //return iterator != events.end() ? &(*iterator) : nullptr;
+    return iterator != events.end() ? std::to_address(iterator) : nullptr;
+}
+
+const SimulationEvent* FirstEventAfter(const std::vector<SimulationEvent>& events, double thresholdTime)//const SimulationEvent* return a pointer to the event, but I never seen this syntax before, is this regular?
+//returning a pointer to a 'const SimulationEvent', the caller can read, but can not mutate, AKA returning a read only pointer; plus, can return a nullptr if no valid object exits
+{
+    auto it = std::ranges::find_if(events,//find more info on find_if() basics, argument types, lambda requirments, qurik etc
+        //=> (range, unary predicate), returns a iterator, returns .end() if not found
+                [&thresholdTime](const SimulationEvent& event)//HAVE TO BE: take one argument(element matches container's type), and return a bool
+                {
+                    return event.timestampSec > thresholdTime;//true for the matching case
+                });
+
+    return (it != events.end()) ? &(*it) : nullptr;//why compare to the last iterator? 
+    // => MUST check valid before access it, .end() indicate invaild found
+    //what is this??&(*it)
+    // => *it: dereference it to get the actual event
+    // &(): get the address of the event; AKA, a pointer
+    // NOTE: I have the wrong Conception that a literator is a pointer
+    // => A pointer is a kind of iterator, but not all iterators are pointers. => a iterator is a pointer with some logics built in; some cannot just be dereferenced
+}
+
+const SimulationEvent* FirstEventAfterThis(
+    const std::vector<SimulationEvent>& events,
+    double thresholdTime)
+{
+    // Use std::ranges::find_if to find the first event where timestamp > threshold
+    auto it = std::ranges::find_if(events,
+        [thresholdTime](const SimulationEvent& ev) {
+            return ev.timestampSec > thresholdTime;
+        });
+
+    // Return a pointer if found, or nullptr if not
+    return (it != events.end()) ? &(*it) : nullptr;
+}
@@ -0,0 +1,52 @@
+#pragma once
+// The original exercise tasks over std::vector<SimulationEvent>: sort, filter, group, accumulate, first-after-t.
+// Defined in EventTasks.cpp, so the GUI, the CLI and the benchmarks all link the same code.
+// The columnar versions live next to EventColumnStore (EventColumnStore.h) and in Query.h.
+// None of them print: call PrintEvents on the result (or on PermutedView(events, order)) to see it.
+
+#include <iostream>
+#include <ranges>
+#include <string>
+#include <vector>
+
+#include "FlatHashMap.h"
+#include "SimulationEvent.h"
+
+template <std::ranges::input_range Events>
+void PrintEvents(Events&& events)// any range of SimulationEvent, e.g. PermutedView
+{
+    for (const auto& event : events)
+    {
+        std::cout << "Timestamp: " << event.timestampSec
+            << ", Type: " << static_cast<int>(event.type)
+            << ", Source: " << event.source
+            << ", Value: " << event.value << '\n';
+    }
+    std::cout << std::endl << "----------------------------------------" << std::endl;
+}
+
+//1. Sort Events by Timestamp
+std::vector<SimulationEvent> SortByTime(const std::vector<SimulationEvent>& events);
+std::vector<SimulationEvent> SortByTimeAndReturnACopy(const std::vector<SimulationEvent>& events);
+void SortEventsByTime(std::vector<SimulationEvent>& events);// in place
+std::vector<EventIndex> SortEventsByTime(const std::vector<SimulationEvent>& events, bool isAscending = true);// the order only, no copy
+
+//2. Filter Events by Source & Type
+std::vector<SimulationEvent> FilterByType(const std::vector<SimulationEvent>& events, EventType typeToFilter);
+
+//3. Group Events by Type/Source
+FlatHashMap<EventType, std::vector<SimulationEvent>> GroupByType(const std::vector<SimulationEvent>& events, const EventType& type);
+FlatStringMap<std::vector<SimulationEvent>> GroupBySource(const std::vector<SimulationEvent>& events);
+FlatStringMap<std::vector<SimulationEvent>> GroupBySources(const std::vector<SimulationEvent>& events);
+
+//4. Compute Total Value for a Given Source
+double Acumulate(const std::vector<SimulationEvent>& events, const std::string& source);
+double AcumulatebySource(const std::vector<SimulationEvent>& events, const EventType& type);// despite the name: total for one type
+double AcumulateTotalBySource(const std::vector<SimulationEvent>& events, const std::string& source);
+double AccumalateValueBySource(const std::vector<SimulationEvent>& events, const std::string& source);
+double ComputeTotalValueBySource(const std::vector<SimulationEvent>& events, const std::string& source);
+
+//5. Find the First Event After a Time Threshold (nullptr if none)
+const SimulationEvent* FirstEvent(const std::vector<SimulationEvent>& events, double time);
+const SimulationEvent* FirstEventAfter(const std::vector<SimulationEvent>& events, double thresholdTime);
+const SimulationEvent* FirstEventAfterThis(const std::vector<SimulationEvent>& events, double thresholdTime);
@@ -0,0 +1,99 @@
+#pragma once
+// Zero-copy views over event data.
+// FilterByType/SortByTime copy every event (and its std::string) into a new vector. These return
+// lazy std::views instead, or permutation/selection index arrays, so the GUI and later stages can read
+// the original events in filtered or sorted order without ever copying a payload.
+// NOTE: a view only refers to the data it was built from; keep events/store (and any order vector) alive while using it.
+
+#include <algorithm>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "EventColumnStore.h"
+#include "Instrumentation.h"
+#include "RadixSort.h"
+#include "SimulationEvent.h"
+
+// ** vector<SimulationEvent> views **
+
+// Lazy filter: nothing is evaluated or copied until the view is iterated. => the ranges::views::filter the original notes point at
+inline auto FilterByTypeView(const std::vector<SimulationEvent>& events, EventType typeToFilter)
+{
+    return events | std::views::filter([typeToFilter](const SimulationEvent& ev) { return ev.type == typeToFilter; });
+}
+
+inline auto FilterBySourceView(const std::vector<SimulationEvent>& events, std::string_view source)
+{
+    return events | std::views::filter([source](const SimulationEvent& ev) { return ev.source == source; });
+}
+
+// Sorted order as a permutation: order[i] is the position in events of the i-th event by time. Only indices move, never events.
+inline std::vector<EventIndex> SortedOrderByTime(const std::vector<SimulationEvent>& events, bool isAscending = true)
+{
+    ESP_TIME_OPERATION("vector_sort_by_time", events.size());
+    std::vector<double> timestamps(events.size());// one pass pulls the keys out of the events; the sort never touches them again
+    std::ranges::transform(events, timestamps.begin(), &SimulationEvent::timestampSec);
+    return RadixSortedOrder(timestamps, isAscending);
+}
+
+// Reads events through a permutation or selection, yielding const SimulationEvent& (no copies).
+inline auto PermutedView(const std::vector<SimulationEvent>& events, std::span<const EventIndex> order)
+{
+    return order | std::views::transform([&events](EventIndex index) -> const SimulationEvent& { return events[index]; });
+}
+
+// Materializes a permutation or selection: each chosen event is copied exactly once.
+inline std::vector<SimulationEvent> GatherEvents(const std::vector<SimulationEvent>& events, std::span<const EventIndex> order)
+{
+    std::vector<SimulationEvent> gathered{};
+    gathered.reserve(order.size());
+    for (EventIndex index : order)
+    {
+        gathered.push_back(events[index]);
+    }
+    return gathered;
+}
+
+// Reorders events in place by a full permutation: each event is moved exactly once (a comparison sort moves them O(n log n) times).
+inline void ApplyOrder(std::vector<SimulationEvent>& events, std::span<const EventIndex> order)
+{
+    std::vector<SimulationEvent> reordered{};
+    reordered.reserve(events.size());
+    for (EventIndex index : order)
+    {
+        reordered.push_back(std::move(events[index]));
+    }
+    events = std::move(reordered);
+}
+
+// ** EventColumnStore views **
+// A store has no SimulationEvent objects to point at, so rows are read as small value records that carry the SourceId, not the name.
+
+struct EventRow
+{
+    EventIndex row{};
+    double timestampSec{};
+    EventType type{};
+    SourceId sourceId{};
+    double value{};
+};
+
+inline EventRow RowAt(const EventColumnStore& store, EventIndex row)
+{
+    return { row, store.Timestamps()[row], store.Types()[row], store.SourceIds()[row], store.Values()[row] };
+}
+
+// Rows in the order given by a selection vector (SelectByType/SelectBySource) or a permutation (SortedOrderByTime).
+inline auto RowsView(const EventColumnStore& store, std::span<const EventIndex> rows)
+{
+    return rows | std::views::transform([&store](EventIndex row) { return RowAt(store, row); });
+}
+
+inline auto AllRowsView(const EventColumnStore& store)
+{
+    return std::views::iota(EventIndex{ 0 }, static_cast<EventIndex>(store.Size()))
+        | std::views::transform([&store](EventIndex row) { return RowAt(store, row); });
+}
@@ -0,0 +1,493 @@
+#pragma once
+// Flat open-addressing hash map for group-by keys (Swiss-table layout).
+// std::unordered_map allocates a node per key and walks a linked bucket on every lookup. FlatHashMap keeps all entries
+// in one array plus one control byte per slot: the control byte holds 7 bits of the key's hash (or "empty"/"deleted"),
+// and a lookup compares 16 control bytes at once (one SSE2 compare) before it touches a single key. Probing moves
+// group by group, so a miss is usually one cache line of control bytes and a hit one more line for the entry.
+//
+// Keys that are a small dense enum (DenseEnumTraits, e.g. EventType) get a compile-time specialization instead:
+// a plain array indexed by the enum value, no hashing at all.
+//
+// API follows the repo's Find() -> pointer / nullptr convention: Find, Contains, TryEmplace, operator[], Erase,
+// Size, Reserve, Clear, and range-for over Entry { key, value }. String maps (FlatStringMap) take string_view lookups.
+// NOTE: like std::unordered_map, inserting may move entries; don't keep pointers into the map across an insert.
+//       Don't modify entry.key through an iterator.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLAT_HASH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include "SimulationEvent.h"
+
+// Hash for std::string keys that also accepts string_view / const char* lookups without building a std::string.
+struct TransparentStringHash
+{
+    using is_transparent = void;
+    std::size_t operator()(std::string_view text) const { return std::hash<std::string_view>{}(text); }
+};
+
+// Enums whose values are exactly 0 .. count-1. Specialize to opt an enum into the array-backed FlatHashMap.
+template <typename Key>
+struct DenseEnumTraits
+{
+    static constexpr std::size_t count = 0;
+};
+
+template <>
+struct DenseEnumTraits<EventType>
+{
+    static constexpr std::size_t count = EventTypeCount;
+};
+
+template <typename Key>
+concept DenseEnumKey = std::is_enum_v<Key> && (DenseEnumTraits<Key>::count > 0);
+
+// ** Control bytes **
+// 0..127: slot is full, value is the low 7 bits of the hash. Negative: slot is free (empty or deleted).
+using FlatControl = std::int8_t;
+inline constexpr FlatControl FlatEmpty = -128;   // 0x80
+inline constexpr FlatControl FlatDeleted = -2;   // 0xFE, tombstone: probing continues past it
+inline constexpr std::size_t FlatGroupWidth = 16;
+
+struct alignas(FlatGroupWidth) FlatControlGroup
+{
+    FlatControl bytes[FlatGroupWidth];
+};
+
+// Bit i set when control byte i of the group equals value.
+inline std::uint32_t FlatMatch(const FlatControlGroup& group, FlatControl value)
+{
+#if defined(FLAT_HASH_SSE2)
+    const __m128i controls = _mm_load_si128(reinterpret_cast<const __m128i*>(group.bytes));
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(controls, _mm_set1_epi8(value))));
+#else
+    std::uint32_t bits = 0;
+    for (std::size_t at = 0; at < FlatGroupWidth; ++at)
+    {
+        bits |= static_cast<std::uint32_t>(group.bytes[at] == value) << at;
+    }
+    return bits;
+#endif
+}
+
+// Bit i set when slot i of the group is free (empty or deleted): exactly the control bytes with the high bit set.
+inline std::uint32_t FlatMatchFree(const FlatControlGroup& group)
+{
+#if defined(FLAT_HASH_SSE2)
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(group.bytes))));
+#else
+    std::uint32_t bits = 0;
+    for (std::size_t at = 0; at < FlatGroupWidth; ++at)
+    {
+        bits |= static_cast<std::uint32_t>(group.bytes[at] < 0) << at;
+    }
+    return bits;
+#endif
+}
+
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename Equal = std::equal_to<>>
+class FlatHashMap
+{
+public:
+    struct Entry
+    {
+        Key key;
+        Value value;
+    };
+
+    FlatHashMap() = default;
+
+    FlatHashMap(const FlatHashMap& other)
+    {
+        Reserve(other.Size());
+        for (const Entry& entry : other)
+        {
+            TryEmplace(entry.key, entry.value);
+        }
+    }
+
+    FlatHashMap(FlatHashMap&& other) noexcept { Swap(other); }
+
+    FlatHashMap& operator=(FlatHashMap other) noexcept// copy-and-swap covers both copy and move assignment
+    {
+        Swap(other);
+        return *this;
+    }
+
+    ~FlatHashMap() { DestroyAll(); }
+
+    template <typename K>
+    Value* Find(const K& key)
+    {
+        const std::size_t slot = FindSlot(key, HashOf(key));
+        return slot != NoSlot ? &EntryAt(slot).value : nullptr;
+    }
+
+    template <typename K>
+    const Value* Find(const K& key) const { return const_cast<FlatHashMap*>(this)->Find(key); }
+
+    template <typename K>
+    bool Contains(const K& key) const { return Find(key) != nullptr; }
+
+    // Inserts key -> Value(args...) unless key is present. Returns the value and whether it was inserted.
+    // K may be a lookup type (string_view for FlatStringMap); the Key is only constructed when inserting.
+    template <typename K, typename... Args>
+    std::pair<Value*, bool> TryEmplace(K&& key, Args&&... args)
+    {
+        const std::size_t hash = HashOf(key);
+        if (const std::size_t found = FindSlot(key, hash); found != NoSlot)
+        {
+            return { &EntryAt(found).value, false };
+        }
+
+        if ((size + tombstones + 1) * 8 > capacity * 7)// keep at most 7/8 of the slots used, tombstones included
+        {
+            Rehash(size + 1 > capacity / 2 ? std::max(capacity * 2, FlatGroupWidth) : capacity);// mostly tombstones: same size, just cleaned
+        }
+
+        const std::size_t slot = FindFreeSlot(hash);
+        ::new (static_cast<void*>(&storage[slot])) Entry{ Key(std::forward<K>(key)), Value(std::forward<Args>(args)...) };
+        if (ControlAt(slot) == FlatDeleted)
+        {
+            --tombstones;
+        }
+        ControlAt(slot) = H2(hash);
+        ++size;
+        return { &EntryAt(slot).value, true };
+    }
+
+    template <typename K>
+    Value& operator[](K&& key) { return *TryEmplace(std::forward<K>(key)).first; }// inserts Value{} for a new key, like std::unordered_map
+
+    template <typename K>
+    bool Erase(const K& key)
+    {
+        const std::size_t slot = FindSlot(key, HashOf(key));
+        if (slot == NoSlot)
+        {
+            return false;
+        }
+        std::destroy_at(&EntryAt(slot));
+        ControlAt(slot) = FlatDeleted;
+        --size;
+        ++tombstones;
+        return true;
+    }
+
+    std::size_t Size() const { return size; }
+    bool Empty() const { return size == 0; }
+
+    void Reserve(std::size_t count)
+    {
+        if (count * 8 > capacity * 7)
+        {
+            Rehash(std::bit_ceil(std::max(count * 8 / 7 + 1, FlatGroupWidth)));
+        }
+    }
+
+    void Clear()// keeps the capacity, so refilling a cleared map allocates nothing
+    {
+        DestroyAll();
+        for (std::size_t group = 0; group < capacity / FlatGroupWidth; ++group)
+        {
+            std::fill(std::begin(groups[group].bytes), std::end(groups[group].bytes), FlatEmpty);
+        }
+        size = 0;
+        tombstones = 0;
+    }
+
+    template <bool IsConst>
+    class Iterator
+    {
+    public:
+        using Owner = std::conditional_t<IsConst, const FlatHashMap, FlatHashMap>;
+        using Reference = std::conditional_t<IsConst, const Entry&, Entry&>;
+
+        Iterator(Owner* owner, std::size_t slot) : owner{ owner }, slot{ slot } { SkipFree(); }
+
+        Reference operator*() const { return owner->EntryAt(slot); }
+        auto* operator->() const { return &owner->EntryAt(slot); }
+        Iterator& operator++()
+        {
+            ++slot;
+            SkipFree();
+            return *this;
+        }
+        bool operator==(const Iterator& other) const { return slot == other.slot; }
+
+    private:
+        void SkipFree()
+        {
+            while (slot < owner->capacity && owner->ControlAt(slot) < 0)
+            {
+                ++slot;
+            }
+        }
+
+        Owner* owner;
+        std::size_t slot;
+    };
+
+    Iterator<false> begin() { return { this, 0 }; }
+    Iterator<false> end() { return { this, capacity }; }
+    Iterator<true> begin() const { return { this, 0 }; }
+    Iterator<true> end() const { return { this, capacity }; }
+
+private:
+    struct Slot
+    {
+        alignas(Entry) std::byte bytes[sizeof(Entry)];
+    };
+
+    static constexpr std::size_t NoSlot = ~std::size_t{ 0 };
+
+    template <typename K>
+    std::size_t HashOf(const K& key) const
+    {
+        // Mix so both halves of the result depend on every input bit (std::hash of an integer is often the identity).
+        std::uint64_t mixed = static_cast<std::uint64_t>(hasher(key)) * 0x9E3779B97F4A7C15ull;
+        mixed ^= mixed >> 32;
+        return static_cast<std::size_t>(mixed);
+    }
+
+    static FlatControl H2(std::size_t hash) { return static_cast<FlatControl>(hash & 0x7F); }
+
+    FlatControl& ControlAt(std::size_t slot) { return groups[slot / FlatGroupWidth].bytes[slot % FlatGroupWidth]; }
+    FlatControl ControlAt(std::size_t slot) const { return groups[slot / FlatGroupWidth].bytes[slot % FlatGroupWidth]; }
+    Entry& EntryAt(std::size_t slot) { return *std::launder(reinterpret_cast<Entry*>(&storage[slot])); }
+    const Entry& EntryAt(std::size_t slot) const { return *std::launder(reinterpret_cast<const Entry*>(&storage[slot])); }
+
+    // Triangular probing over groups (+1, +2, +3, ...) visits every group once when the group count is a power of two.
+    template <typename K>
+    std::size_t FindSlot(const K& key, std::size_t hash) const
+    {
+        const std::size_t groupCount = capacity / FlatGroupWidth;
+        if (groupCount == 0)
+        {
+            return NoSlot;
+        }
+        std::size_t group = (hash >> 7) & (groupCount - 1);
+        for (std::size_t step = 1; step <= groupCount; ++step)
+        {
+            const FlatControlGroup& controls = groups[group];
+            for (std::uint32_t match = FlatMatch(controls, H2(hash)); match != 0; match &= match - 1)
+            {
+                const std::size_t slot = group * FlatGroupWidth + static_cast<std::size_t>(std::countr_zero(match));
+                if (equal(EntryAt(slot).key, key))
+                {
+                    return slot;
+                }
+            }
+            if (FlatMatch(controls, FlatEmpty) != 0)
+            {
+                return NoSlot;// an empty slot ends the probe: the key would have been placed here
+            }
+            group = (group + step) & (groupCount - 1);
+        }
+        return NoSlot;
+    }
+
+    std::size_t FindFreeSlot(std::size_t hash) const
+    {
+        const std::size_t groupCount = capacity / FlatGroupWidth;
+        std::size_t group = (hash >> 7) & (groupCount - 1);
+        for (std::size_t step = 1;; ++step)
+        {
+            if (const std::uint32_t free = FlatMatchFree(groups[group]); free != 0)
+            {
+                return group * FlatGroupWidth + static_cast<std::size_t>(std::countr_zero(free));
+            }
+            group = (group + step) & (groupCount - 1);
+        }
+    }
+
+    void Rehash(std::size_t newCapacity)
+    {
+        FlatHashMap resized{};
+        resized.capacity = newCapacity;
+        resized.groups = std::make_unique<FlatControlGroup[]>(newCapacity / FlatGroupWidth);
+        resized.storage = std::make_unique_for_overwrite<Slot[]>(newCapacity);
+        for (std::size_t group = 0; group < newCapacity / FlatGroupWidth; ++group)
+        {
+            std::fill(std::begin(resized.groups[group].bytes), std::end(resized.groups[group].bytes), FlatEmpty);
+        }
+
+        for (std::size_t slot = 0; slot < capacity; ++slot)
+        {
+            if (ControlAt(slot) < 0)
+            {
+                continue;
+            }
+            Entry& entry = EntryAt(slot);
+            const std::size_t hash = HashOf(entry.key);
+            const std::size_t target = resized.FindFreeSlot(hash);
+            ::new (static_cast<void*>(&resized.storage[target])) Entry{ std::move(entry) };
+            resized.ControlAt(target) = H2(hash);
+            std::destroy_at(&entry);
+            ControlAt(slot) = FlatEmpty;
+        }
+        resized.size = size;
+        size = 0;
+        tombstones = 0;
+        Swap(resized);
+    }
+
+    void DestroyAll()
+    {
+        if constexpr (!std::is_trivially_destructible_v<Entry>)
+        {
+            for (std::size_t slot = 0; slot < capacity; ++slot)
+            {
+                if (ControlAt(slot) >= 0)
+                {
+                    std::destroy_at(&EntryAt(slot));
+                }
+            }
+        }
+    }
+
+    void Swap(FlatHashMap& other) noexcept
+    {
+        std::swap(groups, other.groups);
+        std::swap(storage, other.storage);
+        std::swap(capacity, other.capacity);
+        std::swap(size, other.size);
+        std::swap(tombstones, other.tombstones);
+    }
+
+    std::unique_ptr<FlatControlGroup[]> groups{};
+    std::unique_ptr<Slot[]> storage{};
+    std::size_t capacity{};     // slots, a power of two and a multiple of FlatGroupWidth (0 before the first insert)
+    std::size_t size{};
+    std::size_t tombstones{};
+    [[no_unique_address]] Hash hasher{};
+    [[no_unique_address]] Equal equal{};
+};
+
+// Dense enum keys: one array slot per enum value, chosen at compile time. Value must be default-constructible.
+template <DenseEnumKey Key, typename Value, typename Hash, typename Equal>
+class FlatHashMap<Key, Value, Hash, Equal>
+{
+public:
+    static constexpr std::size_t KeyCount = DenseEnumTraits<Key>::count;
+
+    struct Entry
+    {
+        Key key;
+        Value value;
+    };
+
+    FlatHashMap()
+    {
+        for (std::size_t slot = 0; slot < KeyCount; ++slot)
+        {
+            entries[slot].key = static_cast<Key>(slot);
+        }
+    }
+
+    Value* Find(Key key) { return present[Slot(key)] ? &entries[Slot(key)].value : nullptr; }
+    const Value* Find(Key key) const { return present[Slot(key)] ? &entries[Slot(key)].value : nullptr; }
+    bool Contains(Key key) const { return present[Slot(key)]; }
+
+    template <typename... Args>
+    std::pair<Value*, bool> TryEmplace(Key key, Args&&... args)
+    {
+        const std::size_t slot = Slot(key);
+        if (present[slot])
+        {
+            return { &entries[slot].value, false };
+        }
+        entries[slot].value = Value(std::forward<Args>(args)...);
+        present[slot] = true;
+        ++size;
+        return { &entries[slot].value, true };
+    }
+
+    Value& operator[](Key key) { return *TryEmplace(key).first; }
+
+    bool Erase(Key key)
+    {
+        const std::size_t slot = Slot(key);
+        if (!present[slot])
+        {
+            return false;
+        }
+        entries[slot].value = Value{};
+        present[slot] = false;
+        --size;
+        return true;
+    }
+
+    std::size_t Size() const { return size; }
+    bool Empty() const { return size == 0; }
+    void Reserve(std::size_t) {}
+
+    void Clear()
+    {
+        for (std::size_t slot = 0; slot < KeyCount; ++slot)
+        {
+            Erase(static_cast<Key>(slot));
+        }
+    }
+
+    template <bool IsConst>
+    class Iterator
+    {
+    public:
+        using Owner = std::conditional_t<IsConst, const FlatHashMap, FlatHashMap>;
+        using Reference = std::conditional_t<IsConst, const Entry&, Entry&>;
+
+        Iterator(Owner* owner, std::size_t slot) : owner{ owner }, slot{ slot } { SkipAbsent(); }
+
+        Reference operator*() const { return owner->entries[slot]; }
+        auto* operator->() const { return &owner->entries[slot]; }
+        Iterator& operator++()
+        {
+            ++slot;
+            SkipAbsent();
+            return *this;
+        }
+        bool operator==(const Iterator& other) const { return slot == other.slot; }
+
+    private:
+        void SkipAbsent()
+        {
+            while (slot < KeyCount && !owner->present[slot])
+            {
+                ++slot;
+            }
+        }
+
+        Owner* owner;
+        std::size_t slot;
+    };
+
+    Iterator<false> begin() { return { this, 0 }; }
+    Iterator<false> end() { return { this, KeyCount }; }
+    Iterator<true> begin() const { return { this, 0 }; }
+    Iterator<true> end() const { return { this, KeyCount }; }
+
+private:
+    static std::size_t Slot(Key key) { return static_cast<std::size_t>(key); }
+
+    std::array<Entry, KeyCount> entries{};
+    std::array<bool, KeyCount> present{};
+    std::size_t size{};
+};
+
+template <typename Value>
+using FlatStringMap = FlatHashMap<std::string, Value, TransparentStringHash>;
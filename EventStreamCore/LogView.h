@@ -0,0 +1,163 @@
+#pragma once
+// Virtualized event log for the GUI: a list of lines that are only turned into text when somebody asks for them.
+// A query result is added as the row indices it already is (a sort order, a selection, a group's span) over the store,
+// plus a few plain text lines for headers and summaries. Line(i) formats row i on demand into a small direct-mapped
+// cache, so drawing a screen costs the ~25 visible lines whatever the log size, and scrolling re-formats only the
+// lines that just came into view. Building a view is one copy of the row indices, never a string per event.
+//
+//   LogView log{};
+//   log.AddRows(store, SortedOrderByTime(store));    // 1M rows, nothing formatted yet
+//   log.ScrollBy(-3, visibleLines);                  // mouse wheel
+//   for (std::size_t line = log.Top(); line < log.Top() + visibleLines && line < log.Size(); ++line) Draw(log.Line(line));
+//
+// NOTE: the view keeps a pointer to every store added to it; the store must outlive it (or the next Clear()).
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "EventColumnStore.h"
+#include "SimulationEvent.h"
+
+// "T: 1.500000 | SENSOR_READING | engine1 | 100.000000", the GUI's line for one event.
+inline std::string FormatEventLine(const EventColumnStore& store, EventIndex row, std::string_view indent = {})
+{
+    std::string line{ indent };
+    line += "T: ";
+    line += std::to_string(store.Timestamps()[row]);
+    line += " | ";
+    line += EventTypeNames[static_cast<std::size_t>(store.Types()[row])];
+    line += " | ";
+    line += store.SourceName(store.SourceIds()[row]);
+    line += " | ";
+    line += std::to_string(store.Values()[row]);
+    return line;
+}
+
+class LogView
+{
+public:
+    static constexpr std::size_t CacheLines = 256;     // a few screens: scrolling back and forth stays in the cache
+
+    void Clear()
+    {
+        segments.clear();
+        lineCount = 0;
+        top = 0;
+        cache.fill({});
+    }
+
+    void AddLine(std::string line)
+    {
+        if (segments.empty() || segments.back().store)
+        {
+            segments.push_back({ lineCount });
+        }
+        segments.back().text.push_back(std::move(line));
+        ++lineCount;
+    }
+
+    // One line per row, in the given order, e.g. a sort order or a selection.
+    void AddRows(const EventColumnStore& store, std::vector<EventIndex> rows, std::string_view indent = {})
+    {
+        if (rows.empty())
+        {
+            return;
+        }
+        const std::size_t count = rows.size();
+        segments.push_back({ lineCount, {}, &store, std::move(rows), std::string{ indent } });
+        lineCount += count;
+    }
+
+    void AddRows(const EventColumnStore& store, std::span<const EventIndex> rows, std::string_view indent = {})
+    {
+        AddRows(store, std::vector<EventIndex>(rows.begin(), rows.end()), indent);
+    }
+
+    // Every row of the store in row order, without even an index list.
+    void AddAllRows(const EventColumnStore& store, std::string_view indent = {})
+    {
+        if (store.Size() == 0)
+        {
+            return;
+        }
+        segments.push_back({ lineCount, {}, &store, {}, std::string{ indent } });
+        lineCount += store.Size();
+    }
+
+    std::size_t Size() const { return lineCount; }
+
+    // The text of one line (index < Size()); valid until the next call that formats a line or changes the view.
+    const std::string& Line(std::size_t index)
+    {
+        const Segment& segment = SegmentOf(index);
+        const std::size_t offset = index - segment.firstLine;
+        if (!segment.store)
+        {
+            return segment.text[offset];
+        }
+        CachedLine& cached = cache[index % CacheLines];
+        if (cached.line != index)
+        {
+            const EventIndex row = segment.rows.empty() ? static_cast<EventIndex>(offset) : segment.rows[offset];
+            cached.text = FormatEventLine(*segment.store, row, segment.indent);
+            cached.line = index;
+            ++formatted;
+        }
+        return cached.text;
+    }
+
+    // ** Scrolling **
+    // Top() is the first visible line; the scroll functions keep a full page in view whenever there is one.
+
+    std::size_t Top() const { return top; }
+
+    void ScrollTo(std::size_t line, std::size_t visibleLines)
+    {
+        const std::size_t lastTop = lineCount > visibleLines ? lineCount - visibleLines : 0;
+        top = std::min(line, lastTop);
+    }
+
+    void ScrollBy(std::ptrdiff_t lines, std::size_t visibleLines)
+    {
+        const auto moved = static_cast<std::ptrdiff_t>(top) + lines;
+        ScrollTo(moved < 0 ? 0 : static_cast<std::size_t>(moved), visibleLines);
+    }
+
+    std::size_t FormattedLines() const { return formatted; }   // rows turned into text so far, cache misses included
+
+private:
+    struct Segment
+    {
+        std::size_t firstLine{};
+        std::vector<std::string> text{};            // plain lines when store is null
+        const EventColumnStore* store{};
+        std::vector<EventIndex> rows{};             // empty: every row of the store, in order
+        std::string indent{};
+    };
+
+    struct CachedLine
+    {
+        std::size_t line{ std::numeric_limits<std::size_t>::max() };
+        std::string text{};
+    };
+
+    const Segment& SegmentOf(std::size_t index) const
+    {
+        auto after = std::ranges::upper_bound(segments, index, {}, &Segment::firstLine);
+        return *std::prev(after);
+    }
+
+    std::vector<Segment> segments{};
+    std::size_t lineCount{};
+    std::size_t top{};
+    std::size_t formatted{};
+    std::array<CachedLine, CacheLines> cache{};
+};
@@ -0,0 +1,100 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+    fileHandle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+        fileHandle = nullptr;
+        throw std::runtime_error("MappedFile: cannot open " + path.string());
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(fileHandle, &fileSize))
+    {
+        CloseHandle(fileHandle);
+        throw std::runtime_error("MappedFile: cannot read size of " + path.string());
+    }
+    size = static_cast<std::size_t>(fileSize.QuadPart);
+    if (size == 0)
+    {
+        return;// nothing to map; Bytes() is an empty span
+    }
+
+    mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle == nullptr)
+    {
+        CloseHandle(fileHandle);
+        throw std::runtime_error("MappedFile: cannot map " + path.string());
+    }
+
+    data = static_cast<const std::byte*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (data == nullptr)
+    {
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        throw std::runtime_error("MappedFile: cannot map a view of " + path.string());
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (data) UnmapViewOfFile(data);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle) CloseHandle(fileHandle);
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+    fileDescriptor = open(path.c_str(), O_RDONLY);
+    if (fileDescriptor < 0)
+    {
+        throw std::runtime_error("MappedFile: cannot open " + path.string());
+    }
+
+    struct stat info{};
+    if (fstat(fileDescriptor, &info) != 0)
+    {
+        close(fileDescriptor);
+        throw std::runtime_error("MappedFile: cannot read size of " + path.string());
+    }
+    size = static_cast<std::size_t>(info.st_size);
+    if (size == 0)
+    {
+        return;
+    }
+
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if (mapped == MAP_FAILED)
+    {
+        close(fileDescriptor);
+        throw std::runtime_error("MappedFile: cannot map " + path.string());
+    }
+    data = static_cast<const std::byte*>(mapped);
+}
+
+MappedFile::~MappedFile()
+{
+    if (data) munmap(const_cast<std::byte*>(data), size);
+    if (fileDescriptor >= 0) close(fileDescriptor);
+}
+
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+// Read-only memory-mapped file (MapViewOfFile on Windows, mmap elsewhere).
+// Mapping costs nothing up front: the OS pages the file in as it is touched, so a query that reads
+// one column of a 10 GB log only faults in that column.
+// The OS headers stay in MappedFile.cpp; <windows.h> clashes with raylib.h (CloseWindow, DrawText, Rectangle...).
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::filesystem::path& path);// throws std::runtime_error if the file cannot be opened or mapped
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::span<const std::byte> Bytes() const { return { data, size }; }
+    std::size_t Size() const { return size; }
+
+private:
+    const std::byte* data{};
+    std::size_t size{};
+
+#ifdef _WIN32
+    void* fileHandle{};
+    void* mappingHandle{};
+#else
+    int fileDescriptor{ -1 };
+#endif
+};
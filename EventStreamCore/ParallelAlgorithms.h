@@ -0,0 +1,294 @@
+#pragma once
+// Parallel sort-by-timestamp and group-by on the shared work-stealing pool (ThreadPool.h).
+// Sort: each chunk sorts its (timestamp, row) keys, then sorted runs are merged pairwise in parallel rounds.
+// Group-by: each chunk fills its own partial groups with no locking, and the partials are merged at the end
+// in chunk order, so every group lists its rows in the same order as the serial functions.
+// ParallelPartitionBySourceId instead counts per chunk and scatters every chunk into its own stretch of one buffer.
+// Small inputs fall back to the serial versions; thread start-up costs more than it saves below ParallelCutoffRows.
+// Speedups against the serial functions are measured in the benchmark suite.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <execution>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "EventAggregator.h"
+#include "EventColumnStore.h"
+#include "EventViews.h"
+#include "FlatHashMap.h"
+#include "Instrumentation.h"
+#include "RadixSort.h"
+#include "RowPartitions.h"
+#include "SimulationEvent.h"
+#include "ThreadPool.h"
+
+inline constexpr std::size_t ParallelCutoffRows = 1 << 15;
+inline constexpr std::size_t ParallelChunkRows = 1 << 14;
+
+//1. Sort: a permutation, like SortedOrderByTime, but computed on every core.
+inline std::vector<EventIndex> ParallelSortedOrderByTime(const EventColumnStore& store, bool isAscending = true, ThreadPool& pool = SharedThreadPool())
+{
+    ESP_TIME_OPERATION("parallel_sort_by_time", store.Size());
+    const std::size_t count = store.Size();
+    if (count < ParallelCutoffRows || pool.ThreadCount() == 1)
+    {
+        return SortedOrderByTime(store, isAscending);
+    }
+
+    // Sorting 16-byte (key, row) pairs keeps every comparison on contiguous memory instead of gathering timestamps[row].
+    // The key is RadixSort.h's TimeSortKey, so descending is the same comparison. Ties are broken by row, which makes
+    // the order total, so an unstable sort + merge gives the stable order.
+    struct TimeKey
+    {
+        std::uint64_t key;
+        EventIndex row;
+    };
+    auto before = [](const TimeKey& a, const TimeKey& b) { return a.key != b.key ? a.key < b.key : a.row < b.row; };
+
+    std::vector<TimeKey> keys(count);
+    std::vector<TimeKey> scratch(count);
+    auto timestamps = store.Timestamps();
+
+    // One run per worker keeps the merge tree shallow (log2(threads) rounds).
+    const std::size_t runs = std::min(pool.ThreadCount(), (count + ParallelChunkRows - 1) / ParallelChunkRows);
+    std::vector<std::size_t> bounds(runs + 1);
+    for (std::size_t run = 0; run <= runs; ++run)
+    {
+        bounds[run] = count * run / runs;
+    }
+
+    {
+        TaskGroup group{ pool };
+        for (std::size_t run = 0; run < runs; ++run)
+        {
+            group.Run([&, run]
+                {
+                    for (std::size_t row = bounds[run]; row < bounds[run + 1]; ++row)
+                    {
+                        keys[row] = { TimeSortKey(timestamps[row], isAscending), static_cast<EventIndex>(row) };
+                    }
+                    std::sort(keys.begin() + bounds[run], keys.begin() + bounds[run + 1], before);
+                });
+        }
+        group.Wait();
+    }
+
+    for (std::size_t width = 1; width < runs; width *= 2)
+    {
+        TaskGroup group{ pool };
+        for (std::size_t left = 0; left < runs; left += 2 * width)
+        {
+            const std::size_t begin = bounds[left];
+            const std::size_t middle = bounds[std::min(left + width, runs)];
+            const std::size_t end = bounds[std::min(left + 2 * width, runs)];
+            group.Run([&, begin, middle, end]
+                {
+                    std::merge(keys.begin() + begin, keys.begin() + middle, keys.begin() + middle, keys.begin() + end, scratch.begin() + begin, before);
+                });
+        }
+        group.Wait();
+        keys.swap(scratch);
+    }
+
+    std::vector<EventIndex> order(count);
+    ParallelForChunks(pool, count, ParallelChunkRows, [&](std::size_t begin, std::size_t end, std::size_t)
+        {
+            for (std::size_t at = begin; at < end; ++at)
+            {
+                order[at] = keys[at].row;
+            }
+        });
+    return order;
+}
+
+inline EventColumnStore ParallelSortByTime(const EventColumnStore& store, bool isAscending = true, ThreadPool& pool = SharedThreadPool())
+{
+    return store.Gather(ParallelSortedOrderByTime(store, isAscending, pool));
+}
+
+// vector<SimulationEvent> version through the standard parallel algorithms (std::execution::par).
+// NOTE: this still copies and moves whole events, strings included; prefer the store or the permutation where possible.
+inline std::vector<SimulationEvent> ParallelSortByTime(const std::vector<SimulationEvent>& events)
+{
+    std::vector<SimulationEvent> sorted{ events };
+    std::stable_sort(std::execution::par, sorted.begin(), sorted.end(),
+        [](const SimulationEvent& a, const SimulationEvent& b) { return a.timestampSec < b.timestampSec; });
+    return sorted;
+}
+
+//2. Group-by: per-chunk partials, merged in chunk order.
+inline std::vector<std::vector<EventIndex>> ParallelGroupBySourceId(const EventColumnStore& store, ThreadPool& pool = SharedThreadPool())
+{
+    ESP_TIME_OPERATION("parallel_group_by_source", store.Size());
+    const std::size_t count = store.Size();
+    if (count < ParallelCutoffRows || pool.ThreadCount() == 1)
+    {
+        return GroupBySourceId(store);
+    }
+
+    const std::size_t sourceCount = store.SourceCount();
+    auto sourceIds = store.SourceIds();
+    std::vector<std::vector<std::vector<EventIndex>>> partials(ChunkCount(pool, count, ParallelChunkRows));
+    ParallelForChunks(pool, count, ParallelChunkRows, [&](std::size_t begin, std::size_t end, std::size_t chunk)
+        {
+            auto& partial = partials[chunk];
+            partial.resize(sourceCount);
+            for (std::size_t row = begin; row < end; ++row)
+            {
+                partial[sourceIds[row]].push_back(static_cast<EventIndex>(row));
+            }
+        });
+
+    // Merge is parallel too, split by source id: each source's rows are concatenated chunk by chunk.
+    std::vector<std::vector<EventIndex>> grouped(sourceCount);
+    ParallelForChunks(pool, sourceCount, 1, [&](std::size_t firstId, std::size_t lastId, std::size_t)
+        {
+            for (std::size_t id = firstId; id < lastId; ++id)
+            {
+                std::size_t total = 0;
+                for (const auto& partial : partials)
+                {
+                    total += partial[id].size();
+                }
+                grouped[id].reserve(total);
+                for (const auto& partial : partials)
+                {
+                    grouped[id].insert(grouped[id].end(), partial[id].begin(), partial[id].end());
+                }
+            }
+        });
+    return grouped;
+}
+
+// Contiguous partitions (RowPartitions.h), parallel over row chunks: each chunk counts its own keys, the prefix sum
+// gives every (key, chunk) pair its own stretch of the output, and the chunks scatter into it with no locking.
+// Chunks are laid out in row order inside each group, so the result is identical to PartitionBySourceId.
+inline RowPartitions ParallelPartitionBySourceId(const EventColumnStore& store, ThreadPool& pool = SharedThreadPool())
+{
+    ESP_TIME_OPERATION("parallel_partition_by_source", store.Size());
+    const std::size_t count = store.Size();
+    if (count < ParallelCutoffRows || pool.ThreadCount() == 1)
+    {
+        return PartitionBySourceId(store);
+    }
+
+    const std::size_t sourceCount = store.SourceCount();
+    auto sourceIds = store.SourceIds();
+    const std::size_t chunks = ChunkCount(pool, count, ParallelChunkRows);
+    std::vector<std::size_t> cursors(chunks * sourceCount);// [chunk * sourceCount + id]: count, then that chunk's write position
+    ParallelForChunks(pool, count, ParallelChunkRows, [&](std::size_t begin, std::size_t end, std::size_t chunk)
+        {
+            std::size_t* counts = cursors.data() + chunk * sourceCount;
+            for (std::size_t row = begin; row < end; ++row)
+            {
+                ++counts[sourceIds[row]];
+            }
+        });
+
+    RowPartitions partitions{};
+    partitions.offsets.resize(sourceCount + 1);
+    std::size_t start = 0;
+    for (std::size_t id = 0; id < sourceCount; ++id)
+    {
+        partitions.offsets[id] = start;
+        for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+        {
+            const std::size_t chunkCount = cursors[chunk * sourceCount + id];
+            cursors[chunk * sourceCount + id] = start;
+            start += chunkCount;
+        }
+    }
+    partitions.offsets[sourceCount] = start;
+
+    partitions.rows.resize(count);
+    ParallelForChunks(pool, count, ParallelChunkRows, [&](std::size_t begin, std::size_t end, std::size_t chunk)
+        {
+            std::size_t* next = cursors.data() + chunk * sourceCount;
+            for (std::size_t row = begin; row < end; ++row)
+            {
+                partitions.rows[next[sourceIds[row]]++] = static_cast<EventIndex>(row);
+            }
+        });
+    return partitions;
+}
+
+inline std::array<std::vector<EventIndex>, EventTypeCount> ParallelGroupByType(const EventColumnStore& store, ThreadPool& pool = SharedThreadPool())
+{
+    ESP_TIME_OPERATION("parallel_group_by_type", store.Size());
+    const std::size_t count = store.Size();
+    auto types = store.Types();
+
+    std::vector<std::array<std::vector<EventIndex>, EventTypeCount>> partials(ChunkCount(pool, count, ParallelChunkRows));
+    ParallelForChunks(pool, count, ParallelChunkRows, [&](std::size_t begin, std::size_t end, std::size_t chunk)
+        {
+            for (std::size_t row = begin; row < end; ++row)
+            {
+                partials[chunk][TypeSlot(types[row])].push_back(static_cast<EventIndex>(row));
+            }
+        });
+
+    std::array<std::vector<EventIndex>, EventTypeCount> grouped{};
+    for (std::size_t slot = 0; slot < EventTypeCount; ++slot)
+    {
+        for (const auto& partial : partials)
+        {
+            grouped[slot].insert(grouped[slot].end(), partial[slot].begin(), partial[slot].end());
+        }
+    }
+    return grouped;
+}
+
+// vector<SimulationEvent> version: one partial map per chunk, merged at the end.
+inline FlatStringMap<std::vector<SimulationEvent>> ParallelGroupBySource(const std::vector<SimulationEvent>& events, ThreadPool& pool = SharedThreadPool())
+{
+    ESP_TIME_OPERATION("vector_parallel_group_by_source", events.size());
+    using Groups = FlatStringMap<std::vector<SimulationEvent>>;
+
+    std::vector<Groups> partials(ChunkCount(pool, events.size(), ParallelChunkRows));
+    ParallelForChunks(pool, events.size(), ParallelChunkRows, [&](std::size_t begin, std::size_t end, std::size_t chunk)
+        {
+            for (std::size_t index = begin; index < end; ++index)
+            {
+                partials[chunk][events[index].source].push_back(events[index]);
+            }
+        });
+
+    Groups grouped{};
+    for (Groups& partial : partials)
+    {
+        for (auto& [source, group] : partial)
+        {
+            auto& target = grouped[source];
+            if (target.empty())
+            {
+                target = std::move(group);// first chunk to see this source hands over its whole vector
+            }
+            else
+            {
+                target.insert(target.end(), std::make_move_iterator(group.begin()), std::make_move_iterator(group.end()));
+            }
+        }
+    }
+    return grouped;
+}
+
+//3. Aggregates: per-chunk AggregateReports combined with AggregateReport::Merge.
+inline AggregateReport ParallelAggregateEvents(const EventColumnStore& store, ThreadPool& pool = SharedThreadPool())
+{
+    ESP_TIME_OPERATION("parallel_aggregate_events", store.Size());
+    std::vector<AggregateReport> partials(ChunkCount(pool, store.Size(), ParallelChunkRows));
+    ParallelForChunks(pool, store.Size(), ParallelChunkRows, [&](std::size_t begin, std::size_t end, std::size_t chunk)
+        {
+            partials[chunk] = AggregateEvents(store, begin, end);
+        });
+
+    AggregateReport report = AggregateEvents(store, 0, 0);// sized for every source even if the store is empty
+    for (const AggregateReport& partial : partials)
+    {
+        report.Merge(partial);
+    }
+    return report;
+}
@@ -0,0 +1,364 @@
+#pragma once
+// Push-based streaming pipeline.
+// A source (PushStore, PushOrdered, PushTextLog) cuts the stream into batches of PipelineBatchRows events and pushes
+// each batch through a chain of operators, e.g. parse -> FilterByTypeOperator -> GroupBySourceOperator -> WindowOperator.
+// A batch is a selection of rows over columns that already exist (a store slice or a parser batch), so no stage builds
+// a new event vector: a filter only narrows the row list (reusing one scratch vector), a group-by splits it per source.
+// Memory stays at one batch per stage however long the stream is.
+// Every operator times each Push (Instrumentation.h); a stage that forwards includes the stages after it.
+//
+//   Pipeline pipeline{};
+//   pipeline.Then<FilterByTypeOperator>(EventType::SENSOR_READING);
+//   auto& total = pipeline.Then<AccumulateOperator>();
+//   PushStore(store, pipeline);                 // total.Stats().sum == AcumulatebySource(store, SENSOR_READING)
+
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "EventAggregator.h"
+#include "EventColumnStore.h"
+#include "Instrumentation.h"
+#include "RowPartitions.h"
+#include "SimdKernels.h"
+#include "SimulationEvent.h"
+#include "SourceDictionary.h"
+#include "TextLogParser.h"
+#include "WindowAggregator.h"
+
+inline constexpr std::size_t PipelineBatchRows = 4096;
+
+struct EventBatch
+{
+    const EventColumnStore& columns;        // where the rows live; valid only during Push()
+    std::span<const EventIndex> rows;       // this batch's rows of `columns`, in stream order
+    bool contiguous{};                      // rows are exactly rows.front() .. rows.back() in order: the SIMD kernels can scan the slice
+};
+
+class BatchOperator
+{
+public:
+    virtual ~BatchOperator() = default;
+    virtual void Push(const EventBatch& batch) = 0;
+    virtual void Finish() {}// end of stream: emit anything held back, then pass it on
+};
+
+// An operator with one downstream stage; Pipeline::Then links them.
+class BatchStage : public BatchOperator
+{
+public:
+    void Finish() override
+    {
+        if (next) next->Finish();
+    }
+
+    void SetNext(BatchOperator* downstream) { next = downstream; }
+
+protected:
+    void Forward(const EventBatch& batch)
+    {
+        if (next && !batch.rows.empty()) next->Push(batch);
+    }
+
+    BatchOperator* next{};
+};
+
+// Owns a chain of operators. Then() appends one and returns it, so results can be read from a terminal afterwards.
+class Pipeline : public BatchOperator
+{
+public:
+    template <std::derived_from<BatchOperator> Operator, typename... Args>
+    Operator& Then(Args&&... args)
+    {
+        if (!stages.empty() && !tail)
+        {
+            throw std::logic_error("Pipeline: cannot add a stage after a terminal operator");
+        }
+
+        auto stage = std::make_unique<Operator>(std::forward<Args>(args)...);
+        Operator& added = *stage;
+        if (tail)
+        {
+            tail->SetNext(&added);
+        }
+        if constexpr (std::derived_from<Operator, BatchStage>)
+        {
+            tail = &added;
+        }
+        else
+        {
+            tail = nullptr;
+        }
+        stages.push_back(std::move(stage));
+        return added;
+    }
+
+    void Push(const EventBatch& batch) override
+    {
+        if (!stages.empty()) stages.front()->Push(batch);
+    }
+
+    void Finish() override
+    {
+        if (!stages.empty()) stages.front()->Finish();// each stage passes Finish on to the next
+    }
+
+private:
+    std::vector<std::unique_ptr<BatchOperator>> stages{};
+    BatchStage* tail{};
+};
+
+// ** Operators **
+
+//1. Filters: FilterByType/FilterBySource as stages. An unfiltered batch goes through the SIMD mask kernels.
+class FilterByTypeOperator : public BatchStage
+{
+public:
+    explicit FilterByTypeOperator(EventType typeToFilter) : typeToFilter{ typeToFilter } {}
+
+    void Push(const EventBatch& batch) override
+    {
+        ESP_TIME_OPERATION("pipeline_filter_by_type", batch.rows.size());
+        if (batch.rows.empty())
+        {
+            return;
+        }
+        selected.clear();
+        auto types = batch.columns.Types();
+        if (batch.contiguous)
+        {
+            mask.resize(MaskWordCount(batch.rows.size()));
+            MatchTypeMask(types.subspan(batch.rows.front(), batch.rows.size()), typeToFilter, mask);
+            AppendSelection(mask, batch.rows.front(), selected);
+        }
+        else
+        {
+            for (EventIndex row : batch.rows)
+            {
+                if (types[row] == typeToFilter) selected.push_back(row);
+            }
+        }
+        Forward({ batch.columns, selected });
+    }
+
+private:
+    EventType typeToFilter{};
+    std::vector<std::uint64_t> mask{};
+    std::vector<EventIndex> selected{};     // reused for every batch
+};
+
+class FilterBySourceOperator : public BatchStage
+{
+public:
+    explicit FilterBySourceOperator(SourceId source) : source{ source } {}
+
+    void Push(const EventBatch& batch) override
+    {
+        ESP_TIME_OPERATION("pipeline_filter_by_source", batch.rows.size());
+        if (batch.rows.empty())
+        {
+            return;
+        }
+        selected.clear();
+        auto sourceIds = batch.columns.SourceIds();
+        if (batch.contiguous)
+        {
+            mask.resize(MaskWordCount(batch.rows.size()));
+            MatchSourceMask(sourceIds.subspan(batch.rows.front(), batch.rows.size()), source, mask);
+            AppendSelection(mask, batch.rows.front(), selected);
+        }
+        else
+        {
+            for (EventIndex row : batch.rows)
+            {
+                if (sourceIds[row] == source) selected.push_back(row);
+            }
+        }
+        Forward({ batch.columns, selected });
+    }
+
+private:
+    SourceId source{};
+    std::vector<std::uint64_t> mask{};
+    std::vector<EventIndex> selected{};
+};
+
+//2. Group by source: splits every batch per source and pushes each part into that source's own downstream operator,
+// created by the factory the first time the source shows up. e.g. one WindowOperator or AccumulateOperator per source.
+class GroupBySourceOperator : public BatchOperator
+{
+public:
+    using GroupFactory = std::function<std::unique_ptr<BatchOperator>(SourceId source)>;
+
+    explicit GroupBySourceOperator(GroupFactory makeGroup) : makeGroup{ std::move(makeGroup) } {}
+
+    void Push(const EventBatch& batch) override
+    {
+        ESP_TIME_OPERATION("pipeline_group_by_source", batch.rows.size());
+        // Count-then-scatter into one reused buffer: every source's part of the batch is a span of it.
+        PartitionRows(batch.columns.SourceIds(), batch.rows, batch.columns.SourceCount(), partitions);
+        for (SourceId id = 0; id < partitions.GroupCount(); ++id)
+        {
+            auto rows = partitions.Group(id);
+            if (rows.empty())
+            {
+                continue;
+            }
+            if (id >= groups.size())
+            {
+                groups.resize(id + 1);
+            }
+            if (!groups[id])
+            {
+                groups[id] = makeGroup(id);
+            }
+            groups[id]->Push({ batch.columns, rows });
+        }
+    }
+
+    void Finish() override
+    {
+        for (auto& group : groups)
+        {
+            if (group) group->Finish();
+        }
+    }
+
+    std::size_t GroupCount() const { return groups.size(); }
+
+    // The downstream operator of one source, or nullptr if it never had an event. Operator must be what the factory made.
+    template <std::derived_from<BatchOperator> Operator>
+    Operator* Group(SourceId id) const
+    {
+        return id < groups.size() ? static_cast<Operator*>(groups[id].get()) : nullptr;
+    }
+
+private:
+    GroupFactory makeGroup;
+    std::vector<std::unique_ptr<BatchOperator>> groups{};      // indexed by SourceId
+    RowPartitions partitions{};                                // this batch split per source, rebuilt for every batch
+};
+
+//3. Accumulate: AggregateStats over the values that reach it (the AcumulatebySource / ComputeTotalValueBySource totals).
+class AccumulateOperator : public BatchOperator
+{
+public:
+    void Push(const EventBatch& batch) override
+    {
+        ESP_TIME_OPERATION("pipeline_accumulate", batch.rows.size());
+        auto values = batch.columns.Values();
+        for (EventIndex row : batch.rows)
+        {
+            stats.Add(values[row]);
+        }
+    }
+
+    const AggregateStats& Stats() const { return stats; }
+
+private:
+    AggregateStats stats{};
+};
+
+//4. Window aggregate: feeds WindowAggregator, which emits every window to its sink as the window closes.
+// Batches must arrive in time order (PushOrdered with SortedOrderByTime, or an already sorted stream).
+class WindowOperator : public BatchOperator
+{
+public:
+    WindowOperator(WindowOptions options, WindowSink sink) : aggregator{ options, std::move(sink) } {}
+
+    void Push(const EventBatch& batch) override
+    {
+        ESP_TIME_OPERATION("pipeline_window", batch.rows.size());
+        auto timestamps = batch.columns.Timestamps();
+        auto types = batch.columns.Types();
+        auto sourceIds = batch.columns.SourceIds();
+        auto values = batch.columns.Values();
+        for (EventIndex row : batch.rows)
+        {
+            aggregator.Add(timestamps[row], types[row], sourceIds[row], values[row]);
+        }
+    }
+
+    void Finish() override { aggregator.Finish(); }
+
+    const WindowAggregator& Aggregator() const { return aggregator; }
+
+private:
+    WindowAggregator aggregator;
+};
+
+//5. Collect: materializes whatever reaches it into a store, e.g. the end of a parse -> filter pipeline.
+class CollectOperator : public BatchOperator
+{
+public:
+    explicit CollectOperator(std::shared_ptr<SourceDictionary> dictionary = std::make_shared<SourceDictionary>()) : collected{ std::move(dictionary) } {}
+
+    void Push(const EventBatch& batch) override
+    {
+        ESP_TIME_OPERATION("pipeline_collect", batch.rows.size());
+        const bool sameSources = batch.columns.SharedSources() == collected.SharedSources();
+        auto timestamps = batch.columns.Timestamps();
+        auto types = batch.columns.Types();
+        auto sourceIds = batch.columns.SourceIds();
+        auto values = batch.columns.Values();
+        for (EventIndex row : batch.rows)
+        {
+            const SourceId id = sameSources ? sourceIds[row] : collected.InternSource(batch.columns.SourceName(sourceIds[row]));
+            collected.Append(timestamps[row], types[row], id, values[row]);
+        }
+    }
+
+    const EventColumnStore& Collected() const { return collected; }
+    EventColumnStore TakeCollected() { return std::exchange(collected, EventColumnStore{ collected.SharedSources() }); }
+
+private:
+    EventColumnStore collected;
+};
+
+// ** Sources **
+
+// Pushes the store in row order, batchRows at a time, then finishes the pipeline.
+inline void PushStore(const EventColumnStore& store, BatchOperator& pipeline, std::size_t batchRows = PipelineBatchRows)
+{
+    std::vector<EventIndex> rows(std::min(batchRows, store.Size()));
+    for (std::size_t begin = 0; begin < store.Size(); begin += batchRows)
+    {
+        const std::size_t count = std::min(batchRows, store.Size() - begin);
+        std::iota(rows.begin(), rows.begin() + count, static_cast<EventIndex>(begin));
+        pipeline.Push({ store, { rows.data(), count }, true });
+    }
+    pipeline.Finish();
+}
+
+// Pushes the store in the order of a permutation or selection, e.g. SortedOrderByTime(store) for time windows.
+inline void PushOrdered(const EventColumnStore& store, std::span<const EventIndex> order, BatchOperator& pipeline, std::size_t batchRows = PipelineBatchRows)
+{
+    for (std::size_t begin = 0; begin < order.size(); begin += batchRows)
+    {
+        pipeline.Push({ store, order.subspan(begin, std::min(batchRows, order.size() - begin)) });
+    }
+    pipeline.Finish();
+}
+
+// Parses a text log straight into the pipeline: each parser batch is pushed as it fills, nothing is stored in between.
+inline TextLogReport PushTextLog(const std::filesystem::path& path, BatchOperator& pipeline, std::shared_ptr<SourceDictionary> dictionary, TextLogOptions options = {})
+{
+    options.batchEvents = std::min(options.batchEvents, PipelineBatchRows);
+    std::vector<EventIndex> rows(options.batchEvents);
+    std::iota(rows.begin(), rows.end(), EventIndex{ 0 });
+
+    auto report = ParseTextLogFile(path, std::move(dictionary), [&](const EventColumnStore& batch)
+        {
+            pipeline.Push({ batch, { rows.data(), batch.Size() }, true });
+        }, options);
+    pipeline.Finish();
+    return report;
+}
@@ -0,0 +1,490 @@
+#pragma once
+// Compile-time query shapes: the predicate and the aggregate are template parameters, so each query is one loop the
+// compiler specializes for its keys, instead of a generic loop that re-reads a runtime key on every row.
+//
+//   double sensors = Aggregate<Sum, Where<Type<EventType::SENSOR_READING>>>::Run(store);
+//   double engine  = Aggregate<Mean, Where<Type<EventType::SENSOR_READING>, SourceNamed<"engine1">>>::Run(store);
+//   auto rows      = Select<Where<Not<Type<EventType::CONTROL_INPUT>>>>::Run(store);
+//
+// Keys known only at run time use the runtime predicates (TypeIs, SourceIs, SourceNameIs, TimeBetween) in the same
+// shapes, e.g. Aggregate<Sum, Where<TypeIs>>::Run(store, { TypeIs{ type } }); RunQuery(store, QuerySpec) picks the
+// matching instantiation for a fully ad-hoc query. A Sum or Select on a single type or source key goes through the
+// SIMD kernels (SimdKernels.h); every other shape is one fused scalar loop over only the columns it touches.
+// Every query also runs over any range of SimulationEvent, except Source<Id>, which has no meaning without a store.
+//
+// A predicate is any type with Bind(store) -> an object callable as (columns, row), and operator()(event) for event ranges.
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "EventAggregator.h"
+#include "EventColumnStore.h"
+#include "Instrumentation.h"
+#include "SimdKernels.h"
+#include "SimulationEvent.h"
+#include "SourceDictionary.h"
+
+// The columns a predicate reads, fetched once per query rather than once per row.
+struct QueryColumns
+{
+    std::span<const double> timestamps;
+    std::span<const EventType> types;
+    std::span<const SourceId> sourceIds;
+    std::span<const double> values;
+
+    explicit QueryColumns(const EventColumnStore& store)
+        : timestamps{ store.Timestamps() }, types{ store.Types() }, sourceIds{ store.SourceIds() }, values{ store.Values() }
+    {
+    }
+};
+
+// String literal usable as a template argument: SourceNamed<"engine1">.
+template <std::size_t N>
+struct QueryString
+{
+    char text[N]{};
+
+    constexpr QueryString(const char (&literal)[N]) { std::copy_n(literal, N, text); }
+    constexpr std::string_view View() const { return { text, N - 1 }; }
+};
+
+// ** Predicates **
+
+//1. Compile-time keys: the key is part of the type, the comparison is against a constant.
+template <EventType Key>
+struct Type
+{
+    static constexpr EventType TypeKey() { return Key; }
+    Type Bind(const EventColumnStore&) const { return *this; }
+    bool operator()(const QueryColumns& columns, std::size_t row) const { return columns.types[row] == Key; }
+    bool operator()(const SimulationEvent& event) const { return event.type == Key; }
+};
+
+template <SourceId Id>
+struct Source
+{
+    static constexpr SourceId SourceKey() { return Id; }
+    Source Bind(const EventColumnStore&) const { return *this; }
+    bool operator()(const QueryColumns& columns, std::size_t row) const { return columns.sourceIds[row] == Id; }
+};
+
+//2. Runtime keys, for the same query shapes.
+struct TypeIs
+{
+    EventType type{};
+
+    EventType TypeKey() const { return type; }
+    TypeIs Bind(const EventColumnStore&) const { return *this; }
+    bool operator()(const QueryColumns& columns, std::size_t row) const { return columns.types[row] == type; }
+    bool operator()(const SimulationEvent& event) const { return event.type == type; }
+};
+
+struct SourceIs
+{
+    SourceId source{};
+
+    SourceId SourceKey() const { return source; }
+    SourceIs Bind(const EventColumnStore&) const { return *this; }
+    bool operator()(const QueryColumns& columns, std::size_t row) const { return columns.sourceIds[row] == source; }
+};
+
+// A name that is not in the store binds to SourceCount(), an id no row can have, so the query simply matches nothing.
+inline SourceIs BindSourceName(const EventColumnStore& store, std::string_view name)
+{
+    return { store.FindSource(name).value_or(static_cast<SourceId>(store.SourceCount())) };
+}
+
+struct SourceNameIs
+{
+    std::string source{};
+
+    SourceIs Bind(const EventColumnStore& store) const { return BindSourceName(store, source); }// the name is looked up once per query
+    bool operator()(const SimulationEvent& event) const { return event.source == source; }
+};
+
+template <QueryString Name>
+struct SourceNamed
+{
+    SourceIs Bind(const EventColumnStore& store) const { return BindSourceName(store, Name.View()); }
+    bool operator()(const SimulationEvent& event) const { return event.source == Name.View(); }
+};
+
+struct TimeBetween// [fromSec, toSec)
+{
+    double fromSec{ -std::numeric_limits<double>::infinity() };
+    double toSec{ std::numeric_limits<double>::infinity() };
+
+    TimeBetween Bind(const EventColumnStore&) const { return *this; }
+    bool operator()(const QueryColumns& columns, std::size_t row) const { return (columns.timestamps[row] >= fromSec) & (columns.timestamps[row] < toSec); }
+    bool operator()(const SimulationEvent& event) const { return event.timestampSec >= fromSec && event.timestampSec < toSec; }
+};
+
+// Single-column equality predicates, which the SIMD kernels can run directly.
+template <typename Predicate>
+concept TypeEqualityPredicate = requires(const Predicate & predicate) { { predicate.TypeKey() } -> std::same_as<EventType>; };
+
+template <typename Predicate>
+concept SourceEqualityPredicate = requires(const Predicate & predicate) { { predicate.SourceKey() } -> std::same_as<SourceId>; };
+
+//3. Combinators. Where<> matches every row.
+template <typename... Predicates>
+struct Where
+{
+    std::tuple<Predicates...> parts{};
+
+    Where() = default;
+    Where(Predicates... predicates) requires (sizeof...(Predicates) > 0) : parts{ std::move(predicates)... } {}
+
+    // One predicate binds to itself, so Where<Type<K>> is still a single-column equality for the SIMD path.
+    auto Bind(const EventColumnStore& store) const
+    {
+        if constexpr (sizeof...(Predicates) == 1)
+        {
+            return std::get<0>(parts).Bind(store);
+        }
+        else
+        {
+            return std::apply([&store](const auto&... part) { return Where<decltype(part.Bind(store))...>{ part.Bind(store)... }; }, parts);
+        }
+    }
+
+    bool operator()(const QueryColumns& columns, std::size_t row) const
+    {
+        return std::apply([&](const auto&... part) { return (true & ... & part(columns, row)); }, parts);// no short-circuit: no branch per part
+    }
+
+    bool operator()(const SimulationEvent& event) const
+    {
+        return std::apply([&](const auto&... part) { return (part(event) && ...); }, parts);
+    }
+};
+
+template <typename... Predicates>
+struct AnyOf
+{
+    std::tuple<Predicates...> parts{};
+
+    AnyOf() = default;
+    AnyOf(Predicates... predicates) requires (sizeof...(Predicates) > 0) : parts{ std::move(predicates)... } {}
+
+    auto Bind(const EventColumnStore& store) const
+    {
+        return std::apply([&store](const auto&... part) { return AnyOf<decltype(part.Bind(store))...>{ part.Bind(store)... }; }, parts);
+    }
+
+    bool operator()(const QueryColumns& columns, std::size_t row) const
+    {
+        return std::apply([&](const auto&... part) { return (false | ... | part(columns, row)); }, parts);
+    }
+
+    bool operator()(const SimulationEvent& event) const
+    {
+        return std::apply([&](const auto&... part) { return (part(event) || ...); }, parts);
+    }
+};
+
+template <typename Predicate>
+struct Not
+{
+    Predicate part{};
+
+    auto Bind(const EventColumnStore& store) const { return Not<decltype(part.Bind(store))>{ part.Bind(store) }; }
+    bool operator()(const QueryColumns& columns, std::size_t row) const { return !part(columns, row); }
+    bool operator()(const SimulationEvent& event) const { return !part(event); }
+};
+
+// ** Aggregates **
+// AddIf() sees every row with whether it matched, without branching on it, so a query over mixed rows does not pay
+// for a mispredict per row and the loop can vectorize. Result() gives the answer; Count never reads the value column.
+
+// matched ? value : otherwise, as bit masking: compilers tend to turn the ternary back into a branch.
+inline double SelectValue(bool matched, double value, double otherwise)
+{
+    const std::uint64_t keep = std::uint64_t{ 0 } - static_cast<std::uint64_t>(matched);// all ones when matched
+    return std::bit_cast<double>((std::bit_cast<std::uint64_t>(value) & keep) | (std::bit_cast<std::uint64_t>(otherwise) & ~keep));
+}
+
+struct Sum
+{
+    double sum{};
+
+    void AddIf(bool matched, double value) { sum += SelectValue(matched, value, 0.0); }
+    double Result() const { return sum; }
+};
+
+struct Count
+{
+    std::uint64_t count{};
+
+    void AddIf(bool matched, double) { count += matched; }
+    std::uint64_t Result() const { return count; }
+};
+
+struct Min
+{
+    double min{ std::numeric_limits<double>::infinity() };  // +inf when nothing matched, like AggregateStats
+
+    void AddIf(bool matched, double value) { min = std::min(min, SelectValue(matched, value, std::numeric_limits<double>::infinity())); }
+    double Result() const { return min; }
+};
+
+struct Max
+{
+    double max{ -std::numeric_limits<double>::infinity() };
+
+    void AddIf(bool matched, double value) { max = std::max(max, SelectValue(matched, value, -std::numeric_limits<double>::infinity())); }
+    double Result() const { return max; }
+};
+
+struct Mean
+{
+    double sum{};
+    std::uint64_t count{};
+
+    void AddIf(bool matched, double value)
+    {
+        sum += SelectValue(matched, value, 0.0);
+        count += matched;
+    }
+    double Result() const { return count ? sum / static_cast<double>(count) : 0.0; }
+};
+
+struct Stats// everything at once (EventAggregator.h)
+{
+    AggregateStats stats{};
+
+    void AddIf(bool matched, double value)
+    {
+        if (matched) stats.Add(value);// Welford's update divides: worth a branch
+    }
+    const AggregateStats& Result() const { return stats; }
+};
+
+// ** Queries **
+
+template <typename Aggregator, typename Filter = Where<>>
+struct Aggregate
+{
+    static auto Run(const EventColumnStore& store, const Filter& filter = {}) { return RunFrom(store, 0, filter); }
+
+    // Only rows [firstRow, store.Size()): the rows appended since a cached result was computed (QueryCache.h).
+    static auto RunFrom(const EventColumnStore& store, std::size_t firstRow, const Filter& filter = {})
+    {
+        ESP_TIME_OPERATION("query_aggregate", store.Size() - firstRow);
+        const auto predicate = filter.Bind(store);
+        using Bound = std::remove_cvref_t<decltype(predicate)>;
+
+        if constexpr (std::same_as<Aggregator, Sum> && TypeEqualityPredicate<Bound>)
+        {
+            return SumWhereType(store.Types().subspan(firstRow), store.Values().subspan(firstRow), predicate.TypeKey());
+        }
+        else if constexpr (std::same_as<Aggregator, Sum> && SourceEqualityPredicate<Bound>)
+        {
+            return SumWhereSource(store.SourceIds().subspan(firstRow), store.Values().subspan(firstRow), predicate.SourceKey());
+        }
+        else
+        {
+            const QueryColumns columns{ store };
+            Aggregator aggregate{};
+            for (std::size_t row = firstRow; row < columns.values.size(); ++row)
+            {
+                aggregate.AddIf(predicate(columns, row), columns.values[row]);
+            }
+            return aggregate.Result();
+        }
+    }
+
+    template <std::ranges::input_range Events>
+        requires std::same_as<std::remove_cvref_t<std::ranges::range_reference_t<Events>>, SimulationEvent>
+    static auto Run(Events&& events, const Filter& filter = {})
+    {
+        ESP_TIME_OPERATION("vector_query_aggregate", 0);// an input range (a filter view) may not know its size
+        Aggregator aggregate{};
+        for (const SimulationEvent& event : events)
+        {
+            aggregate.AddIf(filter(event), event.value);
+        }
+        return aggregate.Result();
+    }
+};
+
+// Matching row numbers, in row order (a selection vector, like SelectByType). Gather() it for a standalone store.
+template <typename Filter = Where<>>
+struct Select
+{
+    static std::vector<EventIndex> Run(const EventColumnStore& store, const Filter& filter = {})
+    {
+        std::vector<EventIndex> selection{};
+        AppendFrom(store, 0, selection, filter);
+        return selection;
+    }
+
+    // Appends the matches among rows [firstRow, store.Size()) to selection, e.g. to extend a cached selection (QueryCache.h).
+    static void AppendFrom(const EventColumnStore& store, std::size_t firstRow, std::vector<EventIndex>& selection, const Filter& filter = {})
+    {
+        ESP_TIME_OPERATION("query_select", store.Size() - firstRow);
+        const auto predicate = filter.Bind(store);
+        using Bound = std::remove_cvref_t<decltype(predicate)>;
+
+        if constexpr (TypeEqualityPredicate<Bound>)
+        {
+            SelectByType(store.Types().subspan(firstRow), predicate.TypeKey(), selection, static_cast<EventIndex>(firstRow));
+        }
+        else if constexpr (SourceEqualityPredicate<Bound>)
+        {
+            SelectBySource(store.SourceIds().subspan(firstRow), predicate.SourceKey(), selection, static_cast<EventIndex>(firstRow));
+        }
+        else
+        {
+            const QueryColumns columns{ store };
+            for (std::size_t row = firstRow; row < columns.values.size(); ++row)
+            {
+                if (predicate(columns, row)) selection.push_back(static_cast<EventIndex>(row));
+            }
+        }
+    }
+};
+
+// ** Runtime fallback **
+// For queries assembled at run time (GUI, CLI): every combination of filters maps onto one of the instantiations above.
+
+enum class QueryAggregate : std::uint8_t
+{
+    Sum,
+    Count,
+    Min,
+    Max,
+    Mean
+};
+
+struct QuerySpec
+{
+    QueryAggregate aggregate{ QueryAggregate::Sum };
+    std::optional<EventType> type{};
+    std::optional<SourceId> source{};
+    std::optional<double> fromSec{};    // with toSec: only events in [fromSec, toSec)
+    std::optional<double> toSec{};
+};
+
+// Calls run(predicates...) with the predicates spec asks for, so each combination gets its fused instantiation.
+template <typename Run>
+auto WithQueryPredicates(const QuerySpec& spec, Run run)
+{
+    const TypeIs type{ spec.type.value_or(EventType{}) };
+    const SourceIs source{ spec.source.value_or(SourceId{}) };
+    const TimeBetween time{ spec.fromSec.value_or(-std::numeric_limits<double>::infinity()), spec.toSec.value_or(std::numeric_limits<double>::infinity()) };
+    const bool byTime = spec.fromSec || spec.toSec;
+
+    if (spec.type && spec.source && byTime) return run(type, source, time);
+    if (spec.type && spec.source) return run(type, source);
+    if (spec.type && byTime) return run(type, time);
+    if (spec.source && byTime) return run(source, time);
+    if (spec.type) return run(type);
+    if (spec.source) return run(source);
+    if (byTime) return run(time);
+    return run();
+}
+
+template <typename Aggregator>
+double RunQueryAs(const EventColumnStore& store, const QuerySpec& spec)
+{
+    return WithQueryPredicates(spec, [&store]<typename... Predicates>(Predicates... predicates)
+        {
+            return static_cast<double>(Aggregate<Aggregator, Where<Predicates...>>::Run(store, { predicates... }));
+        });
+}
+
+inline double RunQuery(const EventColumnStore& store, const QuerySpec& spec)
+{
+    switch (spec.aggregate)
+    {
+    case QueryAggregate::Count: return RunQueryAs<Count>(store, spec);
+    case QueryAggregate::Min: return RunQueryAs<Min>(store, spec);
+    case QueryAggregate::Max: return RunQueryAs<Max>(store, spec);
+    case QueryAggregate::Mean: return RunQueryAs<Mean>(store, spec);
+    default: return RunQueryAs<Sum>(store, spec);
+    }
+}
+
+// Rows matching spec's filters (its aggregate is ignored), in row order.
+inline std::vector<EventIndex> RunSelect(const EventColumnStore& store, const QuerySpec& spec)
+{
+    return WithQueryPredicates(spec, [&store]<typename... Predicates>(Predicates... predicates)
+        {
+            return Select<Where<Predicates...>>::Run(store, { predicates... });
+        });
+}
+
+// ** Mergeable totals **
+// Sum, count, min and max of one filter in one pass: every QueryAggregate can be read off them, and two Totals over
+// disjoint rows merge exactly. QueryCache keeps one per filter and folds appended rows into it.
+
+struct Totals
+{
+    double sum{};
+    std::uint64_t count{};
+    double min{ std::numeric_limits<double>::infinity() };
+    double max{ -std::numeric_limits<double>::infinity() };
+
+    void AddIf(bool matched, double value)
+    {
+        sum += SelectValue(matched, value, 0.0);
+        count += matched;
+        min = std::min(min, SelectValue(matched, value, std::numeric_limits<double>::infinity()));
+        max = std::max(max, SelectValue(matched, value, -std::numeric_limits<double>::infinity()));
+    }
+
+    void Merge(const Totals& other)
+    {
+        sum += other.sum;
+        count += other.count;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+
+    const Totals& Result() const { return *this; }
+
+    // The same answer RunQuery gives for this aggregate.
+    double Of(QueryAggregate aggregate) const
+    {
+        switch (aggregate)
+        {
+        case QueryAggregate::Count: return static_cast<double>(count);
+        case QueryAggregate::Min: return min;
+        case QueryAggregate::Max: return max;
+        case QueryAggregate::Mean: return count ? sum / static_cast<double>(count) : 0.0;
+        default: return sum;
+        }
+    }
+};
+
+// Totals of spec's filters over rows [firstRow, store.Size()); spec's aggregate is ignored.
+inline Totals RunQueryTotals(const EventColumnStore& store, const QuerySpec& spec, std::size_t firstRow = 0)
+{
+    return WithQueryPredicates(spec, [&store, firstRow]<typename... Predicates>(Predicates... predicates)
+        {
+            return Aggregate<Totals, Where<Predicates...>>::RunFrom(store, firstRow, { predicates... });
+        });
+}
+
+// Appends the rows among [firstRow, store.Size()) that match spec's filters to selection.
+inline void RunSelectFrom(const EventColumnStore& store, const QuerySpec& spec, std::size_t firstRow, std::vector<EventIndex>& selection)
+{
+    WithQueryPredicates(spec, [&store, firstRow, &selection]<typename... Predicates>(Predicates... predicates)
+        {
+            Select<Where<Predicates...>>::AppendFrom(store, firstRow, selection, { predicates... });
+        });
+}
@@ -0,0 +1,79 @@
+#pragma once
+// Per-query / per-frame arena for result containers (std::pmr).
+// Allocation is a pointer bump in one block, deallocation is free, and Reset() drops everything at once. The block
+// grows to the largest query seen so far: after a Reset the whole high-water amount is one block again, so after
+// warm-up a repeated query makes no heap allocation at all. UpstreamAllocations() counts the ones that still happen.
+//
+//   QueryArena arena{};
+//   arena.Reset();                                              // start of the query / frame
+//   auto groups = GroupBySourceId(store, arena.Resource());     // pmr containers, valid until the next Reset()
+//
+// NOTE: everything allocated from the arena dies at Reset(); never keep a pmr container built on it past that point.
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+class QueryArena
+{
+public:
+    explicit QueryArena(std::size_t initialBytes = 64 * 1024)
+        : bufferBytes{ std::bit_ceil(std::max<std::size_t>(initialBytes, 1024)) }, buffer{ std::make_unique_for_overwrite<std::byte[]>(bufferBytes) }
+    {
+        arena.emplace(buffer.get(), bufferBytes, &upstream);
+    }
+
+    QueryArena(const QueryArena&) = delete;
+    QueryArena& operator=(const QueryArena&) = delete;
+
+    std::pmr::memory_resource* Resource() { return &*arena; }
+
+    // Frees everything allocated since the last Reset. If the block overflowed, it is replaced by one that fits the whole query.
+    void Reset()
+    {
+        arena.reset();// returns the overflow chunks to the heap
+        if (upstream.bytes > 0)
+        {
+            bufferBytes = std::bit_ceil(bufferBytes + upstream.bytes);
+            buffer = std::make_unique_for_overwrite<std::byte[]>(bufferBytes);
+        }
+        upstream.allocations = 0;
+        upstream.bytes = 0;
+        arena.emplace(buffer.get(), bufferBytes, &upstream);
+    }
+
+    std::size_t CapacityBytes() const { return bufferBytes; }
+    std::size_t UpstreamAllocations() const { return upstream.allocations; }// heap allocations since the last Reset; 0 once warmed up
+
+private:
+    // Heap fallback for when the block runs out; counts what it hands out so Reset() knows how big the block must get.
+    class CountingResource : public std::pmr::memory_resource
+    {
+    public:
+        std::size_t allocations{};
+        std::size_t bytes{};
+
+    private:
+        void* do_allocate(std::size_t size, std::size_t alignment) override
+        {
+            ++allocations;
+            bytes += size;
+            return std::pmr::new_delete_resource()->allocate(size, alignment);
+        }
+
+        void do_deallocate(void* pointer, std::size_t size, std::size_t alignment) override
+        {
+            std::pmr::new_delete_resource()->deallocate(pointer, size, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    std::size_t bufferBytes{};
+    std::unique_ptr<std::byte[]> buffer;
+    CountingResource upstream{};
+    std::optional<std::pmr::monotonic_buffer_resource> arena{};
+};
@@ -0,0 +1,164 @@
+#pragma once
+// Materialized results for queries that get asked over and over (dashboard refreshes, the GUI buttons) on one store.
+// Every result remembers the store's Epoch() and how many rows it covers. Asked again after events were appended, it
+// folds in only the new rows: Totals and AggregateReport merge, selections and groups append. A refresh costs
+// O(new events); only a new epoch (Clear(), another store assigned over this one) rebuilds from row 0.
+//
+//   QueryCache cache{ liveStore };
+//   double engine = cache.Run({ QueryAggregate::Sum, {}, engineId });       // full scan the first time
+//   ingestor.Ingest(...);                                                   // liveStore grows by a few events
+//   engine = cache.Run({ QueryAggregate::Sum, {}, engineId });              // scans the appended events only
+//
+// Results are keyed by the query's filters (type, source, time range); sum, count, min, max and mean of one filter
+// share an entry. Merged AggregateStats match a single pass up to floating-point rounding.
+// NOTE: not thread-safe, and the references returned stay valid only until the next call.
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "EventAggregator.h"
+#include "EventColumnStore.h"
+#include "FlatHashMap.h"
+#include "Query.h"
+#include "SimulationEvent.h"
+
+// The filters of a QuerySpec, without its aggregate.
+struct QueryShape
+{
+    std::optional<EventType> type{};
+    std::optional<SourceId> source{};
+    std::optional<double> fromSec{};
+    std::optional<double> toSec{};
+
+    QueryShape() = default;
+    explicit QueryShape(const QuerySpec& spec) : type{ spec.type }, source{ spec.source }, fromSec{ spec.fromSec }, toSec{ spec.toSec } {}
+
+    QuerySpec Spec() const { return { QueryAggregate::Sum, type, source, fromSec, toSec }; }
+
+    friend bool operator==(const QueryShape&, const QueryShape&) = default;
+};
+
+struct QueryShapeHash
+{
+    std::size_t operator()(const QueryShape& shape) const
+    {
+        std::size_t hash = std::hash<std::optional<EventType>>{}(shape.type);
+        for (std::size_t part : { std::hash<std::optional<SourceId>>{}(shape.source), std::hash<std::optional<double>>{}(shape.fromSec),
+            std::hash<std::optional<double>>{}(shape.toSec) })
+        {
+            hash ^= part + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+        }
+        return hash;
+    }
+};
+
+struct QueryCacheStats
+{
+    std::uint64_t hits{};           // nothing appended since the last time: no row read
+    std::uint64_t incremental{};    // only the appended rows read
+    std::uint64_t builds{};         // first time, or a new epoch: every row read
+    std::uint64_t rowsScanned{};
+};
+
+class QueryCache
+{
+public:
+    explicit QueryCache(const EventColumnStore& store) : store{ &store } {}
+
+    // Same answer as RunQuery(store, spec).
+    double Run(const QuerySpec& spec) { return TotalsOf(spec).Of(spec.aggregate); }
+
+    const Totals& TotalsOf(const QuerySpec& spec)
+    {
+        return Refresh(totals[QueryShape{ spec }], [this, &spec](Totals& result, std::size_t firstRow)
+            {
+                result.Merge(RunQueryTotals(*store, spec, firstRow));
+            });
+    }
+
+    // Same rows as RunSelect(store, spec), in row order.
+    const std::vector<EventIndex>& Select(const QuerySpec& spec)
+    {
+        return Refresh(selections[QueryShape{ spec }], [this, &spec](std::vector<EventIndex>& result, std::size_t firstRow)
+            {
+                RunSelectFrom(*store, spec, firstRow, result);
+            });
+    }
+
+    // Same groups as GroupBySourceId(store): rows per SourceId, in row order.
+    const std::vector<std::vector<EventIndex>>& GroupBySourceId()
+    {
+        return Refresh(bySource, [this](std::vector<std::vector<EventIndex>>& result, std::size_t firstRow)
+            {
+                result.resize(store->SourceCount());
+                auto sourceIds = store->SourceIds();
+                for (std::size_t row = firstRow; row < sourceIds.size(); ++row)
+                {
+                    result[sourceIds[row]].push_back(static_cast<EventIndex>(row));
+                }
+            });
+    }
+
+    // Same statistics as AggregateEvents(store).
+    const AggregateReport& Aggregates()
+    {
+        return Refresh(report, [this](AggregateReport& result, std::size_t firstRow)
+            {
+                result.Merge(AggregateEvents(*store, firstRow, store->Size()));
+            });
+    }
+
+    const QueryCacheStats& Stats() const { return stats; }
+
+    void Clear()
+    {
+        totals.Clear();
+        selections.Clear();
+        bySource = {};
+        report = {};
+    }
+
+private:
+    template <typename Result>
+    struct Cached
+    {
+        std::uint64_t epoch{};      // 0: never computed (epochs start at 1)
+        std::size_t rows{};         // result covers rows [0, rows)
+        Result result{};
+    };
+
+    // Nothing to do on a hit; fold(result, firstRow) over the appended rows; or start over on a new epoch.
+    template <typename Result, typename Fold>
+    const Result& Refresh(Cached<Result>& entry, Fold fold)
+    {
+        const std::size_t size = store->Size();
+        if (entry.epoch != store->Epoch() || entry.rows > size)
+        {
+            entry = { store->Epoch(), 0, Result{} };
+            ++stats.builds;
+        }
+        else if (entry.rows == size)
+        {
+            ++stats.hits;
+            return entry.result;
+        }
+        else
+        {
+            ++stats.incremental;
+        }
+        fold(entry.result, entry.rows);
+        stats.rowsScanned += size - entry.rows;
+        entry.rows = size;
+        return entry.result;
+    }
+
+    const EventColumnStore* store;
+    FlatHashMap<QueryShape, Cached<Totals>, QueryShapeHash> totals{};
+    FlatHashMap<QueryShape, Cached<std::vector<EventIndex>>, QueryShapeHash> selections{};
+    Cached<std::vector<std::vector<EventIndex>>> bySource{};
+    Cached<AggregateReport> report{};
+    QueryCacheStats stats{};
+};
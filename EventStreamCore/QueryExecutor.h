@@ -0,0 +1,229 @@
+#pragma once
+// Runs queries off the calling thread, one at a time, newest first: the GUI submits from its frame loop and picks the
+// result up in a later frame, so the window keeps drawing at full rate while a query grinds through 10M events.
+// Submitting cancels the query that is running (it is told through QueryProgress::Cancelled() and its result is thrown
+// away) and replaces any query still waiting, so a burst of clicks only ever runs the first and the last.
+// Results are double-buffered: the worker fills the back buffer, SwapResult() swaps it with the caller's front buffer,
+// and the old front is destroyed on the worker the next time it publishes, never on the caller's thread.
+//
+//   QueryExecutor<LogView> queries{};
+//   queries.Submit("sort", [&store](QueryProgress& progress) { LogView log{}; ...; return log; });
+//   // every frame:
+//   queries.SwapResult(shownLog);                  // true when a newer result arrived
+//   QueryStatus status = queries.Status();         // progress bar while status.running
+//
+// NOTE: the query runs concurrently with the caller: it may only read what the caller does not change meanwhile.
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "ThreadPool.h"
+
+// The running query's side of the executor: a cancellation flag to poll and a progress value to report.
+class QueryProgress
+{
+public:
+    bool Cancelled() const { return cancelled.load(std::memory_order_relaxed); }
+
+    // fraction in [0, 1]; stage names the step, e.g. "sorting" (a string literal: it is read from the other thread).
+    void Report(double fraction, const char* stage = "")
+    {
+        this->fraction.store(fraction, std::memory_order_relaxed);
+        this->stage.store(stage, std::memory_order_relaxed);
+    }
+
+private:
+    template <typename Result>
+    friend class QueryExecutor;
+
+    std::atomic<bool> cancelled{};
+    std::atomic<double> fraction{};
+    std::atomic<const char*> stage{ "" };
+};
+
+struct QueryStatus
+{
+    bool running{};                 // submitted and not published (or failed) yet
+    std::string name{};             // of the newest query
+    double fraction{};
+    std::string_view stage{};
+    double elapsedSec{};            // since the newest query was submitted
+    std::string error{};            // what() of the newest query if it threw; empty otherwise
+};
+
+template <typename Result>
+class QueryExecutor
+{
+public:
+    using Query = std::function<Result(QueryProgress&)>;
+
+    explicit QueryExecutor(ThreadPool& pool = SharedThreadPool()) : pool{ pool }, state{ std::make_shared<State>() } {}
+
+    // Cancels whatever runs and waits for it: a query may reference data that dies with the caller.
+    ~QueryExecutor()
+    {
+        std::unique_lock lock{ state->mutex };
+        state->waiting.reset();
+        if (state->current) state->current->progress.cancelled.store(true, std::memory_order_relaxed);
+        state->idle.wait(lock, [this] { return !state->workerActive; });
+    }
+
+    QueryExecutor(const QueryExecutor&) = delete;
+    QueryExecutor& operator=(const QueryExecutor&) = delete;
+
+    // Returns the query's generation; only the newest generation's result is ever published.
+    std::uint64_t Submit(std::string name, Query query)
+    {
+        std::lock_guard lock{ state->mutex };
+        const std::uint64_t generation = ++state->generation;
+        if (state->current) state->current->progress.cancelled.store(true, std::memory_order_relaxed);
+        state->waiting = Job{ generation, std::move(query) };
+        state->name = std::move(name);
+        state->submitted = Clock::now();
+        state->error.clear();
+        state->running = true;
+        if (!state->workerActive)
+        {
+            state->workerActive = true;
+            pool.Submit([state = state] { RunJobs(*state); });
+        }
+        return generation;
+    }
+
+    // Drops the waiting query and cancels the running one; nothing is published until the next Submit.
+    void Cancel()
+    {
+        std::lock_guard lock{ state->mutex };
+        ++state->generation;
+        state->waiting.reset();
+        if (state->current) state->current->progress.cancelled.store(true, std::memory_order_relaxed);
+        state->running = false;
+        state->error.clear();
+    }
+
+    // Swaps the newest finished result into front; false (front untouched) if nothing new arrived since the last swap.
+    bool SwapResult(Result& front)
+    {
+        std::lock_guard lock{ state->mutex };
+        if (!state->fresh)
+        {
+            return false;
+        }
+        std::swap(front, *state->back);
+        state->fresh = false;
+        return true;
+    }
+
+    QueryStatus Status() const
+    {
+        std::lock_guard lock{ state->mutex };
+        QueryStatus status{ state->running, state->name };
+        if (state->running)
+        {
+            if (state->current && state->current->generation == state->generation)
+            {
+                status.fraction = state->current->progress.fraction.load(std::memory_order_relaxed);
+                status.stage = state->current->progress.stage.load(std::memory_order_relaxed);
+            }
+            status.elapsedSec = std::chrono::duration<double>(Clock::now() - state->submitted).count();
+        }
+        status.error = state->error;
+        return status;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job
+    {
+        std::uint64_t generation{};
+        Query query{};
+    };
+
+    struct Running
+    {
+        std::uint64_t generation{};
+        QueryProgress progress{};
+    };
+
+    struct State
+    {
+        mutable std::mutex mutex{};
+        std::condition_variable idle{};
+        std::uint64_t generation{};
+        std::optional<Job> waiting{};
+        std::shared_ptr<Running> current{};
+        bool workerActive{};            // a pool task is draining the jobs
+        bool running{};
+        bool fresh{};                   // back holds a result SwapResult has not taken yet
+        std::optional<Result> back{};
+        std::string name{};
+        Clock::time_point submitted{};
+        std::string error{};
+    };
+
+    // One pool task runs the jobs back to back until none is waiting, so two queries never run at once.
+    static void RunJobs(State& state)
+    {
+        std::unique_lock lock{ state.mutex };
+        while (state.waiting)
+        {
+            Job job = std::move(*state.waiting);
+            state.waiting.reset();
+            auto running = std::make_shared<Running>();
+            running->generation = job.generation;
+            state.current = running;
+            lock.unlock();
+
+            std::optional<Result> result{};
+            std::string error{};
+            try
+            {
+                result.emplace(job.query(running->progress));
+            }
+            catch (const std::exception& exception)
+            {
+                error = exception.what();
+            }
+            catch (...)
+            {
+                error = "unknown error";
+            }
+
+            lock.lock();
+            state.current.reset();
+            if (job.generation != state.generation || running->progress.Cancelled())
+            {
+                lock.unlock();
+                result.reset();// a cancelled result dies here, outside the lock
+                lock.lock();
+                continue;
+            }
+            state.running = false;
+            state.error = std::move(error);
+            if (result)
+            {
+                std::swap(state.back, result);// the previous front (or an untaken result) moves into result...
+                state.fresh = true;
+            }
+            lock.unlock();
+            result.reset();// ...and is destroyed here, on the worker
+            lock.lock();
+        }
+        state.workerActive = false;
+        state.idle.notify_all();
+    }
+
+    ThreadPool& pool;
+    std::shared_ptr<State> state;
+};
@@ -0,0 +1,113 @@
+#pragma once
+// LSD radix sort for timestamp ordering.
+// A double is turned into an unsigned 64-bit key whose integer order is the numeric order (flip every bit of a
+// negative value, only the sign bit of a positive one), then the keys are sorted 11 bits at a time with counting
+// passes: O(n) work, no comparisons, and only keys and row numbers move, never an event or its source string.
+// Descending order is the same sort on ~key, so there is no separate std::greater path.
+// The sort is stable: equal timestamps keep their input order in both directions, exactly like std::stable_sort.
+// NOTE: NaN timestamps sort after +inf (before -inf when negative); a comparison sort has no defined order for them at all.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include "SimulationEvent.h"
+
+inline constexpr std::uint64_t TimeKeySignBit = std::uint64_t{ 1 } << 63;
+
+inline std::uint64_t TimeSortKey(double timestampSec, bool isAscending = true)
+{
+    if (timestampSec == 0.0)
+    {
+        timestampSec = 0.0;// -0.0 == 0.0, so both get one key and stay tied
+    }
+    const auto bits = std::bit_cast<std::uint64_t>(timestampSec);
+    const std::uint64_t key = (bits & TimeKeySignBit) ? ~bits : (bits | TimeKeySignBit);
+    return isAscending ? key : ~key;
+}
+
+inline constexpr int RadixDigitBits = 11;
+inline constexpr int RadixPasses = (64 + RadixDigitBits - 1) / RadixDigitBits;// 6
+inline constexpr std::size_t RadixBuckets = std::size_t{ 1 } << RadixDigitBits;
+inline constexpr std::size_t RadixSmallSortRows = 256;// below this, clearing 6 x 2048 counters costs more than sorting
+
+// Permutation that orders timestamps ascending (or descending); timestamps[order[0]] comes first.
+inline std::vector<EventIndex> RadixSortedOrder(std::span<const double> timestamps, bool isAscending = true)
+{
+    const std::size_t count = timestamps.size();
+    std::vector<EventIndex> order(count);
+
+    if (count < RadixSmallSortRows)
+    {
+        std::iota(order.begin(), order.end(), EventIndex{ 0 });
+        std::ranges::stable_sort(order, {}, [&](EventIndex row) { return TimeSortKey(timestamps[row], isAscending); });
+        return order;
+    }
+
+    std::vector<std::uint64_t> keys(count);
+    std::vector<std::uint64_t> keysOut(count);
+    std::vector<EventIndex> rows(count);
+
+    // One read of the column builds the keys and every pass's histogram.
+    std::vector<std::array<std::uint32_t, RadixBuckets>> histograms(RadixPasses);
+    for (std::size_t row = 0; row < count; ++row)
+    {
+        const std::uint64_t key = TimeSortKey(timestamps[row], isAscending);
+        keys[row] = key;
+        for (int pass = 0; pass < RadixPasses; ++pass)
+        {
+            ++histograms[pass][(key >> (pass * RadixDigitBits)) & (RadixBuckets - 1)];
+        }
+    }
+
+    // A digit that is the same for every key (the sign/exponent bits of timestamps in a narrow range, usually) needs no pass.
+    std::vector<int> passes{};
+    for (int pass = 0; pass < RadixPasses; ++pass)
+    {
+        const auto& histogram = histograms[pass];
+        const std::uint64_t digit = (keys[0] >> (pass * RadixDigitBits)) & (RadixBuckets - 1);
+        if (histogram[digit] != count)
+        {
+            passes.push_back(pass);
+        }
+    }
+
+    if (passes.empty())
+    {
+        std::iota(order.begin(), order.end(), EventIndex{ 0 });// all keys equal: input order is the stable order
+        return order;
+    }
+
+    // Rows ping-pong between `rows` and `order`, starting on whichever makes the last pass land in `order`.
+    // The first pass has no input rows yet: the input order is the identity, so it scatters the loop counter.
+    for (std::size_t at = 0; at < passes.size(); ++at)
+    {
+        const int pass = passes[at];
+        const int shift = pass * RadixDigitBits;
+        const bool first = at == 0;
+        const bool last = at + 1 == passes.size();
+
+        std::array<std::uint32_t, RadixBuckets> offsets{};// exclusive prefix sum: where each digit's run starts
+        std::exclusive_scan(histograms[pass].begin(), histograms[pass].end(), offsets.begin(), std::uint32_t{ 0 });
+
+        const bool intoOrder = (passes.size() - at) % 2 == 1;
+        std::vector<EventIndex>& rowsOut = intoOrder ? order : rows;
+        const std::vector<EventIndex>& rowsIn = intoOrder ? rows : order;
+        for (std::size_t index = 0; index < count; ++index)
+        {
+            const std::uint64_t key = keys[index];
+            const std::uint32_t position = offsets[(key >> shift) & (RadixBuckets - 1)]++;
+            rowsOut[position] = first ? static_cast<EventIndex>(index) : rowsIn[index];
+            if (!last)
+            {
+                keysOut[position] = key;// the final pass only needs the rows
+            }
+        }
+        keys.swap(keysOut);
+    }
+    return order;
+}
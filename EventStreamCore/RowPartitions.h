@@ -0,0 +1,97 @@
+#pragma once
+// Count-then-scatter group-by: every group's rows in one contiguous buffer.
+// Pass 1 counts the rows of each key; an exclusive prefix sum turns the counts into offsets; pass 2 writes every row
+// at its group's next free offset. The result is one row buffer plus one offset array however many groups there are:
+// group k is rows[offsets[k], offsets[k + 1]), in row order. Nothing regrows, and a group is just a span.
+// Keys must be small dense integers: SourceId, or EventType (cast to its slot, as TypeSlot does).
+//
+//   RowPartitions bySource = PartitionBySourceId(store);
+//   for (SourceId id = 0; id < bySource.GroupCount(); ++id) { for (EventIndex row : bySource.Group(id)) ... }
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include "SimulationEvent.h"
+
+struct RowPartitions
+{
+    explicit RowPartitions(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) : rows{ resource }, offsets{ resource } {}
+
+    std::pmr::vector<EventIndex> rows;      // all groups back to back
+    std::pmr::vector<std::size_t> offsets;  // GroupCount() + 1 entries; group k starts at offsets[k]
+
+    std::size_t GroupCount() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    std::size_t RowCount() const { return rows.size(); }
+
+    // Rows of one key; empty for a key with no rows or past the last group.
+    std::span<const EventIndex> Group(std::size_t key) const
+    {
+        if (key >= GroupCount())
+        {
+            return {};
+        }
+        return std::span<const EventIndex>{ rows }.subspan(offsets[key], offsets[key + 1] - offsets[key]);
+    }
+};
+
+// offsets[k] holds the count of key k: make it the start of group k (offsets[groupCount] = total).
+inline void PartitionStartsFromCounts(std::span<std::size_t> offsets)
+{
+    std::size_t start = 0;
+    for (std::size_t& offset : offsets)
+    {
+        const std::size_t count = offset;
+        offset = start;
+        start += count;
+    }
+}
+
+// After the scatter offsets[k] is the end of group k, i.e. the start of k + 1: shift back by one slot.
+inline void PartitionStartsFromEnds(std::span<std::size_t> offsets)
+{
+    std::shift_right(offsets.begin(), offsets.end(), 1);
+    offsets[0] = 0;
+}
+
+// Partitions rows 0 .. keys.size() by keys[row], reusing the buffers already in `partitions`.
+template <typename Key>
+void PartitionRows(std::span<const Key> keys, std::size_t groupCount, RowPartitions& partitions)
+{
+    auto& offsets = partitions.offsets;
+    offsets.assign(groupCount + 1, 0);
+    for (Key key : keys)
+    {
+        ++offsets[static_cast<std::size_t>(key)];
+    }
+    PartitionStartsFromCounts(offsets);
+
+    partitions.rows.resize(keys.size());
+    for (std::size_t row = 0; row < keys.size(); ++row)
+    {
+        partitions.rows[offsets[static_cast<std::size_t>(keys[row])]++] = static_cast<EventIndex>(row);
+    }
+    PartitionStartsFromEnds(offsets);
+}
+
+// Same over a selection: only `selection`'s rows are partitioned, keyed by keys[row], keeping the selection's order.
+template <typename Key>
+void PartitionRows(std::span<const Key> keys, std::span<const EventIndex> selection, std::size_t groupCount, RowPartitions& partitions)
+{
+    auto& offsets = partitions.offsets;
+    offsets.assign(groupCount + 1, 0);
+    for (EventIndex row : selection)
+    {
+        ++offsets[static_cast<std::size_t>(keys[row])];
+    }
+    PartitionStartsFromCounts(offsets);
+
+    partitions.rows.resize(selection.size());
+    for (EventIndex row : selection)
+    {
+        partitions.rows[offsets[static_cast<std::size_t>(keys[row])]++] = row;
+    }
+    PartitionStartsFromEnds(offsets);
+}
@@ -0,0 +1,343 @@
+#pragma once
+// Regression diff of two simulation runs (simA vs simB): states are aligned by timestamp and compared field by field
+// in one chunked pass on the pool. Each chunk of run A merges itself against the matching stretch of run B and only
+// notes the aligned stretches, (rowA, rowB, length); every field is then diffed over those contiguous slices, so no
+// matching state is ever copied. What comes back is a compact report: per-field RMSE, the largest deviation and how
+// many states exceeded that field's threshold, plus the first maxDeviations exceedances in time order.
+//
+//   SimulationRun a = SimulationRunFromStates(simA), b = SimulationRunFromStates(simB);
+//   RunComparisonOptions options{};
+//   options.thresholds = { 0.5, 0.1, 2.0 };                       // positionX, velocityY, temperature
+//   RunComparisonReport report = CompareRuns(a, b, options);      // report.fields[1].rmse, report.deviations, ...
+//
+// NOTE: both runs must be sorted by timestamp. timeToleranceSec absorbs floating-point noise in the timestamps; keep it
+// below half the time step, so a state can only ever match one state of the other run.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Instrumentation.h"
+#include "ParallelAlgorithms.h"
+#include "SimdKernels.h"
+#include "ThreadPool.h"
+
+// The notes' state record; SimulationRunFromStates turns a vector of them into columns.
+struct SimulationState
+{
+    double timestamp{};
+    double positionX{};
+    double velocityY{};
+    double temperature{};
+};
+
+// One run as columns: a time column and any number of named value fields of the same length.
+struct SimulationRun
+{
+    std::vector<double> timestamps{};
+    std::vector<std::string> fieldNames{};
+    std::vector<std::vector<double>> fields{};      // [field][row]
+
+    std::size_t Size() const { return timestamps.size(); }
+};
+
+inline SimulationRun SimulationRunFromStates(std::span<const SimulationState> states)
+{
+    SimulationRun run{};
+    run.fieldNames = { "positionX", "velocityY", "temperature" };
+    run.fields.assign(3, {});
+    run.timestamps.reserve(states.size());
+    for (auto& field : run.fields) field.reserve(states.size());
+    for (const SimulationState& state : states)
+    {
+        run.timestamps.push_back(state.timestamp);
+        run.fields[0].push_back(state.positionX);
+        run.fields[1].push_back(state.velocityY);
+        run.fields[2].push_back(state.temperature);
+    }
+    return run;
+}
+
+struct RunComparisonOptions
+{
+    std::vector<double> thresholds{};                   // per field: |a - b| > threshold is a deviation; missing: never
+    double timeToleranceSec{ 0.0 };                     // timestamps this close are the same instant
+    std::size_t maxDeviations{ 1000 };                  // deviations listed; all of them are still counted
+};
+
+struct FieldComparison
+{
+    std::string name{};
+    double sumSquares{};
+    double rmse{};                                      // over the matched states
+    double maxAbsDiff{};
+    double timeOfMax{ std::numeric_limits<double>::quiet_NaN() };
+    std::uint64_t exceeded{};                           // matched states over the threshold
+};
+
+struct Deviation
+{
+    double timestamp{};                                 // run A's
+    std::size_t field{};
+    double a{};
+    double b{};
+};
+
+struct RunComparisonReport
+{
+    std::uint64_t matched{};
+    std::uint64_t onlyInA{};                            // states of A with no state of B at that time, and vice versa
+    std::uint64_t onlyInB{};
+    std::uint64_t statesExceeded{};                     // matched states with at least one field over its threshold
+    std::vector<FieldComparison> fields{};
+    std::vector<Deviation> deviations{};                // the first maxDeviations (state, field) exceedances in time order
+
+    bool Identical() const { return onlyInA == 0 && onlyInB == 0 && statesExceeded == 0; }
+};
+
+struct AlignedStretch
+{
+    std::size_t rowA{};
+    std::size_t rowB{};
+    std::size_t length{};
+};
+
+// The matching state pairs of A rows [beginA, endA), merged against B from rowB on, as stretches where both rows advance
+// together. Returns the B row where the walk stopped; unmatchedA counts A rows that found no partner.
+inline std::size_t AlignRuns(std::span<const double> timesA, std::span<const double> timesB, std::size_t beginA, std::size_t endA, std::size_t rowB, double tolerance,
+    std::vector<AlignedStretch>& stretches, std::uint64_t& unmatchedA)
+{
+    std::size_t rowA = beginA;
+    while (rowA < endA && rowB < timesB.size())
+    {
+        const double a = timesA[rowA];
+        const double b = timesB[rowB];
+        if (a < b - tolerance)
+        {
+            ++unmatchedA;
+            ++rowA;
+        }
+        else if (b < a - tolerance)
+        {
+            ++rowB;
+        }
+        else
+        {
+            if (!stretches.empty() && stretches.back().rowA + stretches.back().length == rowA && stretches.back().rowB + stretches.back().length == rowB)
+            {
+                ++stretches.back().length;
+            }
+            else
+            {
+                stretches.push_back({ rowA, rowB, 1 });
+            }
+            ++rowA;
+            ++rowB;
+        }
+    }
+    unmatchedA += endA - rowA;
+    return rowB;
+}
+
+struct StretchDiff
+{
+    double sumSquares{};
+    double maxAbs{};
+};
+
+// Sum of squared differences and the largest |a - b| over two equally long slices. NaN differences are skipped by
+// the max, not by the sum.
+inline StretchDiff DiffSlices(const double* a, const double* b, std::size_t length)
+{
+    StretchDiff diff{};
+    std::size_t i = 0;
+#if defined(EVENT_SIMD_AVX512) || defined(EVENT_SIMD_AVX2)
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    __m256d squares0 = _mm256_setzero_pd();
+    __m256d squares1 = _mm256_setzero_pd();// two accumulators to hide the add latency
+    __m256d max0 = _mm256_setzero_pd();
+    __m256d max1 = _mm256_setzero_pd();
+    for (; i + 8 <= length; i += 8)
+    {
+        const __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+        const __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4));
+        squares0 = _mm256_add_pd(squares0, _mm256_mul_pd(d0, d0));
+        squares1 = _mm256_add_pd(squares1, _mm256_mul_pd(d1, d1));
+        max0 = _mm256_max_pd(_mm256_andnot_pd(signBit, d0), max0);// NaN first: max_pd then keeps the running max
+        max1 = _mm256_max_pd(_mm256_andnot_pd(signBit, d1), max1);
+    }
+    alignas(32) std::array<double, 4> lanes{};
+    _mm256_store_pd(lanes.data(), _mm256_add_pd(squares0, squares1));
+    diff.sumSquares = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    _mm256_store_pd(lanes.data(), _mm256_max_pd(max0, max1));
+    diff.maxAbs = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+#endif
+    for (; i < length; ++i)
+    {
+        const double d = a[i] - b[i];
+        diff.sumSquares += d * d;
+        diff.maxAbs = std::max(diff.maxAbs, std::abs(d));
+    }
+    return diff;
+}
+
+inline RunComparisonReport CompareRuns(const SimulationRun& a, const SimulationRun& b, const RunComparisonOptions& options = {}, ThreadPool& pool = SharedThreadPool())
+{
+    const std::size_t fieldCount = a.fields.size();
+    if (b.fields.size() != fieldCount)
+    {
+        throw std::invalid_argument("CompareRuns: the runs have different numbers of fields");
+    }
+    for (std::size_t field = 0; field < fieldCount; ++field)
+    {
+        if (a.fields[field].size() != a.Size() || b.fields[field].size() != b.Size())
+        {
+            throw std::invalid_argument("CompareRuns: a field column is not as long as its run's time column");
+        }
+    }
+    ESP_TIME_OPERATION("compare_runs", a.Size() + b.Size());
+
+    std::vector<double> thresholds(fieldCount, std::numeric_limits<double>::infinity());
+    std::copy_n(options.thresholds.begin(), std::min(options.thresholds.size(), fieldCount), thresholds.begin());
+
+    struct Partial
+    {
+        std::size_t beginB{};                       // where this chunk's walk through B starts and stops
+        std::size_t endB{};
+        std::vector<AlignedStretch> stretches{};
+        std::uint64_t matched{};
+        std::uint64_t onlyInA{};
+        std::uint64_t onlyInB{};
+        std::uint64_t statesExceeded{};
+        std::vector<FieldComparison> fields{};
+        std::vector<Deviation> deviations{};
+    };
+    std::vector<Partial> partials(ChunkCount(pool, a.Size(), ParallelChunkRows));
+    std::vector<std::pair<std::size_t, std::size_t>> chunkRows(partials.size());
+    const double tolerance = options.timeToleranceSec;
+
+    //1. Align: each chunk of A guesses where it starts in B and runs one merge walk. Only the stretches are kept.
+    ParallelForChunks(pool, a.Size(), ParallelChunkRows, [&](std::size_t begin, std::size_t end, std::size_t chunk)
+        {
+            Partial& partial = partials[chunk];
+            chunkRows[chunk] = { begin, end };
+            partial.beginB = static_cast<std::size_t>(std::ranges::lower_bound(b.timestamps, a.timestamps[begin] - tolerance) - b.timestamps.begin());
+            partial.endB = AlignRuns(a.timestamps, b.timestamps, begin, end, partial.beginB, tolerance, partial.stretches, partial.onlyInA);
+        });
+
+    //2. Stitch the walks into the serial one: a chunk really starts where the previous one stopped, or later if every
+    // B row before its guess is too early for it. A guess the previous chunk walked past (its last states matched B
+    // rows beyond the guess) is walked again from the true start, so no B state is ever matched twice and the report
+    // never depends on the chunking. Rare: it takes timestamps within the tolerance of a chunk boundary.
+    std::size_t walkedB = 0;
+    for (std::size_t chunk = 0; chunk < partials.size(); ++chunk)
+    {
+        Partial& partial = partials[chunk];
+        const std::size_t beginB = std::max(partial.beginB, walkedB);
+        if (beginB != partial.beginB)
+        {
+            partial.stretches.clear();
+            partial.onlyInA = 0;
+            partial.beginB = beginB;
+            partial.endB = AlignRuns(a.timestamps, b.timestamps, chunkRows[chunk].first, chunkRows[chunk].second, beginB, tolerance, partial.stretches, partial.onlyInA);
+        }
+        for (const AlignedStretch& stretch : partial.stretches) partial.matched += stretch.length;
+        partial.onlyInB = (partial.beginB - walkedB) + (partial.endB - partial.beginB - partial.matched);// B rows skipped before and during the walk
+        walkedB = partial.endB;
+    }
+    const std::uint64_t onlyInBAfterA = b.Size() - walkedB;
+
+    ParallelForChunks(pool, a.Size(), ParallelChunkRows, [&](std::size_t, std::size_t, std::size_t chunk)
+        {
+            Partial& partial = partials[chunk];
+            partial.fields.resize(fieldCount);
+            const std::vector<AlignedStretch>& stretches = partial.stretches;
+
+            //3. Diff every field over the stretches: contiguous slices of both runs, no gathers, no copies.
+            std::vector<std::uint8_t> exceeded{};          // per matched state of this chunk, once one deviates: any field over its threshold
+            for (std::size_t field = 0; field < fieldCount; ++field)
+            {
+                FieldComparison& result = partial.fields[field];
+                const double* valuesA = a.fields[field].data();
+                const double* valuesB = b.fields[field].data();
+                const double threshold = thresholds[field];
+                std::size_t state = 0;
+                for (const AlignedStretch& stretch : stretches)
+                {
+                    const double* sliceA = valuesA + stretch.rowA;
+                    const double* sliceB = valuesB + stretch.rowB;
+                    const auto [sumSquares, maxAbs] = DiffSlices(sliceA, sliceB, stretch.length);
+                    result.sumSquares += sumSquares;
+                    if (maxAbs > result.maxAbsDiff)
+                    {
+                        std::size_t at = 0;
+                        while (!(std::abs(sliceA[at] - sliceB[at]) == maxAbs)) ++at;
+                        result.maxAbsDiff = maxAbs;
+                        result.timeOfMax = a.timestamps[stretch.rowA + at];
+                    }
+                    if (maxAbs > threshold)// rare by nature: only a stretch with a deviation is walked again
+                    {
+                        for (std::size_t i = 0; i < stretch.length; ++i)
+                        {
+                            if (std::abs(sliceA[i] - sliceB[i]) > threshold)
+                            {
+                                if (exceeded.empty()) exceeded.assign(partial.matched, 0);
+                                exceeded[state + i] = 1;
+                                if (result.exceeded++ < options.maxDeviations)// this field's first ones: their union holds the chunk's first ones
+                                {
+                                    partial.deviations.push_back({ a.timestamps[stretch.rowA + i], field, sliceA[i], sliceB[i] });
+                                }
+                            }
+                        }
+                    }
+                    state += stretch.length;
+                }
+            }
+            partial.statesExceeded = static_cast<std::uint64_t>(std::ranges::count(exceeded, std::uint8_t{ 1 }));
+            std::ranges::sort(partial.deviations, {}, [](const Deviation& deviation) { return std::pair{ deviation.timestamp, deviation.field }; });
+            partial.deviations.resize(std::min(partial.deviations.size(), options.maxDeviations));
+        });
+
+    //4. Merge the chunks in time order.
+    RunComparisonReport report{};
+    report.fields.resize(fieldCount);
+    for (std::size_t field = 0; field < fieldCount; ++field)
+    {
+        report.fields[field].name = field < a.fieldNames.size() ? a.fieldNames[field] : "field" + std::to_string(field);
+    }
+    for (const Partial& partial : partials)
+    {
+        report.matched += partial.matched;
+        report.onlyInA += partial.onlyInA;
+        report.onlyInB += partial.onlyInB;
+        report.statesExceeded += partial.statesExceeded;
+        for (std::size_t field = 0; field < fieldCount; ++field)
+        {
+            const FieldComparison& from = partial.fields[field];
+            FieldComparison& into = report.fields[field];
+            into.sumSquares += from.sumSquares;
+            into.exceeded += from.exceeded;
+            if (from.maxAbsDiff > into.maxAbsDiff)
+            {
+                into.maxAbsDiff = from.maxAbsDiff;
+                into.timeOfMax = from.timeOfMax;
+            }
+        }
+        const std::size_t room = options.maxDeviations - std::min(options.maxDeviations, report.deviations.size());
+        report.deviations.insert(report.deviations.end(), partial.deviations.begin(), partial.deviations.begin() + std::min(room, partial.deviations.size()));
+    }
+    report.onlyInB += onlyInBAfterA;
+    for (FieldComparison& field : report.fields)
+    {
+        field.rmse = report.matched > 0 ? std::sqrt(field.sumSquares / static_cast<double>(report.matched)) : 0.0;
+    }
+    return report;
+}
@@ -0,0 +1,482 @@
+#pragma once
+// Scale-out aggregation: events sharded by source or time range across nodes, each node aggregating its shard into
+// the same AggregateReport a single process computes (count, sum, min, max, mean, variance per source, per type,
+// per source and type), and a coordinator merging the partial reports. Only the partial states cross the network:
+// a few dozen bytes per source and type, whatever the number of events.
+//
+//   // on node i of n, over its own log or its shard of a shared one:
+//   const ShardPlan plan{ ShardKey::Source, n };
+//   std::vector<std::byte> message = EncodePartialAggregate(AggregateShard(store, plan, i));
+//   send(coordinator, message);                                             // any transport: sockets, files, a queue
+//
+//   // on the coordinator:
+//   AggregateCoordinator coordinator{ plan };
+//   for (const std::vector<std::byte>& message : received) coordinator.Receive(message);
+//   const AggregateStats& engine = coordinator.Report().Source(*coordinator.Sources().Find("engine1"));
+//
+// Wire format (little-endian): "ESPPARTL", then LEB128 varints for version, shard, shard key and shard count, for a
+// time plan its fromSec and toSec (64-bit doubles), then varints for event count and entry count; per entry a source
+// name (varint length + bytes), a byte with one bit per EventType present, and per type present its count (varint)
+// and sum, min, max, mean and m2 (64-bit doubles); then an FNV-1a checksum of all of it.
+// Sources are sent by name because SourceIds are local to each node's dictionary; the coordinator re-interns them.
+// The plan travels with every partial: the coordinator rejects shards cut by another key, count or time range.
+// NOTE: merged statistics match a single pass up to floating-point rounding (Chan et al. merges, in arrival order).
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "EventAggregator.h"
+#include "EventColumnStore.h"
+#include "Instrumentation.h"
+#include "SimulationEvent.h"
+#include "SourceDictionary.h"
+
+static_assert(std::endian::native == std::endian::little, "the partial aggregate wire format assumes a little-endian host");
+
+// ** Sharding **
+
+enum class ShardKey : std::uint8_t
+{
+    Source,     // a source always lands on the same node: per-source results are complete on one node
+    Time        // fromSec..toSec cut into equal ranges: each node holds one stretch of the log
+};
+
+struct ShardPlan
+{
+    ShardKey key{ ShardKey::Source };
+    std::size_t shardCount{ 1 };
+    double fromSec{};           // ShardKey::Time: times before fromSec go to shard 0, from toSec on to the last one
+    double toSec{};
+};
+
+// FNV-1a of the name: unlike std::hash, the same on every node, build and platform.
+inline std::uint64_t StableSourceHash(std::string_view name)
+{
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    for (char c : name)
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+inline std::size_t SourceShard(const ShardPlan& plan, std::string_view source)
+{
+    return static_cast<std::size_t>(StableSourceHash(source) % plan.shardCount);
+}
+
+inline std::size_t TimeShard(const ShardPlan& plan, double timestampSec)
+{
+    const double position = (timestampSec - plan.fromSec) / (plan.toSec - plan.fromSec) * static_cast<double>(plan.shardCount);
+    if (!(position > 0.0))
+    {
+        return 0;// before fromSec, or NaN
+    }
+    return std::min(static_cast<std::size_t>(position), plan.shardCount - 1);
+}
+
+// Whether shards of a and b partition the events the same way (the time range only matters to time plans).
+inline bool SameShardPlan(const ShardPlan& a, const ShardPlan& b)
+{
+    return a.key == b.key && a.shardCount == b.shardCount && (a.key != ShardKey::Time || (a.fromSec == b.fromSec && a.toSec == b.toSec));
+}
+
+inline std::string DescribeShardPlan(const ShardPlan& plan)
+{
+    std::string text = std::to_string(plan.shardCount) + (plan.key == ShardKey::Source ? " source shards" : " time shards");
+    if (plan.key == ShardKey::Time)
+    {
+        text += " of [" + std::to_string(plan.fromSec) + ", " + std::to_string(plan.toSec) + ")";
+    }
+    return text;
+}
+
+inline void CheckShardPlan(const ShardPlan& plan)
+{
+    if (plan.shardCount == 0)
+    {
+        throw std::invalid_argument("ShardPlan: shardCount must be at least 1");
+    }
+    if (plan.key == ShardKey::Time && !(plan.toSec > plan.fromSec))
+    {
+        throw std::invalid_argument("ShardPlan: a time shard plan needs toSec > fromSec");
+    }
+}
+
+// The rows of store that belong to shard, in row order.
+inline std::vector<EventIndex> SelectShard(const EventColumnStore& store, const ShardPlan& plan, std::size_t shard)
+{
+    CheckShardPlan(plan);
+    ESP_TIME_OPERATION("select_shard", store.Size());
+    std::vector<EventIndex> rows{};
+    if (plan.key == ShardKey::Source)
+    {
+        std::vector<std::uint8_t> mine(store.SourceCount());
+        for (SourceId id = 0; id < mine.size(); ++id)
+        {
+            mine[id] = SourceShard(plan, store.SourceName(id)) == shard;
+        }
+        auto sourceIds = store.SourceIds();
+        for (std::size_t row = 0; row < sourceIds.size(); ++row)
+        {
+            if (mine[sourceIds[row]]) rows.push_back(static_cast<EventIndex>(row));
+        }
+        return rows;
+    }
+    auto timestamps = store.Timestamps();
+    for (std::size_t row = 0; row < timestamps.size(); ++row)
+    {
+        if (TimeShard(plan, timestamps[row]) == shard) rows.push_back(static_cast<EventIndex>(row));
+    }
+    return rows;
+}
+
+// ** Partial states **
+
+// One node's share of the answer: its report, indexed by the node's own SourceIds, and the names of those ids.
+struct PartialAggregate
+{
+    std::uint32_t shard{};
+    ShardPlan plan{};                   // the plan shard belongs to
+    std::uint64_t events{};
+    AggregateReport report{};
+    std::vector<std::string> sourceNames{};
+};
+
+inline PartialAggregate MakePartialAggregate(const EventColumnStore& store, AggregateReport report, std::size_t shard, const ShardPlan& plan)
+{
+    CheckShardPlan(plan);
+    return { static_cast<std::uint32_t>(shard), plan, report.overall.count, std::move(report), store.Sources().Names() };
+}
+
+// The partial state of the rows in store that belong to shard (a node's share of a log every node can read).
+inline PartialAggregate AggregateShard(const EventColumnStore& store, const ShardPlan& plan, std::size_t shard)
+{
+    const std::vector<EventIndex> rows = SelectShard(store, plan, shard);
+    ESP_TIME_OPERATION("aggregate_shard", rows.size());
+    AggregateReport report{};
+    report.bySource.resize(store.SourceCount());
+    report.bySourceAndType.resize(store.SourceCount() * EventTypeCount);
+    auto types = store.Types();
+    auto sourceIds = store.SourceIds();
+    auto values = store.Values();
+    for (EventIndex row : rows)
+    {
+        report.Add(types[row], sourceIds[row], values[row]);
+    }
+    return MakePartialAggregate(store, std::move(report), shard, plan);
+}
+
+// ** Wire format **
+
+inline constexpr char PartialAggregateMagic[8] = { 'E', 'S', 'P', 'P', 'A', 'R', 'T', 'L' };
+inline constexpr std::uint64_t PartialAggregateVersion = 2;// 2: the shard plan's key and time range
+
+class WireWriter
+{
+public:
+    void Bytes(const void* data, std::size_t size)
+    {
+        const auto* bytes = static_cast<const std::byte*>(data);
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+
+    void Varint(std::uint64_t value)
+    {
+        for (; value >= 0x80; value >>= 7)
+        {
+            buffer.push_back(static_cast<std::byte>(value | 0x80));
+        }
+        buffer.push_back(static_cast<std::byte>(value));
+    }
+
+    void Double(double value) { Bytes(&value, sizeof(value)); }
+
+    std::vector<std::byte> Take() { return std::move(buffer); }
+    std::span<const std::byte> Written() const { return buffer; }
+
+private:
+    std::vector<std::byte> buffer{};
+};
+
+// Every read checks the bounds: a truncated or corrupt message throws instead of reading past its end.
+class WireReader
+{
+public:
+    explicit WireReader(std::span<const std::byte> bytes) : bytes{ bytes } {}
+
+    std::span<const std::byte> Bytes(std::size_t size)
+    {
+        if (size > bytes.size() - at)
+        {
+            throw std::runtime_error("DecodePartialAggregate: truncated message");
+        }
+        const std::span<const std::byte> taken = bytes.subspan(at, size);
+        at += size;
+        return taken;
+    }
+
+    std::uint64_t Varint()
+    {
+        std::uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7)
+        {
+            const auto byte = std::to_integer<std::uint64_t>(Bytes(1)[0]);
+            value |= (byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+            {
+                return value;
+            }
+        }
+        throw std::runtime_error("DecodePartialAggregate: malformed varint");
+    }
+
+    double Double()
+    {
+        double value{};
+        std::memcpy(&value, Bytes(sizeof(value)).data(), sizeof(value));
+        return value;
+    }
+
+    std::size_t Remaining() const { return bytes.size() - at; }
+
+private:
+    std::span<const std::byte> bytes;
+    std::size_t at{};
+};
+
+inline std::uint64_t WireChecksum(std::span<const std::byte> bytes)
+{
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    for (std::byte byte : bytes)
+    {
+        hash = (hash ^ std::to_integer<std::uint64_t>(byte)) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Sources without events are left out; per source only the types it has.
+inline std::vector<std::byte> EncodePartialAggregate(const PartialAggregate& partial)
+{
+    ESP_TIME_OPERATION("encode_partial", partial.events);
+    const AggregateReport& report = partial.report;
+    std::size_t entries = 0;
+    for (std::size_t id = 0; id < report.bySource.size(); ++id)
+    {
+        entries += !report.bySource[id].Empty();
+    }
+
+    WireWriter writer{};
+    writer.Bytes(PartialAggregateMagic, sizeof(PartialAggregateMagic));
+    writer.Varint(PartialAggregateVersion);
+    writer.Varint(partial.shard);
+    writer.Varint(static_cast<std::uint64_t>(partial.plan.key));
+    writer.Varint(partial.plan.shardCount);
+    if (partial.plan.key == ShardKey::Time)
+    {
+        writer.Double(partial.plan.fromSec);
+        writer.Double(partial.plan.toSec);
+    }
+    writer.Varint(partial.events);
+    writer.Varint(entries);
+    for (SourceId id = 0; id < report.bySource.size(); ++id)
+    {
+        if (report.bySource[id].Empty())
+        {
+            continue;
+        }
+        const std::string& name = partial.sourceNames.at(id);
+        writer.Varint(name.size());
+        writer.Bytes(name.data(), name.size());
+        std::uint8_t present = 0;
+        for (std::size_t slot = 0; slot < EventTypeCount; ++slot)
+        {
+            present |= static_cast<std::uint8_t>(!report.bySourceAndType[id * EventTypeCount + slot].Empty() << slot);
+        }
+        writer.Bytes(&present, 1);
+        for (std::size_t slot = 0; slot < EventTypeCount; ++slot)
+        {
+            const AggregateStats& stats = report.bySourceAndType[id * EventTypeCount + slot];
+            if (stats.Empty())
+            {
+                continue;
+            }
+            writer.Varint(stats.count);
+            for (double field : { stats.sum, stats.min, stats.max, stats.mean, stats.m2 })
+            {
+                writer.Double(field);
+            }
+        }
+    }
+    const std::uint64_t checksum = WireChecksum(writer.Written());
+    writer.Bytes(&checksum, sizeof(checksum));
+    ESP_COUNT_BYTES("encode_partial", writer.Written().size());
+    return writer.Take();
+}
+
+// The per-source, per-type and overall statistics are rebuilt by merging the per-source-and-type cells.
+inline PartialAggregate DecodePartialAggregate(std::span<const std::byte> message)
+{
+    ESP_TIME_OPERATION("decode_partial", 0);
+    if (message.size() < sizeof(PartialAggregateMagic) + sizeof(std::uint64_t))
+    {
+        throw std::runtime_error("DecodePartialAggregate: truncated message");
+    }
+    const std::span<const std::byte> body = message.first(message.size() - sizeof(std::uint64_t));
+    std::uint64_t checksum{};
+    std::memcpy(&checksum, message.data() + body.size(), sizeof(checksum));
+    if (std::memcmp(body.data(), PartialAggregateMagic, sizeof(PartialAggregateMagic)) != 0)
+    {
+        throw std::runtime_error("DecodePartialAggregate: not a partial aggregate");
+    }
+    if (WireChecksum(body) != checksum)
+    {
+        throw std::runtime_error("DecodePartialAggregate: checksum mismatch");
+    }
+
+    WireReader reader{ body };
+    reader.Bytes(sizeof(PartialAggregateMagic));
+    if (reader.Varint() != PartialAggregateVersion)
+    {
+        throw std::runtime_error("DecodePartialAggregate: unsupported version");
+    }
+    PartialAggregate partial{};
+    partial.shard = static_cast<std::uint32_t>(reader.Varint());
+    const std::uint64_t key = reader.Varint();
+    if (key > static_cast<std::uint64_t>(ShardKey::Time))
+    {
+        throw std::runtime_error("DecodePartialAggregate: unknown shard key");
+    }
+    partial.plan.key = static_cast<ShardKey>(key);
+    partial.plan.shardCount = static_cast<std::size_t>(reader.Varint());
+    if (partial.plan.key == ShardKey::Time)
+    {
+        partial.plan.fromSec = reader.Double();
+        partial.plan.toSec = reader.Double();
+    }
+    partial.events = reader.Varint();
+    const std::uint64_t entries = reader.Varint();
+    const bool validPlan = partial.plan.key != ShardKey::Time || partial.plan.toSec > partial.plan.fromSec;
+    if (!validPlan || partial.shard >= partial.plan.shardCount || entries > reader.Remaining())// every entry takes at least one byte
+    {
+        throw std::runtime_error("DecodePartialAggregate: corrupt header");
+    }
+
+    AggregateReport& report = partial.report;
+    report.bySource.resize(static_cast<std::size_t>(entries));
+    report.bySourceAndType.resize(static_cast<std::size_t>(entries) * EventTypeCount);
+    for (SourceId id = 0; id < entries; ++id)
+    {
+        const std::span<const std::byte> name = reader.Bytes(static_cast<std::size_t>(reader.Varint()));
+        partial.sourceNames.emplace_back(reinterpret_cast<const char*>(name.data()), name.size());
+        const auto present = std::to_integer<std::uint8_t>(reader.Bytes(1)[0]);
+        for (std::size_t slot = 0; slot < EventTypeCount; ++slot)
+        {
+            if (!((present >> slot) & 1))
+            {
+                continue;
+            }
+            AggregateStats stats{};
+            stats.count = reader.Varint();
+            stats.sum = reader.Double();
+            stats.min = reader.Double();
+            stats.max = reader.Double();
+            stats.mean = reader.Double();
+            stats.m2 = reader.Double();
+            report.bySourceAndType[id * EventTypeCount + slot] = stats;
+            report.bySource[id].Merge(stats);
+            report.byType[slot].Merge(stats);
+            report.overall.Merge(stats);
+        }
+    }
+    if (reader.Remaining() != 0)
+    {
+        throw std::runtime_error("DecodePartialAggregate: trailing bytes");
+    }
+    return partial;
+}
+
+// ** Coordinator **
+
+// Merges partial states from the shards of one query, as they arrive, into one report over its own dictionary.
+// NOTE: not thread-safe; a server receiving on several connections serializes Receive() calls.
+class AggregateCoordinator
+{
+public:
+    explicit AggregateCoordinator(const ShardPlan& plan, std::shared_ptr<SourceDictionary> dictionary = std::make_shared<SourceDictionary>())
+        : plan{ plan }, sources{ std::move(dictionary) }, received(plan.shardCount)
+    {
+        CheckShardPlan(plan);
+    }
+
+    void Receive(std::span<const std::byte> message) { Merge(DecodePartialAggregate(message)); }
+
+    // Throws std::invalid_argument for a shard of another plan (another key, count or time range: events would count
+    // twice or not at all) or one merged already (it would count twice).
+    void Merge(const PartialAggregate& partial)
+    {
+        if (!SameShardPlan(partial.plan, plan) || partial.shard >= received.size())
+        {
+            throw std::invalid_argument("AggregateCoordinator: shard " + std::to_string(partial.shard) + " of " + DescribeShardPlan(partial.plan)
+                + " does not belong to the plan of " + DescribeShardPlan(plan));
+        }
+        if (received[partial.shard])
+        {
+            throw std::invalid_argument("AggregateCoordinator: shard " + std::to_string(partial.shard) + " received twice");
+        }
+        ESP_TIME_OPERATION("merge_partial", partial.events);
+
+        // Remap the node's ids onto the coordinator's dictionary, then merge like any two reports.
+        AggregateReport remapped{};
+        for (SourceId id = 0; id < partial.report.bySource.size(); ++id)
+        {
+            if (partial.report.bySource[id].Empty())
+            {
+                continue;
+            }
+            const SourceId global = sources->Intern(partial.sourceNames.at(id));
+            if (global >= remapped.bySource.size())
+            {
+                remapped.bySource.resize(global + 1);
+                remapped.bySourceAndType.resize((global + 1) * EventTypeCount);
+            }
+            remapped.bySource[global] = partial.report.bySource[id];
+            std::copy_n(partial.report.bySourceAndType.begin() + id * EventTypeCount, EventTypeCount, remapped.bySourceAndType.begin() + global * EventTypeCount);
+        }
+        remapped.byType = partial.report.byType;
+        remapped.overall = partial.report.overall;
+        report.Merge(remapped);
+
+        received[partial.shard] = true;
+        ++shardsReceived;
+        events += partial.events;
+    }
+
+    // Indexed by the coordinator's SourceIds (Sources()).
+    const AggregateReport& Report() const { return report; }
+    const SourceDictionary& Sources() const { return *sources; }
+    const std::shared_ptr<SourceDictionary>& SharedSources() const { return sources; }
+
+    const ShardPlan& Plan() const { return plan; }
+    std::size_t ShardCount() const { return received.size(); }
+    std::size_t ShardsReceived() const { return shardsReceived; }
+    bool Complete() const { return shardsReceived == received.size(); }
+    std::uint64_t Events() const { return events; }
+
+private:
+    ShardPlan plan;
+    std::shared_ptr<SourceDictionary> sources;
+    std::vector<bool> received;
+    std::size_t shardsReceived{};
+    std::uint64_t events{};
+    AggregateReport report{};
+};
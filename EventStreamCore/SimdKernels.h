@@ -0,0 +1,266 @@
+#pragma once
+// SIMD filter and sum kernels over the EventColumnStore columns.
+// A predicate is evaluated into a bitmask (one bit per row, 64 rows per word), and the mask then drives
+// either a masked sum over the value column or a selection vector of matching row numbers.
+// The ISA is picked at compile time: AVX-512 (/arch:AVX512, -mavx512f -mavx512bw), AVX2 (/arch:AVX2, -mavx2),
+// otherwise the branchless scalar loops, which compilers can still auto-vectorize.
+// NOTE: the vector sums add in a different order than a plain loop, so totals can differ from std::accumulate in the last bits.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+#define EVENT_SIMD_AVX512 1
+#include <immintrin.h>
+#elif defined(__AVX2__)
+#define EVENT_SIMD_AVX2 1
+#include <immintrin.h>
+#endif
+
+#include "SimulationEvent.h"
+#include "SourceDictionary.h"
+
+#if defined(EVENT_SIMD_AVX512)
+inline constexpr const char* SimdKernelIsa = "AVX-512";
+#elif defined(EVENT_SIMD_AVX2)
+inline constexpr const char* SimdKernelIsa = "AVX2";
+#else
+inline constexpr const char* SimdKernelIsa = "scalar";
+#endif
+
+inline constexpr std::size_t MaskWordCount(std::size_t rows) { return (rows + 63) / 64; }
+
+// Scalar mask builder for rows [begin, rows); begin is always a multiple of 64. Bits past the last row stay 0.
+template <typename T>
+void MatchMaskScalar(const T* data, std::size_t begin, std::size_t rows, T key, std::uint64_t* mask)
+{
+    for (std::size_t base = begin; base < rows; base += 64)
+    {
+        const std::size_t count = std::min<std::size_t>(64, rows - base);
+        std::uint64_t bits = 0;
+        for (std::size_t j = 0; j < count; ++j)
+        {
+            bits |= std::uint64_t{ data[base + j] == key } << j;
+        }
+        mask[base / 64] = bits;
+    }
+}
+
+//1. Predicate -> bitmask. mask must hold MaskWordCount(types.size()) words.
+inline void MatchTypeMask(std::span<const EventType> types, EventType key, std::span<std::uint64_t> mask)
+{
+    const auto* data = reinterpret_cast<const std::uint8_t*>(types.data());// EventType is a one-byte enum
+    const auto needle = static_cast<std::uint8_t>(key);
+    const std::size_t rows = types.size();
+    std::size_t row = 0;
+
+#if defined(EVENT_SIMD_AVX512)
+    const __m512i keys = _mm512_set1_epi8(static_cast<char>(needle));
+    for (; row + 64 <= rows; row += 64)
+    {
+        mask[row / 64] = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(data + row), keys);
+    }
+#elif defined(EVENT_SIMD_AVX2)
+    const __m256i keys = _mm256_set1_epi8(static_cast<char>(needle));
+    for (; row + 64 <= rows; row += 64)
+    {
+        const auto lo = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + row)), keys)));
+        const auto hi = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + row + 32)), keys)));
+        mask[row / 64] = lo | (std::uint64_t{ hi } << 32);
+    }
+#endif
+    MatchMaskScalar(data, row, rows, needle, mask.data());
+}
+
+inline void MatchSourceMask(std::span<const SourceId> sourceIds, SourceId key, std::span<std::uint64_t> mask)
+{
+    const SourceId* data = sourceIds.data();
+    const std::size_t rows = sourceIds.size();
+    std::size_t row = 0;
+
+#if defined(EVENT_SIMD_AVX512)
+    const __m512i keys = _mm512_set1_epi32(static_cast<int>(key));
+    for (; row + 64 <= rows; row += 64)
+    {
+        std::uint64_t bits = 0;
+        for (int lane = 0; lane < 4; ++lane)// 4 x 16 ids per mask word
+        {
+            const __mmask16 hits = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(data + row + lane * 16), keys);
+            bits |= std::uint64_t{ hits } << (lane * 16);
+        }
+        mask[row / 64] = bits;
+    }
+#elif defined(EVENT_SIMD_AVX2)
+    const __m256i keys = _mm256_set1_epi32(static_cast<int>(key));
+    for (; row + 64 <= rows; row += 64)
+    {
+        std::uint64_t bits = 0;
+        for (int lane = 0; lane < 8; ++lane)// 8 x 8 ids per mask word
+        {
+            const __m256i hits = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + row + lane * 8)), keys);
+            bits |= std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(hits)))) << (lane * 8);
+        }
+        mask[row / 64] = bits;
+    }
+#endif
+    MatchMaskScalar(data, row, rows, key, mask.data());
+}
+
+//2. Masked sum: adds values[row] for every set bit. Words that are all zero are skipped outright.
+inline double MaskedSum(std::span<const double> values, std::span<const std::uint64_t> mask)
+{
+    const double* data = values.data();
+    const std::size_t rows = values.size();
+    const std::size_t fullWords = rows / 64;
+    double sum = 0.0;
+
+#if defined(EVENT_SIMD_AVX512)
+    __m512d acc = _mm512_setzero_pd();
+    for (std::size_t word = 0; word < fullWords; ++word)
+    {
+        const std::uint64_t bits = mask[word];
+        if (bits == 0) continue;
+        for (int lane = 0; lane < 8; ++lane)
+        {
+            const auto laneMask = static_cast<__mmask8>(bits >> (lane * 8));
+            acc = _mm512_mask_add_pd(acc, laneMask, acc, _mm512_loadu_pd(data + word * 64 + lane * 8));
+        }
+    }
+    sum = _mm512_reduce_add_pd(acc);
+#elif defined(EVENT_SIMD_AVX2)
+    const __m256i bitSelect = _mm256_setr_epi64x(1, 2, 4, 8);
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();// two accumulators to hide the add latency
+    for (std::size_t word = 0; word < fullWords; ++word)
+    {
+        const std::uint64_t bits = mask[word];
+        if (bits == 0) continue;
+        for (int lane = 0; lane < 16; lane += 2)
+        {
+            const __m256i nibble0 = _mm256_set1_epi64x(static_cast<long long>((bits >> (lane * 4)) & 0xF));
+            const __m256i nibble1 = _mm256_set1_epi64x(static_cast<long long>((bits >> (lane * 4 + 4)) & 0xF));
+            const __m256d keep0 = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(nibble0, bitSelect), bitSelect));
+            const __m256d keep1 = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(nibble1, bitSelect), bitSelect));
+            acc0 = _mm256_add_pd(acc0, _mm256_and_pd(keep0, _mm256_loadu_pd(data + word * 64 + lane * 4)));
+            acc1 = _mm256_add_pd(acc1, _mm256_and_pd(keep1, _mm256_loadu_pd(data + word * 64 + lane * 4 + 4)));
+        }
+    }
+    alignas(32) std::array<double, 4> lanes{};
+    _mm256_store_pd(lanes.data(), _mm256_add_pd(acc0, acc1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+    for (std::size_t word = 0; word < fullWords; ++word)
+    {
+        const std::uint64_t bits = mask[word];
+        if (bits == 0) continue;
+        for (std::size_t j = 0; j < 64; ++j)
+        {
+            sum += ((bits >> j) & 1) ? data[word * 64 + j] : 0.0;// select, not a branch
+        }
+    }
+#endif
+
+    for (std::size_t row = fullWords * 64; row < rows; ++row)
+    {
+        sum += ((mask[row / 64] >> (row % 64)) & 1) ? data[row] : 0.0;
+    }
+    return sum;
+}
+
+//3. Selection vector: appends baseRow + position of every set bit, in ascending order.
+// Selection is any vector of EventIndex, e.g. a std::pmr::vector drawing from a QueryArena.
+template <typename Selection>
+void AppendSelection(std::span<const std::uint64_t> mask, EventIndex baseRow, Selection& selection)
+{
+    std::size_t hits = 0;
+    for (std::uint64_t bits : mask)
+    {
+        hits += static_cast<std::size_t>(std::popcount(bits));
+    }
+
+    std::size_t out = selection.size();
+    selection.resize(out + hits);
+    for (std::size_t word = 0; word < mask.size(); ++word)
+    {
+        for (std::uint64_t bits = mask[word]; bits != 0; bits &= bits - 1)// clear lowest set bit each step
+        {
+            selection[out++] = baseRow + static_cast<EventIndex>(word * 64 + static_cast<std::size_t>(std::countr_zero(bits)));
+        }
+    }
+}
+
+// ** Fused column kernels **
+// Work in chunks of KernelChunkRows so the mask stays in L1 no matter how large the column is.
+inline constexpr std::size_t KernelChunkRows = 4096;
+
+template <typename Selection>
+void SelectByType(std::span<const EventType> types, EventType key, Selection& selection, EventIndex firstRow = 0)// types starts at row firstRow
+{
+    std::array<std::uint64_t, MaskWordCount(KernelChunkRows)> mask{};
+    for (std::size_t begin = 0; begin < types.size(); begin += KernelChunkRows)
+    {
+        const std::size_t count = std::min(KernelChunkRows, types.size() - begin);
+        const std::span<std::uint64_t> words{ mask.data(), MaskWordCount(count) };
+        MatchTypeMask(types.subspan(begin, count), key, words);
+        AppendSelection(words, static_cast<EventIndex>(firstRow + begin), selection);
+    }
+}
+
+template <typename Selection>
+void SelectBySource(std::span<const SourceId> sourceIds, SourceId key, Selection& selection, EventIndex firstRow = 0)// sourceIds starts at row firstRow
+{
+    std::array<std::uint64_t, MaskWordCount(KernelChunkRows)> mask{};
+    for (std::size_t begin = 0; begin < sourceIds.size(); begin += KernelChunkRows)
+    {
+        const std::size_t count = std::min(KernelChunkRows, sourceIds.size() - begin);
+        const std::span<std::uint64_t> words{ mask.data(), MaskWordCount(count) };
+        MatchSourceMask(sourceIds.subspan(begin, count), key, words);
+        AppendSelection(words, static_cast<EventIndex>(firstRow + begin), selection);
+    }
+}
+
+inline std::vector<EventIndex> SelectByType(std::span<const EventType> types, EventType key)
+{
+    std::vector<EventIndex> selection{};
+    SelectByType(types, key, selection);
+    return selection;
+}
+
+inline std::vector<EventIndex> SelectBySource(std::span<const SourceId> sourceIds, SourceId key)
+{
+    std::vector<EventIndex> selection{};
+    SelectBySource(sourceIds, key, selection);
+    return selection;
+}
+
+inline double SumWhereType(std::span<const EventType> types, std::span<const double> values, EventType key)
+{
+    double sum = 0.0;
+    std::array<std::uint64_t, MaskWordCount(KernelChunkRows)> mask{};
+    for (std::size_t begin = 0; begin < values.size(); begin += KernelChunkRows)
+    {
+        const std::size_t count = std::min(KernelChunkRows, values.size() - begin);
+        const std::span<std::uint64_t> words{ mask.data(), MaskWordCount(count) };
+        MatchTypeMask(types.subspan(begin, count), key, words);
+        sum += MaskedSum(values.subspan(begin, count), words);
+    }
+    return sum;
+}
+
+inline double SumWhereSource(std::span<const SourceId> sourceIds, std::span<const double> values, SourceId key)
+{
+    double sum = 0.0;
+    std::array<std::uint64_t, MaskWordCount(KernelChunkRows)> mask{};
+    for (std::size_t begin = 0; begin < values.size(); begin += KernelChunkRows)
+    {
+        const std::size_t count = std::min(KernelChunkRows, values.size() - begin);
+        const std::span<std::uint64_t> words{ mask.data(), MaskWordCount(count) };
+        MatchSourceMask(sourceIds.subspan(begin, count), key, words);
+        sum += MaskedSum(values.subspan(begin, count), words);
+    }
+    return sum;
+}
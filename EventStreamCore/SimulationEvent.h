@@ -0,0 +1,72 @@
+#pragma once
+// Event model shared by the GUI demo and the processing engines.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class EventType : std::uint8_t // one byte, so a column of types packs 64 per cache line
+{
+    SENSOR_READING,
+    CONTROL_INPUT,
+    ACTUATOR_COMMAND//2
+};
+inline constexpr std::size_t EventTypeCount = 3;// keep in sync with EventType; used to size per-type arrays
+
+using EventIndex = std::uint32_t; // row number inside an EventColumnStore (or position in an event vector)
+
+inline std::string EventTypeToString(EventType type) {
+    switch (type) {
+    case EventType::SENSOR_READING: return "SENSOR_READING";
+    case EventType::CONTROL_INPUT: return "CONTROL_INPUT";
+    case EventType::ACTUATOR_COMMAND: return "ACTUATOR_COMMAND";
+    default: return "UNKNOWN";
+    }
+}
+
+inline constexpr std::array<std::string_view, EventTypeCount> EventTypeNames{ "SENSOR_READING", "CONTROL_INPUT", "ACTUATOR_COMMAND" };// indexed by the enum value
+
+// Reverse of EventTypeToString, compares views so parsing never builds a temporary std::string.
+// Also takes the numeric form ("0", "1", "2") that PrintEvents writes.
+inline std::optional<EventType> EventTypeFromString(std::string_view name)
+{
+    for (std::size_t slot = 0; slot < EventTypeNames.size(); ++slot)
+    {
+        if (name == EventTypeNames[slot])
+        {
+            return static_cast<EventType>(slot);
+        }
+    }
+    if (name.size() == 1 && name[0] >= '0' && static_cast<std::size_t>(name[0] - '0') < EventTypeCount)
+    {
+        return static_cast<EventType>(name[0] - '0');
+    }
+    return std::nullopt;
+}
+
+struct SimulationEvent
+{
+    double timestampSec{};        // Time in seconds since simulation start
+    EventType type{};             // What kind of event this is
+    std::string source{};         // e.g., "engine1", "rudder", etc.
+    double value{};               // A context-dependent value (e.g., throttle %, altitude)
+
+    void ConstructMockingSimulationEventVector(std::vector<SimulationEvent>& events)// Mocking a vector of SimulationEvent for testing purposes
+    {
+        events.push_back({ 5.0, EventType::ACTUATOR_COMMAND, "flaps", 15.0 });
+        events.push_back({1.5, EventType::CONTROL_INPUT, "pilot", 75.0});
+        events.push_back({ 10.5, EventType::CONTROL_INPUT, "pilot", 85.0 });
+        events.push_back({ 0.0, EventType::SENSOR_READING, "engine1", 100.0 });
+        events.push_back({3.2, EventType::SENSOR_READING, "altimeter", 5000.0});
+        events.push_back({4.5, EventType::CONTROL_INPUT, "pilot", 80.0});
+        events.push_back({ 9.2, EventType::SENSOR_READING, "altimeter", 6000.0 });
+        events.push_back({ 2.0, EventType::ACTUATOR_COMMAND, "rudder", 30.0 });
+        events.push_back({ 6.0, EventType::SENSOR_READING, "engine2", 110.0 });
+        events.push_back({ 7.5, EventType::CONTROL_INPUT, "pilot", 70.0 });
+        events.push_back({ 8.0, EventType::ACTUATOR_COMMAND, "aileron", 20.0 });
+	}
+};
@@ -0,0 +1,45 @@
+#pragma once
+// Interns source names ("engine1", "rudder", "flaps", ...) into dense 32-bit ids.
+// A log only has a few hundred distinct sources, so per-event work can compare/hash a SourceId
+// instead of a std::string, and anything grouped by source can be a flat array indexed by id.
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "FlatHashMap.h"
+
+using SourceId = std::uint32_t;
+
+class SourceDictionary
+{
+public:
+    // Returns the id of name, assigning the next dense id the first time it is seen. Ids never change once assigned.
+    SourceId Intern(std::string_view name)
+    {
+        if (const SourceId* known = lookup.Find(name))// heterogeneous find: no temporary std::string for known names
+        {
+            return *known;
+        }
+        const auto id = static_cast<SourceId>(names.size());
+        names.emplace_back(name);
+        lookup.TryEmplace(names.back(), id);
+        return id;
+    }
+
+    std::optional<SourceId> Find(std::string_view name) const
+    {
+        const SourceId* known = lookup.Find(name);
+        return known ? std::optional<SourceId>{ *known } : std::nullopt;
+    }
+
+    const std::string& Name(SourceId id) const { return names[id]; }
+    std::size_t Size() const { return names.size(); }
+    const std::vector<std::string>& Names() const { return names; }// index == id
+
+private:
+    std::vector<std::string> names{};           // id -> name
+    FlatStringMap<SourceId> lookup{};           // name -> id
+};
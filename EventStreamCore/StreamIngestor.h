@@ -0,0 +1,138 @@
+#pragma once
+// Incremental, append-only ingestion that keeps the stream in time order.
+// Events arrive almost sorted with small jitter, so instead of re-sorting the whole vector on every query
+// they pass through a bounded reorder buffer (a min-heap on timestamp): O(log k) per event for a buffer of k.
+// An event is released to the output store once the buffer is full or it is older than maxDelaySec behind the
+// newest arrival, so the output is always sorted. An event that shows up after a later one was already released
+// is LATE: it is counted and kept aside in lateEvents, never appended out of order. An event with a NaN timestamp
+// orders against nothing (it would break the heap): it is counted as untimed and kept aside in untimedEvents.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "EventColumnStore.h"
+#include "SimulationEvent.h"
+
+struct ReorderOptions
+{
+    std::size_t capacity{ 4096 };                                     // max events held back for reordering
+    double maxDelaySec{ std::numeric_limits<double>::infinity() };    // release anything this far behind the newest arrival
+};
+
+struct IngestStats
+{
+    std::uint64_t received{};
+    std::uint64_t released{};       // appended to the output store, in order
+    std::uint64_t reordered{};      // arrived out of order but the buffer put them back in place
+    std::uint64_t late{};           // arrived behind the watermark, see StreamIngestor::LateEvents()
+    std::uint64_t untimed{};        // NaN timestamp, see StreamIngestor::UntimedEvents()
+    double maxLatenessSec{};        // worst watermark - timestamp seen among the late events
+};
+
+struct BufferedEvent
+{
+    double timestampSec{};
+    std::uint64_t sequence{};       // arrival number, keeps equal timestamps in arrival order
+    EventType type{};
+    SourceId sourceId{};
+    double value{};
+
+    // Never called with a NaN timestamp: StreamIngestor sets those aside before they reach the heap.
+    friend bool operator>(const BufferedEvent& a, const BufferedEvent& b)
+    {
+        return a.timestampSec != b.timestampSec ? a.timestampSec > b.timestampSec : a.sequence > b.sequence;
+    }
+};
+
+class StreamIngestor
+{
+public:
+    explicit StreamIngestor(EventColumnStore& output, ReorderOptions options = {})
+        : output{ output }, options{ options }
+    {
+    }
+
+    void Ingest(const SimulationEvent& event)
+    {
+        Ingest(event.timestampSec, event.type, output.InternSource(event.source), event.value);
+    }
+
+    void Ingest(double timestampSec, EventType type, SourceId sourceId, double value)
+    {
+        ++stats.received;
+        BufferedEvent event{ timestampSec, nextSequence++, type, sourceId, value };
+
+        if (std::isnan(timestampSec))
+        {
+            ++stats.untimed;
+            untimedEvents.push_back(event);
+            return;
+        }
+
+        if (stats.released > 0 && timestampSec < watermark)
+        {
+            ++stats.late;
+            stats.maxLatenessSec = std::max(stats.maxLatenessSec, watermark - timestampSec);
+            lateEvents.push_back(event);
+            return;
+        }
+
+        if (timestampSec < newestSec)
+        {
+            ++stats.reordered;
+        }
+        newestSec = std::max(newestSec, timestampSec);
+        pending.push(event);
+
+        while (!pending.empty() && (pending.size() > options.capacity || pending.top().timestampSec <= newestSec - options.maxDelaySec))
+        {
+            ReleaseOldest();
+        }
+    }
+
+    // Releases everything still buffered, e.g. at end of stream or before a query that must see every event.
+    void Flush()
+    {
+        while (!pending.empty())
+        {
+            ReleaseOldest();
+        }
+    }
+
+    const IngestStats& Stats() const { return stats; }
+    std::size_t Pending() const { return pending.size(); }
+    double Watermark() const { return watermark; }// timestamp of the last released event
+
+    const std::vector<BufferedEvent>& LateEvents() const { return lateEvents; }
+    std::vector<BufferedEvent> TakeLateEvents() { return std::exchange(lateEvents, {}); }
+
+    const std::vector<BufferedEvent>& UntimedEvents() const { return untimedEvents; }
+    std::vector<BufferedEvent> TakeUntimedEvents() { return std::exchange(untimedEvents, {}); }
+
+private:
+    void ReleaseOldest()
+    {
+        const BufferedEvent& oldest = pending.top();
+        output.Append(oldest.timestampSec, oldest.type, oldest.sourceId, oldest.value);
+        watermark = oldest.timestampSec;
+        ++stats.released;
+        pending.pop();
+    }
+
+    EventColumnStore& output;
+    ReorderOptions options{};
+    IngestStats stats{};
+
+    std::priority_queue<BufferedEvent, std::vector<BufferedEvent>, std::greater<>> pending{};// min-heap: top() is the oldest
+    std::vector<BufferedEvent> lateEvents{};
+    std::vector<BufferedEvent> untimedEvents{};
+    std::uint64_t nextSequence{};
+    double newestSec{ -std::numeric_limits<double>::infinity() };
+    double watermark{ -std::numeric_limits<double>::infinity() };
+};
@@ -0,0 +1,378 @@
+#pragma once
+// K-way merge of time-sorted streams into one time-ordered stream: GPS + IMU, or dozens of per-source streams.
+// A loser tree (a tournament tree that keeps the loser of every match) holds the head timestamp of each input. The
+// winner is the earliest event; taking it replays only that input's path to the root, log2(k) comparisons per event,
+// instead of concatenating the streams and sorting n events again. Equal timestamps come out in input order.
+// A NaN timestamp orders against nothing: such an event leaves as soon as it heads its input, like an out-of-order one.
+// The merged stream leaves in batches of PipelineBatchRows, so it feeds a Pipeline or a WindowOperator directly.
+//
+//   MergeSortedRuns(store, runs, pipeline);          // time-sorted row lists of one store: rows only, nothing copied
+//
+//   const EventColumnStore* streams[]{ &gps, &imu };
+//   PushMerged(streams, pipeline);                   // whole stores, each read a batch at a time as the merge needs it
+//
+//   StreamMerger merger{ 2, pipeline };              // live streams, pushed whenever their batches arrive
+//   merger.Input(0).Push(gpsBatch);                  // emits what is known to come first; Finish() ends an input
+//
+// NOTE: an input that goes back in time (or has a NaN timestamp) is merged where it stands and counted in OutOfOrder();
+// the output is then only as ordered as the inputs were. No event is ever dropped.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "EventColumnStore.h"
+#include "Instrumentation.h"
+#include "Pipeline.h"
+#include "SimulationEvent.h"
+#include "SourceDictionary.h"
+
+class LoserTree
+{
+public:
+    static constexpr std::optional<double> Exhausted{};
+
+    LoserTree() = default;
+    explicit LoserTree(std::span<const std::optional<double>> heads) { Reset(heads); }
+
+    // heads[i] is the first key of input i, Exhausted if it has none.
+    void Reset(std::span<const std::optional<double>> heads)
+    {
+        count = heads.size();
+        nodes.assign(std::max<std::size_t>(count, 1), {});
+
+        // Bottom-up, one match per internal node: node n plays the winners of 2n and 2n + 1, and position count + i
+        // is input i's leaf.
+        std::vector<Entry> winners(count);
+        auto winnerAt = [&](std::size_t position) { return position >= count ? MakeEntry(heads[position - count], position - count) : winners[position]; };
+        for (std::size_t node = count; node-- > 1;)
+        {
+            const Entry left = winnerAt(2 * node);
+            const Entry right = winnerAt(2 * node + 1);
+            const bool leftWins = Beats(left, right);
+            winners[node] = leftWins ? left : right;
+            nodes[node] = leftWins ? right : left;
+        }
+        nodes[0] = count > 1 ? winners[1] : MakeEntry(count == 1 ? heads[0] : Exhausted, 0);
+    }
+
+    std::size_t Size() const { return count; }
+    std::size_t Winner() const { return nodes[0].input; }
+    double WinnerKey() const { return nodes[0].key; }
+
+    // The winner moved on to its next key (Exhausted when it ran out): replays its path to the root only.
+    void ReplaceWinner(std::optional<double> key)
+    {
+        Entry winner = MakeEntry(key, nodes[0].input);
+        for (std::size_t node = (winner.input + count) / 2; node > 0; node /= 2)
+        {
+            if (Beats(nodes[node], winner)) std::swap(nodes[node], winner);
+        }
+        nodes[0] = winner;
+    }
+
+private:
+    struct Entry
+    {
+        double key{};
+        std::size_t input{};
+        bool exhausted{};
+    };
+
+    static Entry MakeEntry(std::optional<double> key, std::size_t input) { return { key.value_or(0.0), input, !key }; }
+
+    // An exhausted input loses to everything, even a +inf key; a NaN key beats every other one, so it leaves as soon as
+    // it is a head. Otherwise the earlier key wins, then the lower input: equal timestamps keep input order.
+    static bool Beats(const Entry& a, const Entry& b)
+    {
+        if (a.exhausted || b.exhausted)
+        {
+            return !a.exhausted;
+        }
+        const bool aNan = std::isnan(a.key);
+        const bool bNan = std::isnan(b.key);
+        if (aNan || bNan)
+        {
+            return aNan && (!bNan || a.input < b.input);
+        }
+        return a.key < b.key || (a.key == b.key && a.input < b.input);
+    }
+
+    std::size_t count{};
+    std::vector<Entry> nodes{};         // [0] the winner, [1, k) the loser of each internal node, key beside the input
+};
+
+// ** Runs of one store **
+
+// Merges time-sorted row lists of store (e.g. GroupBySourceId of a log sorted per source) and pushes the merged rows.
+inline void MergeSortedRuns(const EventColumnStore& store, std::span<const std::span<const EventIndex>> runs, BatchOperator& pipeline, std::size_t batchRows = PipelineBatchRows)
+{
+    std::size_t remaining = 0;
+    for (auto run : runs) remaining += run.size();
+    ESP_TIME_OPERATION("merge_sorted_runs", remaining);
+
+    auto timestamps = store.Timestamps();
+    std::vector<std::size_t> next(runs.size());
+    std::vector<std::optional<double>> heads(runs.size());
+    for (std::size_t input = 0; input < runs.size(); ++input)
+    {
+        heads[input] = runs[input].empty() ? LoserTree::Exhausted : timestamps[runs[input].front()];
+    }
+    LoserTree tree{ heads };
+
+    std::vector<EventIndex> batch{};
+    batch.reserve(std::min(batchRows, remaining));
+    for (; remaining > 0; --remaining)
+    {
+        const std::size_t input = tree.Winner();
+        const auto run = runs[input];
+        batch.push_back(run[next[input]]);
+        tree.ReplaceWinner(++next[input] < run.size() ? timestamps[run[next[input]]] : LoserTree::Exhausted);
+        if (batch.size() == batchRows)
+        {
+            pipeline.Push({ store, batch });
+            batch.clear();
+        }
+    }
+    if (!batch.empty())
+    {
+        pipeline.Push({ store, batch });
+    }
+    pipeline.Finish();
+}
+
+inline void MergeSortedRuns(const EventColumnStore& store, const std::vector<std::vector<EventIndex>>& runs, BatchOperator& pipeline, std::size_t batchRows = PipelineBatchRows)
+{
+    std::vector<std::span<const EventIndex>> spans(runs.begin(), runs.end());
+    MergeSortedRuns(store, spans, pipeline, batchRows);
+}
+
+// ** Streaming merge **
+
+// Inputs are pushed independently, in any interleaving. An event leaves as soon as no input can still deliver an
+// earlier one: an input that has nothing buffered stops the merge until it gets more or finishes, see Blocking().
+// Memory is whatever the other inputs buffered while the merge waited on the slowest one.
+// The merged batches live in the merger's own columns, with source ids of one dictionary (remapped when an input uses
+// another one). Finishing the last input flushes the merge and finishes the downstream operator.
+class StreamMerger
+{
+public:
+    StreamMerger(std::size_t inputCount, BatchOperator& downstream, std::shared_ptr<SourceDictionary> dictionary = std::make_shared<SourceDictionary>(), std::size_t batchRows = PipelineBatchRows)
+        : downstream{ downstream }, merged{ std::move(dictionary) }, batchRows{ batchRows }, rows(batchRows)
+    {
+        if (inputCount == 0 || batchRows == 0)
+        {
+            throw std::invalid_argument("StreamMerger: needs at least one input and a positive batch size");
+        }
+        for (std::size_t input = 0; input < inputCount; ++input)
+        {
+            inputs.push_back(std::make_unique<MergeInput>(*this));
+        }
+        std::iota(rows.begin(), rows.end(), EventIndex{ 0 });
+        const std::vector<std::optional<double>> heads(inputCount, -std::numeric_limits<double>::infinity());// nothing known about any input yet
+        tree.Reset(heads);
+        merged.Reserve(batchRows);
+    }
+
+    StreamMerger(const StreamMerger&) = delete;
+    StreamMerger& operator=(const StreamMerger&) = delete;
+
+    // Push input's batches here (directly, or as the last stage of that input's pipeline); its Finish() ends the input.
+    BatchOperator& Input(std::size_t input) { return *inputs.at(input); }
+    std::size_t InputCount() const { return inputs.size(); }
+
+    // The input the merge waits on, nullopt once every input finished.
+    std::optional<std::size_t> Blocking() const
+    {
+        return done ? std::nullopt : std::optional<std::size_t>{ tree.Winner() };
+    }
+
+    std::uint64_t OutOfOrder() const { return outOfOrder; }    // events earlier than the one before them on their input, or NaN
+
+private:
+    enum class KeyState : std::uint8_t
+    {
+        LowerBound,     // the tree holds the input's last timestamp: its next event can't be earlier
+        Head,           // the tree holds the timestamp of pending[head]
+        Exhausted
+    };
+
+    class MergeInput : public BatchOperator
+    {
+    public:
+        explicit MergeInput(StreamMerger& owner) : owner{ owner } {}
+
+        void Push(const EventBatch& batch) override
+        {
+            if (finished)
+            {
+                throw std::logic_error("StreamMerger: push after the input finished");
+            }
+            Compact();
+            const bool sameSources = batch.columns.SharedSources() == owner.merged.SharedSources();
+            auto fromTimestamps = batch.columns.Timestamps();
+            auto fromTypes = batch.columns.Types();
+            auto fromSourceIds = batch.columns.SourceIds();
+            auto fromValues = batch.columns.Values();
+            for (EventIndex row : batch.rows)
+            {
+                if (!(fromTimestamps[row] >= last)) ++owner.outOfOrder;
+                if (!std::isnan(fromTimestamps[row])) last = fromTimestamps[row];// the lower bound stays a timestamp
+                timestamps.push_back(fromTimestamps[row]);
+                types.push_back(fromTypes[row]);
+                sourceIds.push_back(sameSources ? fromSourceIds[row] : owner.merged.InternSource(batch.columns.SourceName(fromSourceIds[row])));
+                values.push_back(fromValues[row]);
+            }
+            owner.Drain();
+        }
+
+        void Finish() override
+        {
+            finished = true;
+            owner.Drain();
+        }
+
+    private:
+        friend class StreamMerger;
+
+        bool HasPending() const { return head < timestamps.size(); }
+
+        // Drops the events already merged once they are most of the buffer: amortized O(1) per event.
+        void Compact()
+        {
+            if (head == 0 || head * 2 < timestamps.size())
+            {
+                return;
+            }
+            timestamps.erase(timestamps.begin(), timestamps.begin() + head);
+            types.erase(types.begin(), types.begin() + head);
+            sourceIds.erase(sourceIds.begin(), sourceIds.begin() + head);
+            values.erase(values.begin(), values.begin() + head);
+            head = 0;
+        }
+
+        StreamMerger& owner;
+        std::vector<double> timestamps{};
+        std::vector<EventType> types{};
+        std::vector<SourceId> sourceIds{};
+        std::vector<double> values{};
+        std::size_t head{};                     // first event not merged yet
+        double last{ -std::numeric_limits<double>::infinity() };  // latest non-NaN timestamp
+        KeyState key{ KeyState::LowerBound };
+        bool finished{};
+    };
+
+    // Emits events while the winner has one. A winner whose key is stale (a lower bound, or nothing left after it
+    // finished) gets its real key and plays again, so the tree only ever changes at the winner.
+    void Drain()
+    {
+        ESP_TIME_OPERATION("stream_merge", 0);// per drain, including the downstream pushes
+        while (!done)
+        {
+            MergeInput& input = *inputs[tree.Winner()];
+            if (input.HasPending())
+            {
+                if (input.key != KeyState::Head)
+                {
+                    input.key = KeyState::Head;
+                    tree.ReplaceWinner(input.timestamps[input.head]);
+                    continue;
+                }
+                Emit(input);
+                ++input.head;
+                if (input.HasPending())
+                {
+                    tree.ReplaceWinner(input.timestamps[input.head]);
+                }
+                else
+                {
+                    input.key = KeyState::LowerBound;
+                    tree.ReplaceWinner(input.last);
+                }
+            }
+            else if (!input.finished)
+            {
+                return;// Blocking(): it may still deliver the earliest event
+            }
+            else if (input.key != KeyState::Exhausted)
+            {
+                input.key = KeyState::Exhausted;
+                tree.ReplaceWinner(LoserTree::Exhausted);
+            }
+            else
+            {
+                done = true;// the winner is exhausted, so is everybody: exhausted loses every match
+                Flush();
+                downstream.Finish();
+            }
+        }
+    }
+
+    void Emit(const MergeInput& input)
+    {
+        merged.Append(input.timestamps[input.head], input.types[input.head], input.sourceIds[input.head], input.values[input.head]);
+        if (merged.Size() == batchRows)
+        {
+            Flush();
+        }
+    }
+
+    void Flush()
+    {
+        if (merged.Size() == 0)
+        {
+            return;
+        }
+        ESP_COUNT_EVENTS("stream_merge", merged.Size());
+        downstream.Push({ merged, { rows.data(), merged.Size() }, true });
+        merged.Clear();
+    }
+
+    BatchOperator& downstream;
+    EventColumnStore merged;                    // the batch being filled
+    std::size_t batchRows;
+    std::vector<EventIndex> rows;               // 0 .. batchRows-1
+    std::vector<std::unique_ptr<MergeInput>> inputs{};
+    LoserTree tree{};
+    std::uint64_t outOfOrder{};
+    bool done{};
+};
+
+// Merges whole time-sorted stores through a StreamMerger, always reading the next batch of the input it waits on, so
+// no more than about one batch per input is buffered. dictionary: the merged stream's, stores[0]'s by default.
+// Returns StreamMerger::OutOfOrder().
+inline std::uint64_t PushMerged(std::span<const EventColumnStore* const> stores, BatchOperator& pipeline, std::shared_ptr<SourceDictionary> dictionary = {}, std::size_t batchRows = PipelineBatchRows)
+{
+    if (stores.empty())
+    {
+        pipeline.Finish();
+        return 0;
+    }
+    StreamMerger merger{ stores.size(), pipeline, dictionary ? std::move(dictionary) : stores.front()->SharedSources(), batchRows };
+    std::vector<std::size_t> next(stores.size());
+    std::vector<EventIndex> rows(batchRows);
+    while (auto input = merger.Blocking())
+    {
+        const EventColumnStore& store = *stores[*input];
+        const std::size_t begin = next[*input];
+        if (begin >= store.Size())
+        {
+            merger.Input(*input).Finish();
+            continue;
+        }
+        const std::size_t count = std::min(batchRows, store.Size() - begin);
+        std::iota(rows.begin(), rows.begin() + count, static_cast<EventIndex>(begin));
+        next[*input] += count;
+        merger.Input(*input).Push({ store, { rows.data(), count }, true });
+    }
+    return merger.OutOfOrder();
+}
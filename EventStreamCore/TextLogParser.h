@@ -0,0 +1,358 @@
+#pragma once
+// Streaming parser for text event logs, one event per line:
+//   timestamp,type,source,value          e.g.  5.0,ACTUATOR_COMMAND,flaps,15.0
+// The delimiter is configurable, fields are trimmed and a leading "T:" on the timestamp is ignored, so the
+// FormatEvents output ("T: 5.000000 | ACTUATOR_COMMAND | flaps | 15.000000") parses with delimiter '|'.
+// Blank lines and lines starting with '#' are skipped.
+//
+// The file is read in fixed-size chunks and lines are parsed in place as string_views: numbers go through
+// std::from_chars, the type name is matched with EventTypeFromString, and the source is interned by view,
+// so a well-formed line allocates nothing. Events are handed to the sink in batches; memory stays at one chunk,
+// one batch and one carried-over partial line however large the file is.
+// Malformed lines are counted and reported with their line numbers (the first maxReportedErrors are kept).
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "EventColumnStore.h"
+#include "Instrumentation.h"
+#include "SimulationEvent.h"
+#include "SourceDictionary.h"
+
+struct TextLogOptions
+{
+    char delimiter{ ',' };
+    std::size_t chunkBytes{ 1 << 20 };      // read size
+    std::size_t maxLineBytes{ 64 * 1024 };  // a longer line is reported and skipped, so a missing newline cannot grow the carry buffer
+    std::size_t batchEvents{ 4096 };        // events per sink call
+    std::size_t maxReportedErrors{ 100 };
+};
+
+struct TextLogError
+{
+    std::uint64_t line{};   // 1-based
+    std::string message{};
+};
+
+struct TextLogReport
+{
+    std::uint64_t bytes{};
+    std::uint64_t lines{};
+    std::uint64_t events{};
+    std::uint64_t malformed{};
+    std::vector<TextLogError> errors{};    // first maxReportedErrors malformed lines
+
+    bool Ok() const { return malformed == 0; }
+};
+
+// Called with each full batch (and the last partial one). The batch is cleared and reused after the call returns.
+using EventBatchSink = std::function<void(const EventColumnStore& batch)>;
+
+class TextLogParser
+{
+public:
+    TextLogParser(std::shared_ptr<SourceDictionary> dictionary, EventBatchSink sink, TextLogOptions options = {})
+        : batch{ std::move(dictionary) }, sink{ std::move(sink) }, options{ options }
+    {
+        batch.Reserve(this->options.batchEvents);
+    }
+
+    // Accepts any slice of the input; a line split across two calls is stitched together.
+    void Feed(std::string_view bytes)
+    {
+        ESP_TIME_OPERATION("parse_text_log", 0);// per slice, including the sink's work on the batches it fills
+        ESP_COUNT_BYTES("parse_text_log", bytes.size());
+        report.bytes += bytes.size();
+
+        while (!bytes.empty())
+        {
+            const std::size_t newline = bytes.find('\n');
+            if (newline == std::string_view::npos)
+            {
+                Carry(bytes);
+                return;
+            }
+
+            const std::string_view head = bytes.substr(0, newline);
+            bytes.remove_prefix(newline + 1);
+            if (carry.empty() && !skippingLongLine)
+            {
+                ParseLine(head);// fast path: the whole line is inside this slice, parse it where it is
+            }
+            else
+            {
+                Carry(head);
+                if (!skippingLongLine)
+                {
+                    ParseLine(carry);
+                }
+                carry.clear();
+                skippingLongLine = false;
+            }
+        }
+    }
+
+    // End of input: parses a last line that had no trailing newline and flushes the final batch.
+    void Finish()
+    {
+        if (!carry.empty() || skippingLongLine)
+        {
+            if (!skippingLongLine)
+            {
+                ParseLine(carry);
+            }
+            carry.clear();
+            skippingLongLine = false;
+        }
+        FlushBatch();
+    }
+
+    const TextLogReport& Report() const { return report; }
+
+private:
+    void Carry(std::string_view partial)
+    {
+        if (skippingLongLine)
+        {
+            return;
+        }
+        if (carry.size() + partial.size() > options.maxLineBytes)
+        {
+            ++report.lines;
+            Malformed("line longer than " + std::to_string(options.maxLineBytes) + " bytes");
+            carry.clear();
+            skippingLongLine = true;// drop everything up to the next newline; the line was already counted
+            return;
+        }
+        carry.append(partial);
+    }
+
+    static bool IsBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    // Hand-rolled: most fields have no padding, so this is two compares (find_first_not_of costs a set search per char).
+    static std::string_view Trim(std::string_view text)
+    {
+        while (!text.empty() && IsBlank(text.front()))
+        {
+            text.remove_prefix(1);
+        }
+        while (!text.empty() && IsBlank(text.back()))
+        {
+            text.remove_suffix(1);
+        }
+        return text;
+    }
+
+    static bool ParseDouble(std::string_view text, double& out)
+    {
+        const char* end = text.data() + text.size();
+        auto [ptr, ec] = std::from_chars(text.data(), end, out);
+        return ec == std::errc{} && ptr == end && !text.empty();
+    }
+
+    void ParseLine(std::string_view line)
+    {
+        ++report.lines;
+
+        line = Trim(line);
+        if (line.empty() || line.front() == '#')
+        {
+            return;
+        }
+
+        std::string_view fields[4]{};
+        std::size_t fieldCount = 0;
+        for (;;)
+        {
+            const std::size_t delimiter = line.find(options.delimiter);
+            if (fieldCount == 4)
+            {
+                Malformed("expected 4 fields, got more");
+                return;
+            }
+            fields[fieldCount++] = Trim(line.substr(0, delimiter));
+            if (delimiter == std::string_view::npos)
+            {
+                break;
+            }
+            line.remove_prefix(delimiter + 1);
+        }
+        if (fieldCount != 4)
+        {
+            Malformed("expected 4 fields, got " + std::to_string(fieldCount));
+            return;
+        }
+
+        std::string_view timestampField = fields[0];
+        if (timestampField.starts_with("T:"))
+        {
+            timestampField = Trim(timestampField.substr(2));
+        }
+
+        double timestampSec = 0.0;
+        if (!ParseDouble(timestampField, timestampSec))
+        {
+            Malformed("bad timestamp '" + std::string(fields[0]) + "'");
+            return;
+        }
+        const auto type = EventTypeFromString(fields[1]);
+        if (!type)
+        {
+            Malformed("unknown event type '" + std::string(fields[1]) + "'");
+            return;
+        }
+        if (fields[2].empty())
+        {
+            Malformed("empty source");
+            return;
+        }
+        double value = 0.0;
+        if (!ParseDouble(fields[3], value))
+        {
+            Malformed("bad value '" + std::string(fields[3]) + "'");
+            return;
+        }
+
+        batch.Append(timestampSec, *type, batch.InternSource(fields[2]), value);
+        ++report.events;
+        if (batch.Size() >= options.batchEvents)
+        {
+            FlushBatch();
+        }
+    }
+
+    void Malformed(std::string message)
+    {
+        ++report.malformed;
+        if (report.errors.size() < options.maxReportedErrors)
+        {
+            report.errors.push_back({ report.lines, std::move(message) });
+        }
+    }
+
+    void FlushBatch()
+    {
+        if (batch.Empty())
+        {
+            return;
+        }
+        ESP_COUNT_EVENTS("parse_text_log", batch.Size());
+        sink(batch);
+        batch.Clear();
+    }
+
+    EventColumnStore batch;
+    EventBatchSink sink;
+    TextLogOptions options{};
+    TextLogReport report{};
+
+    std::string carry{};            // the partial line at the end of the previous Feed()
+    bool skippingLongLine{};
+};
+
+// Streams a whole file through a parser in options.chunkBytes reads.
+inline TextLogReport ParseTextLogFile(const std::filesystem::path& path, std::shared_ptr<SourceDictionary> dictionary, EventBatchSink sink, TextLogOptions options = {})
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("ParseTextLogFile: cannot open " + path.string());
+    }
+
+    TextLogParser parser{ std::move(dictionary), std::move(sink), options };
+    std::vector<char> chunk(options.chunkBytes);
+    while (file)
+    {
+        file.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        const auto count = static_cast<std::size_t>(file.gcount());
+        if (count == 0)
+        {
+            break;
+        }
+        parser.Feed({ chunk.data(), count });
+    }
+    parser.Finish();
+    return parser.Report();
+}
+
+// Convenience for logs that fit in memory: parses everything into one store.
+inline EventColumnStore LoadTextLog(const std::filesystem::path& path, TextLogReport* report = nullptr, TextLogOptions options = {})
+{
+    EventColumnStore store{};
+    auto parsed = ParseTextLogFile(path, store.SharedSources(), [&store](const EventColumnStore& batch)
+        {
+            auto timestamps = batch.Timestamps();
+            auto types = batch.Types();
+            auto sourceIds = batch.SourceIds();
+            auto values = batch.Values();
+            for (std::size_t row = 0; row < batch.Size(); ++row)
+            {
+                store.Append(timestamps[row], types[row], sourceIds[row], values[row]);// same dictionary, ids carry over as-is
+            }
+        }, options);
+
+    if (report)
+    {
+        *report = std::move(parsed);
+    }
+    return store;
+}
+
+// ** Writing **
+// The inverse of the parser: one "timestamp,type,source,value" line per row. Numbers are written with std::to_chars
+// in shortest round-trip form, so LoadTextLog gives back the exact values; lines are built in a buffer and written
+// to the stream in large blocks.
+
+inline void AppendTextLogLine(std::string& buffer, const EventColumnStore& store, std::size_t row, char delimiter = ',')
+{
+    char number[32];
+    buffer.append(number, std::to_chars(number, number + sizeof(number), store.Timestamps()[row]).ptr);
+    buffer += delimiter;
+    buffer += EventTypeNames[static_cast<std::size_t>(store.Types()[row])];
+    buffer += delimiter;
+    buffer += store.SourceName(store.SourceIds()[row]);
+    buffer += delimiter;
+    buffer.append(number, std::to_chars(number, number + sizeof(number), store.Values()[row]).ptr);
+    buffer += '\n';
+}
+
+// Writes the given rows, in that order (a selection or a sort order).
+inline void WriteTextLog(const EventColumnStore& store, std::span<const EventIndex> rows, std::ostream& out, char delimiter = ',')
+{
+    ESP_TIME_OPERATION("write_text_log", rows.size());
+    constexpr std::size_t FlushBytes = 1 << 20;
+    std::string buffer{};
+    buffer.reserve(FlushBytes + 256);
+    [[maybe_unused]] std::uint64_t written = 0;
+    for (EventIndex row : rows)
+    {
+        AppendTextLogLine(buffer, store, row, delimiter);
+        if (buffer.size() >= FlushBytes)
+        {
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            written += buffer.size();
+            buffer.clear();
+        }
+    }
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    ESP_COUNT_BYTES("write_text_log", written + buffer.size());
+}
+
+inline void WriteTextLog(const EventColumnStore& store, std::ostream& out, char delimiter = ',')
+{
+    std::vector<EventIndex> rows(store.Size());
+    std::iota(rows.begin(), rows.end(), EventIndex{ 0 });
+    WriteTextLog(store, rows, out, delimiter);
+}
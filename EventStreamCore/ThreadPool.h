@@ -0,0 +1,250 @@
+#pragma once
+// Shared work-stealing thread pool.
+// Every worker owns a deque: it pushes and pops its own tasks at the back (LIFO, cache-warm) and, when it runs dry,
+// steals from the front of another worker's deque (FIFO, the oldest and usually largest piece of work).
+// Tasks submitted from outside the pool are dealt round-robin across the deques.
+// TaskGroup waits for a batch of tasks; the waiting thread runs queued tasks meanwhile, so nested parallel calls cannot deadlock.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    explicit ThreadPool(std::size_t threadCount = std::max<std::size_t>(1, std::thread::hardware_concurrency()))
+    {
+        threadCount = std::max<std::size_t>(1, threadCount);
+        for (std::size_t index = 0; index < threadCount; ++index)
+        {
+            queues.push_back(std::make_unique<WorkerQueue>());
+        }
+        for (std::size_t index = 0; index < threadCount; ++index)
+        {
+            workers.emplace_back([this, index] { WorkerLoop(index); });
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard lock{ sleepMutex };
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t ThreadCount() const { return workers.size(); }
+
+    void Submit(Task task)
+    {
+        const std::size_t target = currentPool == this ? currentIndex : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+        {
+            std::lock_guard lock{ queues[target]->mutex };
+            queues[target]->tasks.push_back(std::move(task));
+        }
+        pending.fetch_add(1, std::memory_order_release);
+        {
+            std::lock_guard lock{ sleepMutex };// pairs with the predicate check in WorkerLoop, so the wake-up cannot be lost
+        }
+        wake.notify_one();
+    }
+
+    // Runs one queued task on the calling thread, if there is one. Used by waiters to help instead of blocking.
+    bool RunPendingTask()
+    {
+        Task task{};
+        const std::size_t home = currentPool == this ? currentIndex : 0;
+        if (!TryPopOwn(home, task) && !TrySteal(home, task))
+        {
+            return false;
+        }
+        pending.fetch_sub(1, std::memory_order_acq_rel);
+        task();
+        return true;
+    }
+
+private:
+    struct WorkerQueue
+    {
+        std::mutex mutex{};
+        std::deque<Task> tasks{};
+    };
+
+    void WorkerLoop(std::size_t index)
+    {
+        currentPool = this;
+        currentIndex = index;
+        for (;;)
+        {
+            Task task{};
+            if (TryPopOwn(index, task) || TrySteal(index, task))
+            {
+                pending.fetch_sub(1, std::memory_order_acq_rel);
+                task();
+                continue;
+            }
+
+            std::unique_lock lock{ sleepMutex };
+            wake.wait(lock, [this] { return stopping || pending.load(std::memory_order_acquire) > 0; });
+            if (stopping && pending.load(std::memory_order_acquire) == 0)
+            {
+                return;
+            }
+        }
+    }
+
+    bool TryPopOwn(std::size_t index, Task& task)
+    {
+        WorkerQueue& queue = *queues[index];
+        std::lock_guard lock{ queue.mutex };
+        if (queue.tasks.empty())
+        {
+            return false;
+        }
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool TrySteal(std::size_t thief, Task& task)
+    {
+        for (std::size_t offset = 1; offset <= queues.size(); ++offset)
+        {
+            WorkerQueue& victim = *queues[(thief + offset) % queues.size()];
+            std::unique_lock lock{ victim.mutex, std::try_to_lock };// a busy victim is skipped rather than waited on
+            if (lock.owns_lock() && !victim.tasks.empty())
+            {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues{};
+    std::vector<std::thread> workers{};
+
+    std::mutex sleepMutex{};
+    std::condition_variable wake{};
+    bool stopping{};
+    std::atomic<std::size_t> pending{};     // tasks sitting in any deque
+    std::atomic<std::size_t> nextQueue{};
+
+    static inline thread_local ThreadPool* currentPool{};
+    static inline thread_local std::size_t currentIndex{};
+};
+
+// One pool for the whole process, sized to the machine; created on first use.
+inline ThreadPool& SharedThreadPool()
+{
+    static ThreadPool pool{};
+    return pool;
+}
+
+// Fork/join over a pool. The first exception thrown by a task is rethrown from Wait().
+class TaskGroup
+{
+public:
+    explicit TaskGroup(ThreadPool& pool) : pool{ pool } {}
+    ~TaskGroup() { WaitNoThrow(); }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void Run(std::function<void()> task)
+    {
+        outstanding.fetch_add(1, std::memory_order_relaxed);
+        pool.Submit([this, task = std::move(task)]
+            {
+                try
+                {
+                    task();
+                }
+                catch (...)
+                {
+                    std::lock_guard lock{ errorMutex };
+                    if (!error) error = std::current_exception();
+                }
+                outstanding.fetch_sub(1, std::memory_order_acq_rel);
+            });
+    }
+
+    void Wait()
+    {
+        WaitNoThrow();
+        if (error)
+        {
+            std::rethrow_exception(std::exchange(error, nullptr));
+        }
+    }
+
+private:
+    void WaitNoThrow()
+    {
+        while (outstanding.load(std::memory_order_acquire) > 0)
+        {
+            if (!pool.RunPendingTask())
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    ThreadPool& pool;
+    std::atomic<std::size_t> outstanding{};
+    std::mutex errorMutex{};
+    std::exception_ptr error{};
+};
+
+// Splits [0, count) into about pool.ThreadCount() * 4 chunks of at least minChunk and runs body(chunkBegin, chunkEnd, chunkIndex)
+// on the pool. Returns the number of chunks so callers can size per-chunk partial results up front with ChunkCount().
+inline std::size_t ChunkCount(const ThreadPool& pool, std::size_t count, std::size_t minChunk)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    const std::size_t byGrain = (count + minChunk - 1) / std::max<std::size_t>(1, minChunk);
+    return std::clamp<std::size_t>(byGrain, 1, pool.ThreadCount() * 4);
+}
+
+template <typename Body>
+std::size_t ParallelForChunks(ThreadPool& pool, std::size_t count, std::size_t minChunk, Body body)
+{
+    const std::size_t chunks = ChunkCount(pool, count, minChunk);
+    if (chunks <= 1)
+    {
+        if (chunks == 1) body(std::size_t{ 0 }, count, std::size_t{ 0 });
+        return chunks;
+    }
+
+    TaskGroup group{ pool };
+    for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+    {
+        const std::size_t begin = count * chunk / chunks;
+        const std::size_t end = count * (chunk + 1) / chunks;
+        group.Run([&body, begin, end, chunk] { body(begin, end, chunk); });
+    }
+    group.Wait();
+    return chunks;
+}
@@ -0,0 +1,128 @@
+#pragma once
+// Sorted time index: answers "first event after t" and "[t0, t1)" queries with binary search.
+// FirstEventAfter/FirstEvent/FirstEventAfterThis are a linear find_if, O(N) per query. The index is built once
+// (O(N log N)) and kept up to date as events are appended, then each lookup is O(log N).
+// NOTE: the index answers by time, i.e. the EARLIEST event with timestamp > t. The find_if versions return the first
+// match in storage order, which is the same thing only when the events are already sorted.
+// Events with a NaN timestamp are kept after the sorted ones, in row order, outside every search: like the scans,
+// no time query ever returns them. Order() still lists every row.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "EventColumnStore.h"
+#include "SimulationEvent.h"
+
+class TimeIndex
+{
+public:
+    TimeIndex() = default;
+
+    explicit TimeIndex(const std::vector<SimulationEvent>& events)
+    {
+        Build(events.size(), [&events](EventIndex index) { return events[index].timestampSec; });
+    }
+
+    explicit TimeIndex(const EventColumnStore& store)
+    {
+        auto timestamps = store.Timestamps();
+        Build(timestamps.size(), [timestamps](EventIndex row) { return timestamps[row]; });
+    }
+
+    // Keeps the index current when a new event is appended at position row.
+    // In-order arrivals (the common case) are a push_back; an older timestamp is placed after any equal ones, so ties stay in arrival order.
+    void Insert(double timestampSec, EventIndex row)
+    {
+        if (std::isnan(timestampSec))
+        {
+            rows.push_back(row);// after the sorted rows, never searched
+            return;
+        }
+        const bool inOrder = sortedTimes.empty() || timestampSec >= sortedTimes.back();
+        const std::size_t at = inOrder ? sortedTimes.size() : UpperBound(timestampSec);
+        sortedTimes.insert(sortedTimes.begin() + at, timestampSec);
+        rows.insert(rows.begin() + at, row);// a push_back too, unless NaN rows follow the sorted ones
+    }
+
+    std::size_t Size() const { return rows.size(); }
+    bool Empty() const { return rows.empty(); }
+
+    // Row/position of the earliest event with timestamp > thresholdTime, or nullopt if none found.
+    std::optional<EventIndex> FirstAfter(double thresholdTime) const
+    {
+        const std::size_t at = UpperBound(thresholdTime);
+        return at < sortedTimes.size() ? std::optional<EventIndex>{ rows[at] } : std::nullopt;
+    }
+
+    // Same but timestamp >= time.
+    std::optional<EventIndex> FirstAtOrAfter(double time) const
+    {
+        const std::size_t at = LowerBound(time);
+        return at < sortedTimes.size() ? std::optional<EventIndex>{ rows[at] } : std::nullopt;
+    }
+
+    // Rows with t0 <= timestamp < t1, in time order. The span points into the index (no copy); it is invalidated by Insert().
+    std::span<const EventIndex> Range(double t0, double t1) const
+    {
+        const std::size_t begin = LowerBound(t0);
+        const std::size_t end = std::max(begin, LowerBound(t1));
+        return std::span<const EventIndex>{ rows }.subspan(begin, end - begin);
+    }
+
+    std::size_t CountInRange(double t0, double t1) const { return Range(t0, t1).size(); }
+
+    std::span<const double> SortedTimes() const { return sortedTimes; }// NaN timestamps left out
+    std::span<const EventIndex> Order() const { return rows; }// the whole permutation, ascending by time, NaN rows last
+
+private:
+    template <typename TimeOf>
+    void Build(std::size_t count, TimeOf timeOf)
+    {
+        rows.resize(count);
+        std::iota(rows.begin(), rows.end(), EventIndex{ 0 });
+        // NaN orders against nothing, so it would break the sort's strict weak ordering: those rows go last, unsorted.
+        const auto ordered = std::ranges::stable_partition(rows, [&timeOf](EventIndex row) { return !std::isnan(timeOf(row)); });
+        const auto sortedEnd = ordered.begin();
+        std::ranges::stable_sort(rows.begin(), sortedEnd, {}, timeOf);
+
+        // Timestamps are copied in sorted order next to the rows, so every binary search probe reads one contiguous array.
+        sortedTimes.resize(static_cast<std::size_t>(sortedEnd - rows.begin()));
+        std::transform(rows.begin(), sortedEnd, sortedTimes.begin(), timeOf);
+    }
+
+    std::size_t LowerBound(double time) const { return static_cast<std::size_t>(std::ranges::lower_bound(sortedTimes, time) - sortedTimes.begin()); }
+    std::size_t UpperBound(double time) const { return static_cast<std::size_t>(std::ranges::upper_bound(sortedTimes, time) - sortedTimes.begin()); }
+
+    std::vector<double> sortedTimes{};  // ascending, no NaN
+    std::vector<EventIndex> rows{};     // rows[i] is the event whose timestamp is sortedTimes[i]; then the NaN rows
+};
+
+//5. Find the First Event After a Time Threshold, O(log N) with an index built over the same events.
+inline const SimulationEvent* FirstEventAfter(const std::vector<SimulationEvent>& events, const TimeIndex& index, double thresholdTime)
+{
+    auto position = index.FirstAfter(thresholdTime);
+    return position ? &events[*position] : nullptr;
+}
+
+inline std::optional<EventIndex> FirstEventAfter(const EventColumnStore&, const TimeIndex& index, double thresholdTime)
+{
+    return index.FirstAfter(thresholdTime);
+}
+
+// Events in [t0, t1) as pointers into events, in time order.
+inline std::vector<const SimulationEvent*> EventsInRange(const std::vector<SimulationEvent>& events, const TimeIndex& index, double t0, double t1)
+{
+    std::vector<const SimulationEvent*> inRange{};
+    auto rows = index.Range(t0, t1);
+    inRange.reserve(rows.size());
+    for (EventIndex position : rows)
+    {
+        inRange.push_back(&events[position]);
+    }
+    return inRange;
+}
@@ -0,0 +1,240 @@
+#pragma once
+// Tumbling and sliding time-window aggregation over a time-ordered stream.
+// Windows are [start, start + sizeSec) with starts on multiples of slideSec: slideSec == sizeSec is a tumbling window,
+// slideSec < sizeSec a sliding (overlapping) one. e.g. { 10.0, 10.0 } is the "10-second interval segmentation" task.
+// Results are kept per key (everything, per source, per type, or per source and type) as running count/sum:
+// an event is added once when it enters and subtracted once when the window slides past it, so a sliding window
+// never rescans its contents. Each window is emitted to the sink as soon as an event at or past its end shows up
+// (or on Finish()), one WindowResult per key that had events in it.
+//
+// Input must be in time order: the output of StreamIngestor, a sorted store, or AggregateWindows below.
+// An event older than the one before it cannot be placed any more (its windows may be emitted already); it is counted in Late() and dropped.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory_resource>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "EventColumnStore.h"
+#include "Instrumentation.h"
+#include "SimulationEvent.h"
+#include "SourceDictionary.h"
+
+enum class WindowKey : std::uint8_t
+{
+    All,
+    Source,
+    Type,
+    SourceAndType
+};
+
+struct WindowOptions
+{
+    double sizeSec{ 10.0 };
+    double slideSec{ 10.0 };    // == sizeSec: tumbling; < sizeSec: sliding; > sizeSec: hopping, events between windows are skipped
+    WindowKey key{ WindowKey::Source };
+};
+
+struct WindowResult
+{
+    double startSec{};
+    double endSec{};
+    std::optional<SourceId> sourceId{};    // empty when the window is not keyed by source
+    std::optional<EventType> type{};       // empty when the window is not keyed by type
+    std::uint64_t count{};
+    double sum{};
+
+    double Mean() const { return count ? sum / static_cast<double>(count) : 0.0; }
+};
+
+using WindowSink = std::function<void(const WindowResult& result)>;
+
+class WindowAggregator
+{
+public:
+    WindowAggregator(WindowOptions options, WindowSink sink)
+        : options{ options }, sink{ std::move(sink) }
+    {
+        if (!(options.sizeSec > 0.0) || !(options.slideSec > 0.0))
+        {
+            throw std::invalid_argument("WindowAggregator: window size and slide must be positive");
+        }
+    }
+
+    void Add(double timestampSec, EventType type, SourceId sourceId, double value)
+    {
+        if (timestampSec < newestSec)
+        {
+            ++late;// out of order: its windows may already be emitted
+            return;
+        }
+        newestSec = timestampSec;
+
+        // Close every window that ends at or before this event, sliding the running sums forward.
+        while (started && timestampSec >= windowStart + options.sizeSec)
+        {
+            EmitWindow();
+            if (inWindow.empty())
+            {
+                started = false;// nothing carries over: jump straight to the first window containing this event
+                break;
+            }
+            Advance(windowStart + options.slideSec);
+        }
+        if (!started)
+        {
+            Advance(std::max(windowStart, FirstWindowStart(timestampSec)));
+            started = true;
+        }
+        if (timestampSec < windowStart)
+        {
+            return;// hopping windows: this event falls in the gap before the next window
+        }
+
+        const std::size_t slot = SlotOf(sourceId, type);
+        if (slot >= running.size())
+        {
+            running.resize(slot + 1);
+        }
+        ++running[slot].count;
+        running[slot].sum += value;
+        inWindow.push_back({ timestampSec, slot, value });
+    }
+
+    void Add(const SimulationEvent& event, SourceDictionary& sources)
+    {
+        Add(event.timestampSec, event.type, sources.Intern(event.source), event.value);
+    }
+
+    // End of stream: emits the open window and every later one that still holds events.
+    void Finish()
+    {
+        while (started && !inWindow.empty())
+        {
+            EmitWindow();
+            Advance(windowStart + options.slideSec);
+        }
+        started = false;
+    }
+
+    std::uint64_t Late() const { return late; }
+    std::size_t Buffered() const { return inWindow.size(); }
+
+private:
+    struct Running
+    {
+        std::uint64_t count{};
+        double sum{};
+    };
+
+    struct WindowedEvent
+    {
+        double timestampSec{};
+        std::size_t slot{};
+        double value{};
+    };
+
+    // Earliest window start k * slideSec whose window still contains timestampSec.
+    double FirstWindowStart(double timestampSec) const
+    {
+        double start = (std::floor((timestampSec - options.sizeSec) / options.slideSec) + 1.0) * options.slideSec;
+        if (timestampSec >= start + options.sizeSec)
+        {
+            start += options.slideSec;// floor() landed one window early after rounding
+        }
+        return start;
+    }
+
+    std::size_t SlotOf(SourceId sourceId, EventType type) const
+    {
+        switch (options.key)
+        {
+        case WindowKey::Source: return sourceId;
+        case WindowKey::Type: return static_cast<std::size_t>(type);
+        case WindowKey::SourceAndType: return static_cast<std::size_t>(sourceId) * EventTypeCount + static_cast<std::size_t>(type);
+        default: return 0;
+        }
+    }
+
+    void EmitWindow()
+    {
+        for (std::size_t slot = 0; slot < running.size(); ++slot)
+        {
+            if (running[slot].count == 0)
+            {
+                continue;
+            }
+            WindowResult result{ windowStart, windowStart + options.sizeSec, {}, {}, running[slot].count, running[slot].sum };
+            if (options.key == WindowKey::Source) result.sourceId = static_cast<SourceId>(slot);
+            if (options.key == WindowKey::Type) result.type = static_cast<EventType>(slot);
+            if (options.key == WindowKey::SourceAndType)
+            {
+                result.sourceId = static_cast<SourceId>(slot / EventTypeCount);
+                result.type = static_cast<EventType>(slot % EventTypeCount);
+            }
+            sink(result);
+        }
+    }
+
+    // Moves the window start forward and subtracts the events it leaves behind.
+    void Advance(double newStart)
+    {
+        windowStart = newStart;
+        while (!inWindow.empty() && inWindow.front().timestampSec < windowStart)
+        {
+            Running& slot = running[inWindow.front().slot];
+            --slot.count;
+            slot.sum = slot.count ? slot.sum - inWindow.front().value : 0.0;// reset when empty so add/subtract rounding cannot pile up
+            inWindow.pop_front();
+        }
+    }
+
+    WindowOptions options{};
+    WindowSink sink;
+
+    bool started{};
+    double windowStart{ -std::numeric_limits<double>::infinity() };
+    std::vector<Running> running{};            // per key slot, for the current window
+    std::pmr::unsynchronized_pool_resource dequeBlocks{};  // recycles the deque's blocks as the window slides: no heap traffic once warm
+    std::pmr::deque<WindowedEvent> inWindow{ &dequeBlocks };// events inside the current window, oldest first
+    double newestSec{ -std::numeric_limits<double>::infinity() };
+    std::uint64_t late{};
+};
+
+// Windows over a whole store. Rows are visited in time order; the store is only sorted (as a permutation) if it is not already.
+inline std::vector<WindowResult> AggregateWindows(const EventColumnStore& store, WindowOptions options = {})
+{
+    ESP_TIME_OPERATION("aggregate_windows", store.Size());
+    std::vector<WindowResult> results{};
+    WindowAggregator aggregator{ options, [&results](const WindowResult& result) { results.push_back(result); } };
+
+    auto timestamps = store.Timestamps();
+    auto types = store.Types();
+    auto sourceIds = store.SourceIds();
+    auto values = store.Values();
+    auto addRow = [&](std::size_t row) { aggregator.Add(timestamps[row], types[row], sourceIds[row], values[row]); };
+
+    if (std::ranges::is_sorted(timestamps))
+    {
+        for (std::size_t row = 0; row < store.Size(); ++row)
+        {
+            addRow(row);
+        }
+    }
+    else
+    {
+        for (EventIndex row : SortedOrderByTime(store))
+        {
+            addRow(row);
+        }
+    }
+    aggregator.Finish();
+    return results;
+}
@@ -0,0 +1,423 @@
+#pragma once
+// Zone maps: a small summary per ZoneRows-event block of a store (time span, which types and sources occur, totals
+// per type), so filters and aggregates skip the blocks that cannot match and answer the ones that match whole
+// straight from the summary. Only the blocks that partly match are scanned. On a memory-mapped log (BinaryEventLog.h)
+// a skipped block is never paged in: with the map saved next to the log, a selective query reads a few blocks of a
+// multi-gigabyte file.
+//
+//   EventColumnStore store = LoadBinaryEventLog("flight.evlog");
+//   ZoneMap zones = LoadZoneMap(ZoneMapPath("flight.evlog"), store);      // WriteZoneMap(ZoneMap{ store }, store, ...) once
+//   double commands = RunQuery(store, zones, { QueryAggregate::Count, EventType::ACTUATOR_COMMAND });
+//   std::optional<EventIndex> row = FirstEventAfter(store, zones, 3600.0);
+//
+// Skipping works best on logs stored roughly in time order (time ranges) or written in runs per source or type.
+// NOTE: a map belongs to one store epoch (EventColumnStore::Epoch()); Update() it after appends. Rows appended since
+// the last Update() are scanned, so a stale map is slower but never wrong. Another store's map is rejected.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "EventAggregator.h"
+#include "EventColumnStore.h"
+#include "Instrumentation.h"
+#include "Query.h"
+#include "SimulationEvent.h"
+#include "SourceDictionary.h"
+
+inline constexpr std::size_t ZoneRows = 65536;
+inline constexpr std::size_t ZoneSourceBits = 1024;// exact for the first 1024 sources; beyond that ids share bits (id % 1024)
+
+struct Zone
+{
+    EventIndex firstRow{};
+    EventIndex rows{};
+    double minTime{};                   // NaN when any timestamp is NaN: the zone is then always scanned for time filters
+    double maxTime{};
+    std::uint8_t types{};               // bit TypeSlot(type) set when the type occurs
+    std::array<std::uint64_t, ZoneSourceBits / 64> sources{};
+    std::array<Totals, EventTypeCount> byType{};
+
+    bool HasType(EventType type) const { return (types >> TypeSlot(type)) & 1; }
+    bool OnlyType(EventType type) const { return types == (1u << TypeSlot(type)); }
+    bool MayHaveSource(SourceId id) const { return (sources[id % ZoneSourceBits / 64] >> (id % 64)) & 1; }
+
+    bool InsideRange(double fromSec, double toSec) const { return minTime >= fromSec && maxTime < toSec; }
+    bool OutsideRange(double fromSec, double toSec) const { return maxTime < fromSec || minTime >= toSec; }
+
+    Totals TotalsOf(std::optional<EventType> type) const
+    {
+        if (type)
+        {
+            return byType[TypeSlot(*type)];
+        }
+        Totals totals{};
+        for (const Totals& part : byType)
+        {
+            totals.Merge(part);
+        }
+        return totals;
+    }
+};
+static_assert(std::is_trivially_copyable_v<Zone>, "zones are written to disk as they are (WriteZoneMap)");
+
+class ZoneMap
+{
+public:
+    ZoneMap() = default;
+    explicit ZoneMap(const EventColumnStore& store) { Update(store); }
+
+    // Summarizes the rows appended since the last call: the last, partial zone is redone. A new epoch starts over.
+    void Update(const EventColumnStore& store)
+    {
+        if (epoch != store.Epoch() || rows > store.Size())
+        {
+            zones.clear();
+            rows = 0;
+            epoch = store.Epoch();
+        }
+        if (!zones.empty() && zones.back().rows < ZoneRows)
+        {
+            rows -= zones.back().rows;
+            zones.pop_back();
+        }
+        ESP_TIME_OPERATION("zone_map_build", store.Size() - rows);
+        for (std::size_t first = rows; first < store.Size(); first += ZoneRows)
+        {
+            zones.push_back(Summarize(store, first, std::min(store.Size(), first + ZoneRows)));
+        }
+        rows = store.Size();
+    }
+
+    // Rows [0, Rows()) are summarized; queries scan anything after.
+    std::size_t Rows() const { return rows; }
+    std::uint64_t Epoch() const { return epoch; }
+    std::span<const Zone> Zones() const { return zones; }
+
+    // An empty map fits every store (everything is scanned); otherwise only the store it was built on.
+    bool Fits(const EventColumnStore& store) const { return zones.empty() || (epoch == store.Epoch() && rows <= store.Size()); }
+
+    // For LoadZoneMap: zones read from disk, taken as a summary of store.
+    static ZoneMap Adopt(std::vector<Zone> zones, const EventColumnStore& store)
+    {
+        ZoneMap map{};
+        map.rows = zones.empty() ? 0 : static_cast<std::size_t>(zones.back().firstRow) + zones.back().rows;
+        map.zones = std::move(zones);
+        map.epoch = store.Epoch();
+        return map;
+    }
+
+private:
+    static Zone Summarize(const EventColumnStore& store, std::size_t begin, std::size_t end)
+    {
+        auto timestamps = store.Timestamps().subspan(begin, end - begin);
+        auto types = store.Types().subspan(begin, end - begin);
+        auto sourceIds = store.SourceIds().subspan(begin, end - begin);
+        auto values = store.Values().subspan(begin, end - begin);
+
+        Zone zone{};
+        zone.firstRow = static_cast<EventIndex>(begin);
+        zone.rows = static_cast<EventIndex>(end - begin);
+        const auto [minTime, maxTime] = std::ranges::minmax(timestamps);
+        const bool unordered = std::ranges::any_of(timestamps, [](double t) { return std::isnan(t); });
+        zone.minTime = unordered ? std::numeric_limits<double>::quiet_NaN() : minTime;
+        zone.maxTime = unordered ? std::numeric_limits<double>::quiet_NaN() : maxTime;
+        for (std::size_t row = 0; row < values.size(); ++row)
+        {
+            const std::size_t slot = TypeSlot(types[row]);
+            zone.types |= static_cast<std::uint8_t>(1u << slot);
+            zone.sources[sourceIds[row] % ZoneSourceBits / 64] |= std::uint64_t{ 1 } << (sourceIds[row] % 64);
+            zone.byType[slot].AddIf(true, values[row]);
+        }
+        return zone;
+    }
+
+    std::vector<Zone> zones{};
+    std::size_t rows{};
+    std::uint64_t epoch{};
+};
+
+// ** Pushdown **
+
+enum class ZoneMatch : std::uint8_t
+{
+    None,       // no row of the zone can match: skipped
+    Some,       // scanned
+    All         // every row passes the type and time filters (a source filter still needs a scan)
+};
+
+inline ZoneMatch MatchZone(const Zone& zone, const QuerySpec& spec)
+{
+    const bool byTime = spec.fromSec || spec.toSec;
+    const double fromSec = spec.fromSec.value_or(-std::numeric_limits<double>::infinity());
+    const double toSec = spec.toSec.value_or(std::numeric_limits<double>::infinity());
+    if ((spec.type && !zone.HasType(*spec.type)) || (spec.source && !zone.MayHaveSource(*spec.source)) || (byTime && zone.OutsideRange(fromSec, toSec)))
+    {
+        return ZoneMatch::None;
+    }
+    const bool allTypes = !spec.type || zone.OnlyType(*spec.type);
+    const bool allTimes = !byTime || zone.InsideRange(fromSec, toSec);
+    return allTypes && allTimes ? ZoneMatch::All : ZoneMatch::Some;
+}
+
+// Rows [begin, end) of store as a store of their own (row 0 is begin), without copying.
+inline EventColumnStore ZoneSlice(const EventColumnStore& store, std::size_t begin, std::size_t end)
+{
+    return EventColumnStore::Borrow({}, store.Timestamps().subspan(begin, end - begin), store.Types().subspan(begin, end - begin),
+        store.SourceIds().subspan(begin, end - begin), store.Values().subspan(begin, end - begin), store.SharedSources());
+}
+
+inline void CheckZoneMap(const EventColumnStore& store, const ZoneMap& zones, const char* caller)
+{
+    if (!zones.Fits(store))
+    {
+        throw std::invalid_argument(std::string{ caller } + ": the zone map was built for another store (or epoch)");
+    }
+}
+
+// Same answer as RunQueryTotals(store, spec), sums up to rounding. Zones inside the time range are answered from their
+// per-type totals unless a source filter asks for a scan.
+inline Totals RunQueryTotals(const EventColumnStore& store, const ZoneMap& zones, const QuerySpec& spec)
+{
+    CheckZoneMap(store, zones, "RunQueryTotals");
+    ESP_TIME_OPERATION("zone_query", store.Size());
+    const bool byTime = spec.fromSec || spec.toSec;
+    const double fromSec = spec.fromSec.value_or(-std::numeric_limits<double>::infinity());
+    const double toSec = spec.toSec.value_or(std::numeric_limits<double>::infinity());
+    Totals totals{};
+    for (const Zone& zone : zones.Zones())
+    {
+        const ZoneMatch match = MatchZone(zone, spec);
+        if (match != ZoneMatch::None && !spec.source && (!byTime || zone.InsideRange(fromSec, toSec)))
+        {
+            totals.Merge(zone.TotalsOf(spec.type));// per-type totals: other types in the zone do not matter
+        }
+        else if (match != ZoneMatch::None)
+        {
+            totals.Merge(RunQueryTotals(ZoneSlice(store, zone.firstRow, zone.firstRow + zone.rows), spec));
+        }
+    }
+    totals.Merge(RunQueryTotals(store, spec, zones.Rows()));
+    return totals;
+}
+
+inline double RunQuery(const EventColumnStore& store, const ZoneMap& zones, const QuerySpec& spec)
+{
+    return RunQueryTotals(store, zones, spec).Of(spec.aggregate);
+}
+
+// Same rows as RunSelect(store, spec), in row order.
+inline std::vector<EventIndex> RunSelect(const EventColumnStore& store, const ZoneMap& zones, const QuerySpec& spec)
+{
+    CheckZoneMap(store, zones, "RunSelect");
+    ESP_TIME_OPERATION("zone_select", store.Size());
+    std::vector<EventIndex> selection{};
+    for (const Zone& zone : zones.Zones())
+    {
+        const ZoneMatch match = MatchZone(zone, spec);
+        const std::size_t begin = selection.size();
+        if (match == ZoneMatch::All && !spec.source)
+        {
+            selection.resize(begin + zone.rows);
+            std::iota(selection.begin() + static_cast<std::ptrdiff_t>(begin), selection.end(), zone.firstRow);
+        }
+        else if (match != ZoneMatch::None)
+        {
+            RunSelectFrom(ZoneSlice(store, zone.firstRow, zone.firstRow + zone.rows), spec, 0, selection);
+            for (std::size_t at = begin; at < selection.size(); ++at)
+            {
+                selection[at] += zone.firstRow;
+            }
+        }
+    }
+    RunSelectFrom(store, spec, zones.Rows(), selection);
+    return selection;
+}
+
+inline std::vector<EventIndex> SelectByType(const EventColumnStore& store, const ZoneMap& zones, EventType typeToFilter)
+{
+    return RunSelect(store, zones, { QueryAggregate::Count, typeToFilter });
+}
+
+inline std::vector<EventIndex> SelectBySource(const EventColumnStore& store, const ZoneMap& zones, SourceId source)
+{
+    return RunSelect(store, zones, { QueryAggregate::Count, {}, source });
+}
+
+inline EventColumnStore FilterByType(const EventColumnStore& store, const ZoneMap& zones, EventType typeToFilter)
+{
+    return store.Gather(SelectByType(store, zones, typeToFilter));
+}
+
+// Same row as FirstEventAfter(store, thresholdTime); zones that end at or before the threshold are never read.
+inline std::optional<EventIndex> FirstEventAfter(const EventColumnStore& store, const ZoneMap& zones, double thresholdTime)
+{
+    CheckZoneMap(store, zones, "FirstEventAfter");
+    ESP_TIME_OPERATION("zone_first_event_after", 0);
+    auto timestamps = store.Timestamps();
+    const auto after = [thresholdTime](double t) { return t > thresholdTime; };
+    for (const Zone& zone : zones.Zones())
+    {
+        if (zone.maxTime <= thresholdTime)
+        {
+            continue;
+        }
+        auto zoneRows = timestamps.subspan(zone.firstRow, zone.rows);
+        auto it = std::ranges::find_if(zoneRows, after);
+        if (it != zoneRows.end())
+        {
+            return static_cast<EventIndex>(zone.firstRow + (it - zoneRows.begin()));
+        }
+    }
+    auto tail = timestamps.subspan(zones.Rows());
+    auto it = std::ranges::find_if(tail, after);
+    return it != tail.end() ? std::optional<EventIndex>{ static_cast<EventIndex>(zones.Rows() + (it - tail.begin())) } : std::nullopt;
+}
+
+// ** Files **
+// A zone map saved next to its log: ZoneMapHeader, then zoneCount Zone records as they are in memory.
+
+inline constexpr char ZoneMapMagic[8] = { 'E', 'S', 'P', 'Z', 'O', 'N', 'E', 'S' };
+inline constexpr std::uint32_t ZoneMapVersion = 2;// 2: the log fingerprint
+
+struct ZoneMapHeader
+{
+    char magic[8]{};
+    std::uint32_t version{};
+    std::uint32_t zoneBytes{};          // sizeof(Zone), so a layout change is caught
+    std::uint64_t zoneRows{};
+    std::uint64_t sourceBits{};
+    std::uint64_t eventCount{};
+    std::uint64_t zoneCount{};
+    std::uint64_t fingerprint{};        // ZoneMapFingerprint of the log the map was built on
+};
+static_assert(sizeof(ZoneMapHeader) == 56, "ZoneMapHeader is an on-disk format, keep it packed");
+
+// FNV-1a of the first rows events of store as a map sees them: the row count, every source name, and the first and
+// last row of each zone (time, type, source, value bits). It reads O(zones) rows, so checking it pages in a few pages
+// per zone, not the log. A log rewritten, copied over or regenerated with other events changes it; an edit strictly
+// inside a zone that keeps the zone's edge rows does not.
+inline std::uint64_t ZoneMapFingerprint(const EventColumnStore& store, std::size_t rows)
+{
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    auto mix = [&hash](const void* data, std::size_t size)
+    {
+        for (std::size_t at = 0; at < size; ++at)
+        {
+            hash = (hash ^ static_cast<const unsigned char*>(data)[at]) * 0x100000001b3ull;
+        }
+    };
+    const std::uint64_t count = rows;
+    mix(&count, sizeof(count));
+    for (const std::string& name : store.Sources().Names())
+    {
+        const std::uint64_t size = name.size();
+        mix(&size, sizeof(size));
+        mix(name.data(), name.size());
+    }
+    auto timestamps = store.Timestamps();
+    auto types = store.Types();
+    auto sourceIds = store.SourceIds();
+    auto values = store.Values();
+    auto mixRow = [&](std::size_t row)
+    {
+        mix(&timestamps[row], sizeof(double));
+        mix(&types[row], sizeof(EventType));
+        mix(&sourceIds[row], sizeof(SourceId));
+        mix(&values[row], sizeof(double));
+    };
+    for (std::size_t first = 0; first < rows; first += ZoneRows)
+    {
+        mixRow(first);
+        mixRow(std::min(rows, first + ZoneRows) - 1);
+    }
+    return hash;
+}
+
+inline std::filesystem::path ZoneMapPath(const std::filesystem::path& logPath)
+{
+    std::filesystem::path path = logPath;
+    return path += ".zones";
+}
+
+// store: the store zones was built on, fingerprinted so LoadZoneMap can tell its log from any other.
+inline void WriteZoneMap(const ZoneMap& zones, const EventColumnStore& store, const std::filesystem::path& path)
+{
+    if (!zones.Fits(store))
+    {
+        throw std::invalid_argument("WriteZoneMap: the zone map was not built on this store");
+    }
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        throw std::runtime_error("WriteZoneMap: cannot create " + path.string());
+    }
+    ZoneMapHeader header{};
+    std::memcpy(header.magic, ZoneMapMagic, sizeof(header.magic));
+    header.version = ZoneMapVersion;
+    header.zoneBytes = sizeof(Zone);
+    header.zoneRows = ZoneRows;
+    header.sourceBits = ZoneSourceBits;
+    header.eventCount = zones.Rows();
+    header.zoneCount = zones.Zones().size();
+    header.fingerprint = ZoneMapFingerprint(store, zones.Rows());
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(zones.Zones().data()), static_cast<std::streamsize>(zones.Zones().size_bytes()));
+    if (!file)
+    {
+        throw std::runtime_error("WriteZoneMap: write failed for " + path.string());
+    }
+}
+
+// Reads a map written by WriteZoneMap for store, e.g. the log just loaded with LoadBinaryEventLog. A map saved for
+// another log (another size, dictionary or ZoneMapFingerprint) throws rather than skip blocks by the wrong summaries.
+inline ZoneMap LoadZoneMap(const std::filesystem::path& path, const EventColumnStore& store)
+{
+    auto fail = [&path](const char* why) { return std::runtime_error("LoadZoneMap: " + path.string() + ": " + why); };
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        throw fail("cannot open");
+    }
+    ZoneMapHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, ZoneMapMagic, sizeof(header.magic)) != 0)
+    {
+        throw fail("not a zone map");
+    }
+    if (header.version != ZoneMapVersion || header.zoneBytes != sizeof(Zone) || header.zoneRows != ZoneRows || header.sourceBits != ZoneSourceBits)
+    {
+        throw fail("unsupported version");
+    }
+    if (header.eventCount != store.Size() || header.zoneCount != (header.eventCount + ZoneRows - 1) / ZoneRows
+        || header.fingerprint != ZoneMapFingerprint(store, store.Size()))
+    {
+        throw fail("does not match the log");
+    }
+    std::vector<Zone> zones(static_cast<std::size_t>(header.zoneCount));
+    if (!file.read(reinterpret_cast<char*>(zones.data()), static_cast<std::streamsize>(zones.size() * sizeof(Zone))))
+    {
+        throw fail("truncated file");
+    }
+    for (std::size_t index = 0; index < zones.size(); ++index)
+    {
+        const std::uint64_t first = index * ZoneRows;
+        if (zones[index].firstRow != first || zones[index].rows != std::min<std::uint64_t>(ZoneRows, header.eventCount - first))
+        {
+            throw fail("corrupt zone rows");
+        }
+    }
+    return ZoneMap::Adopt(std::move(zones), store);
+}